@@ -8,7 +8,7 @@ any_rule::any_rule() : name( "identity_rule_default" ) {
     rule_ptr = f; 
 }
 
-void any_rule::operator () ( CA< ucolor >& ca ) {
+void any_rule::operator () ( CA_tile< ucolor >& ca ) {
     rule( ca );
 }
 
@@ -38,6 +38,7 @@ typedef enum CA_hood  {  HOOD_MOORE,
 struct element_context;
 
 template< class T > struct CA;
+template< class T > struct CA_tile;
 
 template < class T > struct rule_identity;
 template < class T > struct rule_life;
@@ -67,7 +68,7 @@ typedef std::variant <
 
 // only works for ucolor at this point
 struct any_rule {
-    typedef std::function< void ( CA< ucolor >& ) > CA_rule;
+    typedef std::function< void ( CA_tile< ucolor >& ) > CA_rule;
     typedef std::function< CA_hood ( element_context& ) > CA_initializer;
 
     any_rule_ptr rule_ptr;
@@ -75,7 +76,7 @@ struct any_rule {
     CA_initializer initializer;
     std::string name;
 
-    void operator () ( CA< ucolor >& ca );  // call the rule
+    void operator () ( CA_tile< ucolor >& ca );  // call the rule
     CA_hood init( element_context& context );  // call the initializer
 
     any_rule();
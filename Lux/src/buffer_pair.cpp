@@ -1,4 +1,6 @@
 #include "buffer_pair.hpp"
+#include "joy_log.hpp"
+#include <stdexcept>
 
 template< class T > buffer_pair< T >::buffer_pair() {
     image_pair.first = NULL;
@@ -38,6 +40,7 @@ template< class T > bool buffer_pair< T >::is_swapped() {
 }
 
 template< class T > image< T >& buffer_pair< T >::get_image() {
+    version++;
     return *image_pair.first;
 }
 
@@ -46,68 +49,87 @@ template< class T > const image< T >& buffer_pair< T >::get_image() const {
 }
 
 template< class T > std::unique_ptr< image< T > >& buffer_pair< T >::get_image_ptr() { 
+    version++;
     return image_pair.first; 
 }
 
+template< class T > void buffer_pair< T >::invalidate_buffer() {
+    stale = true;
+    generation++;
+}
+
 template< class T > image< T >& buffer_pair< T >::get_buffer() {
-    if( image_pair.second.get() == NULL ) image_pair.second.reset( new image< T >( *image_pair.first ) );
-    return *image_pair.second;
+    return *get_buffer_ptr();
 }
 
 template< class T > std::unique_ptr< image< T > >& buffer_pair< T >::get_buffer_ptr() { 
-    if( image_pair.second.get() == NULL ) image_pair.second.reset( new image< T >( *image_pair.first ) );
+    if( image_pair.first.get() == NULL ) throw std::runtime_error( "buffer_pair::get_buffer(): no image in buffer" );
+    if( image_pair.second.get() == NULL ) {
+        image_pair.second.reset( new image< T >( *image_pair.first ) );
+        generation++;
+    }
+    else if( stale ) image_pair.second->copy( *image_pair.first );
+    stale = false;
     return image_pair.second; 
 }
 
+// A back buffer not made yet or stale would be a copy of the image - swapping the two changes nothing,
+// so neither is touched and the next get_buffer() makes or refreshes it
 template< class T > void buffer_pair< T >::swap() { 
-    image_pair.first.swap( image_pair.second ); 
+    if( image_pair.first.get() == NULL || ( image_pair.second.get() != NULL && !stale ) ) image_pair.first.swap( image_pair.second ); 
     swapped = !swapped;
+    version++;
 }
 
 template< class T > void buffer_pair< T >::reset( const image< T >& img ) { 
-    image_pair.first.reset( new image< T >( img ) );
-    image_pair.second.reset( NULL );
+    if( image_pair.first.get() == NULL ) {
+        image_pair.first.reset( new image< T >( img ) );
+        invalidate_buffer();
+    }
+    else {
+        bool resized = image_pair.first->get_dim() != img.get_dim();
+        image_pair.first->copy( img );
+        stale = true;
+        if( resized ) invalidate_buffer();
+    }
     swapped = false;
+    version++;
 }
 
+// Same size keeps the memory of both images - the image is blanked as if new
 template< class T > void buffer_pair< T >::reset( vec2i dim ) {
-    // Code in here is problematic and has been causing segfaults
-    //if( image_pair.first.get() == NULL || image_pair.first->get_dim() != dim ) {
-        std::cout << "buffer_pair::reset() " << dim.x << " " << dim.y << std::endl;
+    JOY_LOG( JOY_DEBUG, LOG_BUFFER, "buffer_pair::reset() " << dim.x << " " << dim.y );
+    if( image_pair.first.get() != NULL && image_pair.first->get_dim() == dim ) {
+        image_pair.first->blank();
+        stale = true;
+    }
+    else {
         image_pair.first.reset( new image< T >( dim ) );
-        image_pair.second.reset( NULL );
-        swapped = false;
-    //}
+        invalidate_buffer();
+    }
+    swapped = false;
+    version++;
 }
 
 template< class T > void buffer_pair< T >::copy_first( const buffer_pair<T>& bp ) { 
-    //std::cout << "buffer_pair::copy_first()" << std::endl;
-    if( bp.image_pair.first.get()  != NULL ) {
-        //std::cout << "buffer_pair::copy_first() - source pointer not NULL" << std::endl;
-        if( image_pair.first.get() == NULL ) {
-            //std::cout << "buffer_pair::copy_first() - dest pointer NULL" << std::endl;
-            image_pair.first = std::make_unique< image< T > >( *bp.image_pair.first );
-        }
-        else {
-            //std::cout << "buffer_pair::copy_first() - dest pointer not NULL" << std::endl;
-            image_pair.first->copy( *bp.image_pair.first );
+    if( bp.image_pair.first.get() == NULL ) {
+        if( image_pair.first.get() != NULL ) {
+            image_pair.first.reset( NULL );
             image_pair.second.reset( NULL );
+            invalidate_buffer();
         }
     }
-    else {
-        //std::cout << "buffer_pair::copy_first() - source pointer NULL" << std::endl;
-        image_pair.first.reset( NULL );
+    else if( image_pair.first.get() == NULL ) {
+        image_pair.first = std::make_unique< image< T > >( *bp.image_pair.first );
+        invalidate_buffer();
     }
-    /*auto first_dim = image_pair.first->get_dim();
-    std::cout << "buffer_pair::copy_first() result: (" << first_dim.x << " " << first_dim.y << "),";
-    if(image_pair.second) {
-        auto second_dim = image_pair.second->get_dim();
-        std::cout << "(" << second_dim.x << " " << second_dim.y << ")" << std::endl;
+    else {
+        bool resized = image_pair.first->get_dim() != bp.image_pair.first->get_dim();
+        image_pair.first->copy( *bp.image_pair.first );
+        stale = true;
+        if( resized ) invalidate_buffer();
     }
-    else { 
-        std::cout << "NULL" << std::endl; 
-    }*/
-   image_pair.second.reset( NULL );
+    version++;
 }
 
 template< class T > image< T >& buffer_pair< T >::operator () () {
@@ -6,11 +6,21 @@
 // Used for double-buffered rendering. Owns pointer to image - makes a duplicate when 
 // double-buffering is needed for an effect. Can be used in effect lists or for 
 // persistent effects such as CA, melt, or hyperspace
+// reset() and copy_first() keep both images when they can - the back buffer is marked stale
+// and refreshed from the image by the next get_buffer(). The generation changes whenever an
+// image is replaced or changes size, so anything sized to or pointing at the images can tell.
+// The version changes whenever the image may have been written - non-const get_image(), swap(),
+// reset() or copy_first() - so a reader keeping something built from the image can tell too.
 
 template< class T > class buffer_pair {
     typedef std::unique_ptr< image< T > > image_ptr;
     std::pair< image_ptr, image_ptr > image_pair;
     bool swapped = false;
+    bool stale = false;             // back buffer holds old pixels
+    unsigned int generation = 0;
+    unsigned int version = 0;
+
+    void invalidate_buffer();       // after the image is replaced or resized
 public:
     buffer_pair();
     buffer_pair( const std::string& filename );
@@ -20,12 +30,14 @@ public:
 
     bool has_image();
     bool is_swapped();
+    unsigned int get_generation() const { return generation; }
+    unsigned int get_version() const { return version; }
     image< T >& get_image();
     const image< T >& get_image() const;
     std::unique_ptr< image< T > >& get_image_ptr();
     image< T >& get_buffer();                   // get buffer, create if necessary
     std::unique_ptr< image< T > >& get_buffer_ptr();
-    void swap();                                // swap image and buffer
+    void swap();                                // swap image and buffer - no copy if the buffer is missing or stale
 
     /*
     void load( const std::string& filename ) { 
@@ -34,7 +46,7 @@ public:
     } */
 
     void reset( const image< T >& img );
-    void reset( vec2i dim );
+    void reset( vec2i dim );                    // cleared image of size dim
 
 /*
     void set( const image< T >& img ) { 
@@ -3,31 +3,63 @@
 #include "fimage.hpp"
 #include <memory>
 #include "image_loader.hpp"
+#include "frgb_simd.hpp"
+#include "joy_thread.hpp"
+
+// Kernels run over bands of rows of the base image. fk_map() takes vector and scalar forms of each operation
+static auto v_add = []( auto a, auto b ) { return mf_add( a, b ); };
+static auto v_sub = []( auto a, auto b ) { return mf_sub( a, b ); };
+static auto v_mul = []( auto a, auto b ) { return mf_mul( a, b ); };
+static auto v_div = []( auto a, auto b ) { return mf_div( a, b ); };
+static auto s_add = []( float a, float b ) { return a + b; };
+static auto s_sub = []( float a, float b ) { return a - b; };
+static auto s_mul = []( float a, float b ) { return a * b; };
+static auto s_div = []( float a, float b ) { return a / b; };
+
+// f( first pixel, pixel count ) for each band
+template< class F > static void in_bands( const vec2i& dim, F&& f ) {
+    parallel_rows( dim.y, dim.x, [ & ]( int y0, int y1 ) { f( (size_t)y0 * dim.x, (size_t)( y1 - y0 ) * dim.x ); } );
+}
+
+// a op= b pixel by pixel
+template< class V, class S > static void map_image( frgb* a, const frgb* b, const vec2i& dim, V vop, S sop ) {
+    in_bands( dim, [ & ]( size_t i, size_t n ) { fk_map( &a[ i ].x, &b[ i ].x, n * 3, vop, sop ); } );
+}
+
+// a op= c for every pixel
+template< class V, class S > static void map_pixel( frgb* a, const frgb& c, const vec2i& dim, V vop, S sop ) {
+    in_bands( dim, [ & ]( size_t i, size_t n ) { fk_map( a + i, c, n, vop, sop ); } );
+}
+
+// a = op( a ) for every float
+template< class V, class S > static void map_floats( frgb* a, const vec2i& dim, V vop, S sop ) {
+    in_bands( dim, [ & ]( size_t i, size_t n ) { fk_map( &a[ i ].x, n * 3, vop, sop ); } );
+}
 
 // pixel modification functions
 
 template<> void fimage::clamp( float minc, float maxc ) {
-    auto& base = mip[ 0 ];
     mip_utd = false;
-    for( auto& c : base ) { linalg::clamp( c, minc, maxc ); }
+    map_floats( mip[ 0 ].data(), dim,
+        [ minc, maxc ]( auto a ) { return mf_min( mf_max( a, mf_set1( minc ) ), mf_set1( maxc ) ); },
+        [ minc, maxc ]( float a ) { return a < minc ? minc : a < maxc ? a : maxc; } );
 }
 
 template<> void fimage::constrain() {
-    auto& base = mip[ 0 ];
+    frgb* base = mip[ 0 ].data();
     mip_utd = false;
-    for( auto& c : base ) { ::constrain( c ); }
+    in_bands( dim, [ & ]( size_t i, size_t n ) { fk_constrain( base + i, n ); } );
 }
 
 template<> void fimage::grayscale() {
-    auto& base = mip[ 0 ];
+    frgb* base = mip[ 0 ].data();
     mip_utd = false;
-    for( auto& c : base ) { c = gray( c ); }
+    in_bands( dim, [ & ]( size_t i, size_t n ) { fk_gray( base + i, n ); } );
 }
 
 template<> void fimage::invert() {
-    auto& base = mip[ 0 ];
     mip_utd = false;
-    for( auto& c : base ) { ::invert( c ); }
+    map_floats( mip[ 0 ].data(), dim, []( auto a ) { return mf_sub( mf_set1( 1.0f ), a ); }, []( float a ) { return 1.0f - a; } );
 }
 
 template<> void fimage::rotate_components( const int& r ) {
@@ -61,6 +93,29 @@ template<> void fimage::rotate_hue( const float& h ) {
     //mip_it();
 }
 
+template<> fimage& fimage::operator += ( fimage& rhs )      { map_image( mip[ 0 ].data(), std::as_const( rhs.mip )[ 0 ].data(), dim, v_add, s_add ); mip_utd = false; return *this; }
+template<> fimage& fimage::operator += ( const frgb& rhs ) { map_pixel( mip[ 0 ].data(), rhs, dim, v_add, s_add );                 mip_utd = false; return *this; }
+template<> fimage& fimage::operator -= ( fimage& rhs )      { map_image( mip[ 0 ].data(), std::as_const( rhs.mip )[ 0 ].data(), dim, v_sub, s_sub ); mip_utd = false; return *this; }
+template<> fimage& fimage::operator -= ( const frgb& rhs ) { map_pixel( mip[ 0 ].data(), rhs, dim, v_sub, s_sub );                 mip_utd = false; return *this; }
+template<> fimage& fimage::operator *= ( fimage& rhs )      { map_image( mip[ 0 ].data(), std::as_const( rhs.mip )[ 0 ].data(), dim, v_mul, s_mul ); mip_utd = false; return *this; }
+template<> fimage& fimage::operator *= ( const frgb& rhs ) { map_pixel( mip[ 0 ].data(), rhs, dim, v_mul, s_mul );                 mip_utd = false; return *this; }
+template<> fimage& fimage::operator /= ( fimage& rhs )      { map_image( mip[ 0 ].data(), std::as_const( rhs.mip )[ 0 ].data(), dim, v_div, s_div ); mip_utd = false; return *this; }
+template<> fimage& fimage::operator /= ( const frgb& rhs ) { map_pixel( mip[ 0 ].data(), rhs, dim, v_div, s_div );                 mip_utd = false; return *this; }
+
+template<> fimage& fimage::operator *= ( const float& rhs ) {
+    float s = rhs;
+    map_floats( mip[ 0 ].data(), dim, [ s ]( auto a ) { return mf_mul( a, mf_set1( s ) ); }, [ s ]( float a ) { return a * s; } );
+    mip_utd = false;
+    return *this;
+}
+
+template<> fimage& fimage::operator /= ( const float& rhs ) {
+    float s = rhs;
+    map_floats( mip[ 0 ].data(), dim, [ s ]( auto a ) { return mf_div( a, mf_set1( s ) ); }, [ s ]( float a ) { return a / s; } );
+    mip_utd = false;
+    return *this;
+}
+
 template<> void fimage::load( const std::string& filename ) {
     //std::cout << "fimage::load " << filename << std::endl;
     reset();
@@ -69,9 +124,15 @@ template<> void fimage::load( const std::string& filename ) {
     refresh_bounds();
 	int c = 0;
     frgb f;
+    mip.resize( dim );
     auto& base = mip[ 0 ];    
+    size_t i = 0;
 
-    for (auto it = std::begin (loader.img); it <= std::end (loader.img); ) {
+    if( loader.channels == 3 ) {
+        frgb_from_bytes( base.data(), loader.img.data(), base.size() );
+        return;
+    }
+    for (auto it = std::begin (loader.img); it < std::end (loader.img); ) {
         if( loader.channels == 1 )	// monochrome image
         {
             setrc( f, *it );
@@ -100,34 +161,22 @@ template<> void fimage::load( const std::string& filename ) {
             it++;
         }
 
-        base.push_back( f );
+        base[ i++ ] = f;
     }
     //mip_it();
     //std::cout << "Image load complete\n";
 }
 
 template<> void fimage::write_jpg( const std::string& filename, int quality, int level ) {
-    std::vector< unsigned char > img;
-    img.reserve( dim.x * dim.y * 3 );
-    auto& pixels = mip[ level ];
-
-    for( auto& f : pixels ) {
-        img.push_back( rc( f ) );
-        img.push_back( gc( f ) );
-        img.push_back( bc( f ) ); 
-    }
-    wrapped_write_jpg( filename.c_str(), mip_dim[level].x, mip_dim[level].y, 3, img.data(), quality );
+    const auto& pixels = std::as_const( mip )[ level ];
+    std::vector< unsigned char > img( pixels.size() * 3 );
+    frgb_to_bytes( img.data(), pixels.data(), pixels.size() );
+    wrapped_write_jpg( filename.c_str(), mip.dim( level ).x, mip.dim( level ).y, 3, img.data(), quality );
 }
 
 template<> void fimage::write_png( const std::string& filename, int level ) {    
-    std::vector< unsigned char > img;
-    img.reserve( dim.x * dim.y * 3 );
-    auto& pixels = mip[ level ];
-
-    for( auto& f : pixels ) {
-        img.push_back( rc( f ) );
-        img.push_back( gc( f ) );
-        img.push_back( bc( f ) ); 
-    }
-	wrapped_write_png( filename.c_str(), mip_dim[level].x, mip_dim[level].y, 3, img.data() );
+    const auto& pixels = std::as_const( mip )[ level ];
+    std::vector< unsigned char > img( pixels.size() * 3 );
+    frgb_to_bytes( img.data(), pixels.data(), pixels.size() );
+	wrapped_write_png( filename.c_str(), mip.dim( level ).x, mip.dim( level ).y, 3, img.data() );
 }
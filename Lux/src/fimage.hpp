@@ -17,6 +17,18 @@ template<> void fimage::rgb_to_hsv();
 template<> void fimage::hsv_to_rgb();
 template<> void fimage::rotate_hue( const float& h );
 
+// arithmetic over the interleaved floats of the base image - vector kernels in frgb_simd.hpp
+template<> fimage& fimage::operator += ( fimage& rhs );
+template<> fimage& fimage::operator += ( const frgb& rhs );
+template<> fimage& fimage::operator -= ( fimage& rhs );
+template<> fimage& fimage::operator -= ( const frgb& rhs );
+template<> fimage& fimage::operator *= ( fimage& rhs );
+template<> fimage& fimage::operator *= ( const frgb& rhs );
+template<> fimage& fimage::operator *= ( const float& rhs );
+template<> fimage& fimage::operator /= ( fimage& rhs );
+template<> fimage& fimage::operator /= ( const frgb& rhs );
+template<> fimage& fimage::operator /= ( const float& rhs );
+
 // I/O functions using template specialization
 template<> void fimage::load( const std::string& filename );
 template<> void fimage::write_jpg( const std :: string& filename, int quality, int level );
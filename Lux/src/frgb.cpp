@@ -3,6 +3,7 @@
 
 #include "frgb.hpp"
 #include "gamma_lut.hpp"
+#include <algorithm>
 
 static gamma_LUT glut( 2.2f );
 
@@ -47,6 +48,36 @@ frgb fsetu( const unsigned int& u ) {
              glut.SRGB_to_linear( (unsigned char)(   u & 0x000000ff ) ) };
 }
 
+// Spans go through the tables in blocks of SRGB bytes
+static const size_t convert_block = 256;
+
+void frgb_from_ucolor( frgb* out, const unsigned int* in, size_t n ) {
+    unsigned char bytes[ convert_block * 3 ];
+    for( size_t i = 0; i < n; i += convert_block ) {
+        size_t m = std::min( convert_block, n - i );
+        for( size_t j = 0; j < m; j++ ) {
+            bytes[ j * 3     ] = (unsigned char)( in[ i + j ] >> 16 );
+            bytes[ j * 3 + 1 ] = (unsigned char)( in[ i + j ] >> 8 );
+            bytes[ j * 3 + 2 ] = (unsigned char)( in[ i + j ] );
+        }
+        frgb_from_bytes( out + i, bytes, m );
+    }
+}
+
+void frgb_to_ucolor( unsigned int* out, const frgb* in, size_t n ) {
+    unsigned char bytes[ convert_block * 3 ];
+    for( size_t i = 0; i < n; i += convert_block ) {
+        size_t m = std::min( convert_block, n - i );
+        frgb_to_bytes( bytes, in + i, m );
+        for( size_t j = 0; j < m; j++ ) {
+            out[ i + j ] = 0xff000000 | ( bytes[ j * 3 ] << 16 ) | ( bytes[ j * 3 + 1 ] << 8 ) | bytes[ j * 3 + 2 ];
+        }
+    }
+}
+
+void frgb_from_bytes( frgb* out, const unsigned char* in, size_t n ) { glut.SRGB_to_linear( in, &out[ 0 ].x, n * 3 ); }
+void frgb_to_bytes( unsigned char* out, const frgb* in, size_t n )   { glut.linear_to_SRGB( &in[ 0 ].x, out, n * 3 ); }
+
 //void setul( unsigned int in ) {} // bit shifty stuff
 
 // Clip to range [ 0.0, 1.0 ] but keep colors in proportion
@@ -55,7 +86,7 @@ void constrain( frgb &c ) {
     float maxc = linalg::maxelem( c );
     if( maxc > 1.0f ) {
         // bring negative colors to 
-        linalg::clamp( c, 0.0f, maxc );
+        c = linalg::clamp( c, 0.0f, maxc );
         // if max color > 1.0 divide all colors by max
         c /= maxc;
     }
@@ -5,6 +5,7 @@
 #define __FRGB_HPP
 
 #include <iostream>
+#include <cstddef>
 #include "linalg.h"
 #include "mask_mode.hpp"
 
@@ -50,6 +51,12 @@ frgb fsetc(          const unsigned char& r, const unsigned char& g, const unsig
 void setu( frgb &c, const unsigned int &uc );
 frgb fsetu( const unsigned int &c );
 
+// convert spans of n pixels - ucolor as unsigned int with alpha set, or three SRGB bytes per pixel
+void frgb_from_ucolor( frgb* out, const unsigned int* in, size_t n );
+void frgb_to_ucolor( unsigned int* out, const frgb* in, size_t n );
+void frgb_from_bytes( frgb* out, const unsigned char* in, size_t n );
+void frgb_to_bytes( unsigned char* out, const frgb* in, size_t n );
+
 // I/O operators
 //std::ostream &operator << ( std::ostream &out, const frgb& f );
 void print_SRGB( const frgb &c );
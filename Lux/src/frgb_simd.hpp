@@ -0,0 +1,108 @@
+// Vector kernels for frgb images - spans of pixels as their interleaved floats
+// Channel by channel arithmetic runs over the floats directly, four lanes at a time. A pixel
+// constant repeats every three floats, so three registers hold it for four pixels. Gray and
+// constrain need whole pixels - four at a time are transposed into red, green and blue registers
+// and back. Registers from mip_simd.hpp; without SSE2 or wasm simd128 only the scalar loops run.
+
+#ifndef __FRGB_SIMD_HPP
+#define __FRGB_SIMD_HPP
+
+#include "mip_simd.hpp"
+#include <cstddef>
+
+#ifdef MIP_SIMD
+// Four pixels r0 g0 b0 r1 | g1 b1 r2 g2 | b2 r3 g3 b3 in a, b, c to one register per channel
+static inline void mf_planar( vec4f a, vec4f b, vec4f c, vec4f& r, vec4f& g, vec4f& bl ) {
+    vec4f t = mf_shuffle< 2, 3, 1, 2 >( b, c );    // r2 g2 r3 g3
+    vec4f u = mf_shuffle< 1, 2, 0, 1 >( a, b );    // g0 b0 g1 b1
+    r  = mf_shuffle< 0, 3, 0, 2 >( a, t );
+    g  = mf_shuffle< 0, 2, 1, 3 >( u, t );
+    bl = mf_shuffle< 1, 3, 0, 3 >( u, c );
+}
+
+// Channel registers back to four interleaved pixels
+static inline void mf_interleaved( vec4f r, vec4f g, vec4f bl, vec4f& a, vec4f& b, vec4f& c ) {
+    a = mf_shuffle< 0, 2, 0, 2 >( mf_shuffle< 0, 0, 0, 0 >( r,  g ), mf_shuffle< 0, 0, 1, 1 >( bl, r  ) );
+    b = mf_shuffle< 0, 2, 0, 2 >( mf_shuffle< 1, 1, 1, 1 >( g, bl ), mf_shuffle< 2, 2, 2, 2 >( r,  g  ) );
+    c = mf_shuffle< 0, 2, 0, 2 >( mf_shuffle< 2, 2, 3, 3 >( bl, r ), mf_shuffle< 3, 3, 3, 3 >( g,  bl ) );
+}
+#endif // MIP_SIMD
+
+// a[ i ] = op( a[ i ], b[ i ] ) for n floats. vop takes registers, sop floats
+template< class V, class S > static inline void fk_map( float* a, const float* b, size_t n, V vop, S sop ) {
+    size_t i = 0;
+    #ifdef MIP_SIMD
+    for( ; i + 4 <= n; i += 4 ) mf_store( a + i, vop( mf_load( a + i ), mf_load( b + i ) ) );
+    #endif
+    for( ; i < n; i++ ) a[ i ] = sop( a[ i ], b[ i ] );
+}
+
+// a[ i ] = op( a[ i ] ) for n floats
+template< class V, class S > static inline void fk_map( float* a, size_t n, V vop, S sop ) {
+    size_t i = 0;
+    #ifdef MIP_SIMD
+    for( ; i + 4 <= n; i += 4 ) mf_store( a + i, vop( mf_load( a + i ) ) );
+    #endif
+    for( ; i < n; i++ ) a[ i ] = sop( a[ i ] );
+}
+
+// a[ i ] = op( a[ i ], c[ i % 3 ] ) for n pixels starting at a - each pixel with constant c
+template< class V, class S > static inline void fk_map( frgb* p, const frgb& c, size_t n, V vop, S sop ) {
+    float* a = &p[ 0 ].x;
+    size_t i = 0;
+    n *= 3;
+    #ifdef MIP_SIMD
+    const float rep[ 12 ] = { c.x, c.y, c.z, c.x, c.y, c.z, c.x, c.y, c.z, c.x, c.y, c.z };
+    const vec4f c0 = mf_load( rep ), c1 = mf_load( rep + 4 ), c2 = mf_load( rep + 8 );
+    for( ; i + 12 <= n; i += 12 ) {
+        mf_store( a + i,     vop( mf_load( a + i ),     c0 ) );
+        mf_store( a + i + 4, vop( mf_load( a + i + 4 ), c1 ) );
+        mf_store( a + i + 8, vop( mf_load( a + i + 8 ), c2 ) );
+    }
+    #endif
+    for( ; i < n; i++ ) a[ i ] = sop( a[ i ], c[ i % 3 ] );
+}
+
+// n pixels to their luminance
+static inline void fk_gray( frgb* p, size_t n ) {
+    size_t i = 0;
+    #ifdef MIP_SIMD
+    float* a = &p[ 0 ].x;
+    const vec4f wr = mf_set1( 0.299f ), wg = mf_set1( 0.587f ), wb = mf_set1( 0.114f );
+    for( ; i + 4 <= n; i += 4 ) {
+        float* q = a + i * 3;
+        vec4f r, g, b;
+        mf_planar( mf_load( q ), mf_load( q + 4 ), mf_load( q + 8 ), r, g, b );
+        vec4f l = mf_add( mf_add( mf_mul( r, wr ), mf_mul( g, wg ) ), mf_mul( b, wb ) );
+        vec4f q0, q1, q2;
+        mf_interleaved( l, l, l, q0, q1, q2 );
+        mf_store( q, q0 ); mf_store( q + 4, q1 ); mf_store( q + 8, q2 );
+    }
+    #endif
+    for( ; i < n; i++ ) p[ i ] = gray( p[ i ] );
+}
+
+// n pixels brighter than 1.0 in any channel scaled by their largest channel, negative channels to zero
+static inline void fk_constrain( frgb* p, size_t n ) {
+    size_t i = 0;
+    #ifdef MIP_SIMD
+    float* a = &p[ 0 ].x;
+    const vec4f zero = mf_set1( 0.0f ), one = mf_set1( 1.0f );
+    for( ; i + 4 <= n; i += 4 ) {
+        float* q = a + i * 3;
+        vec4f r, g, b;
+        mf_planar( mf_load( q ), mf_load( q + 4 ), mf_load( q + 8 ), r, g, b );
+        vec4f m = mf_max( r, mf_max( g, b ) );
+        vec4f over = mf_gt( m, one );
+        r = mf_select( over, mf_div( mf_max( r, zero ), m ), r );
+        g = mf_select( over, mf_div( mf_max( g, zero ), m ), g );
+        b = mf_select( over, mf_div( mf_max( b, zero ), m ), b );
+        vec4f q0, q1, q2;
+        mf_interleaved( r, g, b, q0, q1, q2 );
+        mf_store( q, q0 ); mf_store( q + 4, q1 ); mf_store( q + 8, q2 );
+    }
+    #endif
+    for( ; i < n; i++ ) constrain( p[ i ] );
+}
+
+#endif // __FRGB_SIMD_HPP
@@ -2,6 +2,8 @@
 
 #include "gamma_lut.hpp"
 #include <cmath>
+#include <cstring>
+#include <algorithm>
 #include <iostream>
 
 typedef union {
@@ -82,3 +84,22 @@ unsigned char gamma_LUT :: linear_to_SRGB( float index ) {
   flub.f = index;
   return linear_to_SRGB_LUT[ ( flub.ui & 0x07ff8000 ) >> lts_shift ];  // 0 | 00001111 | 11111111000000000000000 (black magic)
 }
+
+void gamma_LUT :: SRGB_to_linear( const unsigned char* in, float* out, size_t n ) const {
+  for( size_t i = 0; i < n; i++ ) out[ i ] = SRGB_to_linear_LUT[ in[ i ] ];
+}
+
+// Same results as linear_to_SRGB( float ) without branches. The table index comes from the bits
+// of the float, kept inside the table, and values outside its range are replaced by masks afterwards
+void gamma_LUT :: linear_to_SRGB( const float* in, unsigned char* out, size_t n ) const {
+  for( size_t i = 0; i < n; i++ ) {
+    float f = in[ i ];
+    unsigned int bits;
+    std::memcpy( &bits, &f, sizeof( bits ) );
+    unsigned int v  = linear_to_SRGB_LUT[ std::min( ( bits - 0x38000000u ) >> lts_shift, lts_entries - 1 ) ];
+    unsigned int lo = 0u - (unsigned int)( f < 0.000032f );   // all ones below the table
+    unsigned int hi = 0u - (unsigned int)( f >= 1.0f );       // all ones above it
+    v = ( v & ~lo ) | ( (unsigned int)( f > 0.0f ) & lo );
+    out[ i ] = (unsigned char)( v | hi );
+  }
+}
@@ -4,6 +4,7 @@
 #define __GAMMA_LUT_HPP
 
 #include <array>
+#include <cstddef>
 
 // Number of bits in linear to SRGB lookup table
 constexpr unsigned int lts_bits = 12;
@@ -22,6 +23,9 @@ public:
 
     float SRGB_to_linear( unsigned char index );
     unsigned char linear_to_SRGB( float index );
+    // n values at a time
+    void SRGB_to_linear( const unsigned char* in, float* out, size_t n ) const;
+    void linear_to_SRGB( const float* in, unsigned char* out, size_t n ) const;
 };
 
 #endif // __GAMMA_LUT_HPP
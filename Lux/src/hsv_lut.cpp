@@ -0,0 +1,15 @@
+// Fixed point RGB <-> HSV conversion for ucolor - batch versions
+
+#include "hsv_lut.hpp"
+
+void rgb_to_hsv_span( const ucolor* in, ucolor* out, size_t n ) {
+    for( size_t i = 0; i < n; i++ ) out[ i ] = rgb_to_hsv_fixed( in[ i ] );
+}
+
+void hsv_to_rgb_span( const ucolor* in, ucolor* out, size_t n ) {
+    for( size_t i = 0; i < n; i++ ) out[ i ] = hsv_to_rgb_fixed( in[ i ] );
+}
+
+void rotate_hue_span( const ucolor* in, ucolor* out, size_t n, unsigned int r ) {
+    for( size_t i = 0; i < n; i++ ) out[ i ] = hsv_to_rgb_fixed( rotate_hue( rgb_to_hsv_fixed( in[ i ] ), r ) );
+}
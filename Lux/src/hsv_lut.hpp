@@ -0,0 +1,90 @@
+// Fixed point RGB <-> HSV conversion for ucolor
+// Hue, saturation and value are bytes in the red, green and blue positions, hue 0-255 for a full turn.
+// Divisions are replaced by exact reciprocal multiplies and the hue sector by a table,
+// so results are bit for bit those of the integer formulas in ucolor.cpp
+
+#ifndef __HSV_LUT_HPP
+#define __HSV_LUT_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include "ucolor.hpp"
+
+struct hsv_tables {
+    // floor( n / d ) == ( n * recip[ d ] ) >> shift[ d ] for n < 2^30
+    std::array< uint64_t, 256 > recip;
+    std::array< unsigned char, 256 > shift;
+    // hue to sector (0-5) and position within sector (0-0xffff)
+    std::array< unsigned char, 256 > sector;
+    std::array< unsigned int, 256 > frac;
+
+    constexpr hsv_tables() : recip(), shift(), sector(), frac() {
+        for( unsigned int d = 1; d < 256; d++ ) {
+            unsigned int l = 0;
+            while( ( 1u << l ) < d ) l++;
+            shift[ d ] = 30 + l;
+            recip[ d ] = ( ( 1ull << shift[ d ] ) + d - 1 ) / d;
+        }
+        for( unsigned int h = 0; h < 256; h++ ) {
+            sector[ h ] = ( h * 0x10000 ) / 0x2AAAAB;
+            frac[ h ] = ( h * 0x100 - sector[ h ] * 0x2AAB ) * 6;
+        }
+    }
+};
+
+inline constexpr hsv_tables hsv_lut;
+
+static inline unsigned int hsv_div( unsigned int n, unsigned int d ) { return (unsigned int)( ( n * hsv_lut.recip[ d ] ) >> hsv_lut.shift[ d ] ); }
+
+static inline ucolor rgb_to_hsv_fixed( const ucolor& in ) {
+    unsigned int r = ( in >> 16 ) & 0xff;
+    unsigned int g = ( in >> 8 ) & 0xff;
+    unsigned int b = in & 0xff;
+    unsigned int max = r > g ? r : g;
+    max = max > b ? max : b;
+    unsigned int min = r < g ? r : g;
+    min = min < b ? min : b;
+    unsigned int delta = max - min;
+    if( delta == 0 ) return ( in & 0xff000000 ) + r;    // gray
+    unsigned int s = hsv_div( delta * 0xff, max );
+    unsigned int h;
+    if( r == max ) {
+        if( b == min ) h = ( ( hsv_div( ( g - b ) * 0x2AAAAA, delta ) + 0x7FFF ) >> 16 ) & 0xff;
+        else           h = ( ( 0x1000000 - hsv_div( ( b - g ) * 0x2AAAAA, delta ) + 0x7FFF ) >> 16 ) & 0xff;
+    }
+    else if( g == max ) {
+        if( r == min ) h = ( 0x555555 + hsv_div( ( b - r ) * 0x2AAAAA, delta ) + 0x7FFF ) >> 16;
+        else           h = ( 0x555555 - hsv_div( ( r - b ) * 0x2AAAAA, delta ) + 0x7FFF ) >> 16;
+    }
+    else {
+        if( g == min ) h = ( 0xAAAAAB + hsv_div( ( r - g ) * 0x2AAAAA, delta ) + 0x7FFF ) >> 16;
+        else           h = ( 0xAAAAAB - hsv_div( ( g - r ) * 0x2AAAAA, delta ) + 0x7FFF ) >> 16;
+    }
+    return ( in & 0xff000000 ) + ( h << 16 ) + ( s << 8 ) + max;
+}
+
+static inline ucolor hsv_to_rgb_fixed( const ucolor& in ) {
+    unsigned int h = ( in >> 16 ) & 0xff;
+    unsigned int s = ( in >> 8 ) & 0xff;
+    unsigned int v = in & 0xff;
+    if( s == 0 ) return ( in & 0xff000000 ) + ( v << 16 ) + ( v << 8 ) + v;    // gray
+    unsigned int f = hsv_lut.frac[ h ];
+    // components in order v, p, q, t - each sector picks three of them for r, g and b
+    unsigned int c[ 4 ] = {
+        v,
+        ( v * ( 0xff - s ) + 0x7f ) >> 8,
+        ( v * ( 0xffff - ( s * f ) / 0x100 ) + 0x7fff ) >> 16,
+        ( v * ( 0xffff - ( s * ( 0xffff - f ) ) / 0x100 ) + 0x7fff ) >> 16 };
+    static constexpr unsigned char pick[ 6 ][ 3 ] = { { 0, 3, 1 }, { 2, 0, 1 }, { 1, 0, 3 }, { 1, 2, 0 }, { 3, 1, 0 }, { 0, 1, 2 } };
+    const unsigned char* k = pick[ hsv_lut.sector[ h ] ];
+    return ( in & 0xff000000 ) + ( c[ k[ 0 ] ] << 16 ) + ( c[ k[ 1 ] ] << 8 ) + c[ k[ 2 ] ];
+}
+
+// Batch conversions - in and out may be the same array
+void rgb_to_hsv_span( const ucolor* in, ucolor* out, size_t n );
+void hsv_to_rgb_span( const ucolor* in, ucolor* out, size_t n );
+// RGB in and out, hue rotated by r (already shifted to hue byte, as rotate_hue)
+void rotate_hue_span( const ucolor* in, ucolor* out, size_t n, unsigned int r );
+
+#endif // __HSV_LUT_HPP
@@ -8,6 +8,10 @@
 #include "vector_field.hpp"
 #include "warp_field.hpp"
 #include "any_image.hpp"
+#include "mip_simd.hpp"
+#include "joy_log.hpp"
+#include "joy_thread.hpp"
+#include "sampler.hpp"
 #include <iostream>
 #include <fstream>
 #include <cassert>
@@ -53,111 +57,72 @@ template< class T > inline T blend_tent_corner( const T& center, const T& edge1,
 }
 
 template<> inline ucolor blend_tent_corner( const ucolor& center, const ucolor& edge1, const ucolor& edge2, const ucolor& corner1 ) {
-    unsigned int random_bit = fair_coin( gen );
     return
-    ( ( ( ( ( ( ( center & 0x00ff0000 ) << 2 ) + ( ( ( edge1 & 0x00ff0000 ) + ( edge2 & 0x00ff0000 ) ) << 1 ) + ( corner1 & 0x00ff0000 ) ) >> 2 ) + 0x00040000 + random_bit ) / 9 ) & 0x00ff0000 ) + 
-    ( ( ( ( ( ( ( center & 0x0000ff00 ) << 2 ) + ( ( ( edge1 & 0x0000ff00 ) + ( edge2 & 0x0000ff00 ) ) << 1 ) + ( corner1 & 0x0000ff00 ) ) >> 2 ) + 0x00000400 + random_bit ) / 9 ) & 0x0000ff00 ) + 
-    ( ( ( ( ( ( ( center & 0x000000ff ) << 2 ) + ( ( ( edge1 & 0x000000ff ) + ( edge2 & 0x000000ff ) ) << 1 ) + ( corner1 & 0x000000ff ) ) >> 2 ) + 0x00000004 + random_bit ) / 9 ) & 0x000000ff ) + 
+    ( ( ( ( ( ( ( center & 0x00ff0000 ) << 2 ) + ( ( ( edge1 & 0x00ff0000 ) + ( edge2 & 0x00ff0000 ) ) << 1 ) + ( corner1 & 0x00ff0000 ) ) >> 2 ) + 0x00040000 ) / 9 ) & 0x00ff0000 ) + 
+    ( ( ( ( ( ( ( center & 0x0000ff00 ) << 2 ) + ( ( ( edge1 & 0x0000ff00 ) + ( edge2 & 0x0000ff00 ) ) << 1 ) + ( corner1 & 0x0000ff00 ) ) >> 2 ) + 0x00000400 ) / 9 ) & 0x0000ff00 ) + 
+    ( ( ( ( ( ( ( center & 0x000000ff ) << 2 ) + ( ( ( edge1 & 0x000000ff ) + ( edge2 & 0x000000ff ) ) << 1 ) + ( corner1 & 0x000000ff ) ) >> 2 ) + 0x00000004 ) / 9 ) & 0x000000ff ) + 
     0xff000000; // blend alphas?
 }
 
-#define MIP(   xm, ym ) mip[ level     ][ ( ym ) * mip_dim[ level     ].x + ( xm ) ]
-#define BELOW( xb, yb ) mip[ level - 1 ][ ( yb ) * mip_dim[ level - 1 ].x + ( xb ) ]
-
-template< class T > void image< T >::mip_it() { // mip it good
-    kernel = MIP_TENT;
-    std::cout << "mip it" << std::endl;
-    if( mip_me ) {
-        std::cout << "mip it good" << std::endl;
-        if( !mipped ) {
-            std::cout << "mip_it: mipped = false" << std::endl;
-            if( mip.size() > 1 ) {
-                std::cout << "warning: mip_it: mip.size() > 1"  << std::endl;
-                de_mip();
-            }            
-            if( mip.size() == 0 ) {
-                std::cout << "warning: mip_it: mip.size() == 0"  << std::endl;
-                de_mip();
-            }
-            int level = 0;
-            mip_dim.push_back( dim );
-            // mip[0] should already contain base data
-            // allocate mip map memory
-            while( mip_dim[ level ].x > 1 || mip_dim[ level ].y > 1 ) {
-                //if( mip.size() <= level + 1 ) {
-                    mip.push_back( std::vector< T >( ( mip_dim[ level ].x + 1 ) / 2 * ( mip_dim[ level ].y + 1 ) / 2 ) );
-                    mip_dim.push_back( vec2i( ( mip_dim[ level ].x + 1 ) / 2, ( mip_dim[ level ].y + 1 ) / 2 ) );
-                //}
-                level++;
+#define MIP(   xm, ym ) out[ ( ym ) * m.x + ( xm ) ]
+#define BELOW( xb, yb ) in[ ( yb ) * b.x + ( xb ) ]
+
+// Recomputes the pixels of one level inside r (half open, in level coordinates) from the level below
+template< class T > void image< T >::mip_rect( int level, const bb2i& r ) {
+    const vec2i& m = mip.dim( level );
+    const vec2i& b = mip.dim( level - 1 );
+    T* out = mip[ level ].data();
+    const T* in = mip[ level - 1 ].data();
+    bool odd_x = b.x % 2, odd_y = b.y % 2;
+    int maxx = odd_x ? m.x - 1 : m.x;   // odd sizes have a last row or column centered on the edge below
+    if( kernel == MIP_BOX ) {
+        for( int y = r.minv.y; y < r.maxv.y; y++ ) {
+            bool bottom = odd_y && ( y == m.y - 1 );
+            int x = r.minv.x;
+            if( !bottom ) x = mip_box_row( &MIP( 0, y ), &BELOW( 0, y * 2 ), &BELOW( 0, y * 2 + 1 ), x, std::min( r.maxv.x, maxx ) );
+            for( ; x < r.maxv.x; x++ ) {
+                bool right = odd_x && ( x == m.x - 1 );
+                if( right && bottom ) MIP( x, y ) = BELOW( b.x - 1, b.y - 1 );   // lower right corner
+                else if( right )  MIP( x, y ) = blend( BELOW( b.x - 1, y * 2 ), BELOW( b.x - 1, y * 2 + 1 ) );  // right edge
+                else if( bottom ) MIP( x, y ) = blend( BELOW( x * 2, b.y - 1 ), BELOW( x * 2 + 1, b.y - 1 ) );  // bottom edge
+                else MIP( x, y ) = blend4< T >( BELOW( x * 2, y * 2 ), BELOW( x * 2 + 1, y * 2 ), BELOW( x * 2, y * 2 + 1 ), BELOW( x * 2 + 1, y * 2 + 1 ) );
             }
-            mipped = true;
         }
-        if( !mip_utd ) {
-            std::cout << "mip_it: mip_utd = false" << std::endl;
-            unsigned int mip_level, mip_blend;
-            // calculate mip-maps
-            if( kernel == MIP_BOX ) {
-                int maxx, maxy;
-                for( int level = 1; level < mip.size(); level++ ) {
-                    vec2i& m = mip_dim[ level ];
-                    vec2i& b = mip_dim[ level - 1 ];
-                    if( b.x % 2 ) maxx = m.x - 1; else maxx = m.x;
-                    if( b.y % 2 ) maxy = m.y - 1; else maxy = m.y;
-                    for( int y = 0; y < maxy; y++ ) {
-                        for( int x = 0; x < maxx; x++ ) {
-                            // central part of image
-                            MIP( x, y ) = blend4< T >( 
-                                BELOW( x * 2,     y * 2 ),
-                                BELOW( x * 2 + 1, y * 2 ),
-                                BELOW( x * 2,     y * 2 + 1 ),
-                                BELOW( x * 2 + 1, y * 2 + 1 )
-                            );
-                        }
-                        if( b.x % 2 ) {
-                            // right edge
-                            MIP( m.x - 1, y ) = blend( 
-                                BELOW( b.x - 1, y * 2     ),
-                                BELOW( b.x - 1, y * 2 + 1 )
-                            );
-                        }
-                    }
-                    if( b.y % 2 ) {
-                        for( int x = 0; x < maxx; x++ ) {
-                            // bottom edge
-                            MIP( x, m.y - 1 ) = blend(
-                                BELOW( x * 2,     b.y - 1 ),
-                                BELOW( x * 2 + 1, b.y - 1 )
-                            );
-                        }
-                        if( b.x % 2 ) {
-                            // lower right corner
-                            MIP( m.x - 1, m.y - 1 ) = BELOW( b.x - 1, b.y - 1 );
-                        }
+    }
+    else if( kernel == MIP_TENT ) {
+        int x0 = std::max( r.minv.x, 1 );                 // interior columns
+        int x1 = std::min( r.maxv.x, maxx );
+        bool do_left  = ( r.minv.x == 0 ) && ( r.maxv.x > 0 );
+        bool do_right = odd_x && ( r.maxv.x == m.x ) && ( m.x - 1 >= x0 );
+        bool right0 = odd_x && ( m.x == 1 );              // one column - right edge takes the left column
+        // rows are independent - the tent kernels draw no random bits
+        parallel_rows( r.maxv.y - r.minv.y, r.maxv.x - r.minv.x, [ & ]( int y0, int y1 ) {
+            for( int y = r.minv.y + y0; y < r.minv.y + y1; y++ ) {
+                bool bottom = odd_y && ( y == m.y - 1 );      // bottom takes precedence over top when there is one row
+                bool top = !bottom && ( y == 0 );
+                if( bottom ) {
+                    auto lower_left  = [ & ]() { return blend_tent_corner( BELOW( 0, b.y - 1 ), BELOW( 0, b.y - 2 ), BELOW( 1, b.y - 1 ), BELOW( 1, b.y - 2 ) ); };
+                    auto lower_right = [ & ]() { return blend_tent_corner( BELOW( b.x - 1, b.y - 1 ), BELOW( b.x - 2, b.y - 1 ), BELOW( b.x - 1, b.y - 2 ), BELOW( b.x - 2, b.y - 2 ) ); };
+                    if( do_left ) MIP( 0, y ) = right0 ? lower_right() : lower_left();
+                    // bottom edge
+                    for( int x = x0; x < x1; x++ ) {
+                        MIP( x, y ) = blend_tent_edge( 
+                            BELOW( x * 2,     b.y - 1 ),
+                            BELOW( x * 2 - 1, b.y - 1 ),
+                            BELOW( x * 2 + 1, b.y - 1 ),
+                            BELOW( x * 2,     b.y - 2 ),
+                            BELOW( x * 2 - 1, b.y - 2 ),
+                            BELOW( x * 2 + 1, b.y - 2 )
+                        );
                     }
+                    if( do_right ) MIP( m.x - 1, y ) = lower_right();
                 }
-            }
-            else if( kernel == MIP_TENT ) {
-                int maxx, maxy;
-                for( int level = 1; level < mip.size(); level++ ) {
-                    vec2i& m = mip_dim[ level ];
-                    vec2i& b = mip_dim[ level - 1 ];
-                    // handle small mip-maps
-                    if( b.x % 2 ) maxx = m.x - 1; else maxx = m.x;
-                    if( b.y % 2 ) maxy = m.y - 1; else maxy = m.y;
-                    // upper left corner
-                    MIP( 0, 0 ) = blend_tent_corner( BELOW( 0, 0 ), BELOW( 0, 1 ), BELOW( 1, 0 ), BELOW( 1, 1 ) );
-                    // upper right corner
-                    if( b.x % 2 ) MIP( m.x - 1, 0 ) = blend_tent_corner( BELOW( b.x - 1, 0 ), BELOW( b.x - 2, 0 ), BELOW( b.x - 1, 1 ), BELOW( b.x - 2, 1 ) );
-                    if( b.y % 2 ) {
-                        // lower left corner
-                        MIP( 0, m.y - 1 ) = blend_tent_corner( BELOW( 0, b.y - 1 ), BELOW( 0, b.y - 2 ), BELOW( 1, b.y - 1 ), BELOW( 1, b.y - 2 ) );
-                        if( mip_dim[ level - 1 ].x % 2 ) {
-                            // lower right corner
-                            MIP( m.x - 1, m.y - 1 ) = blend_tent_corner( BELOW( b.x - 1, b.y - 1 ), BELOW( b.x - 2, b.y - 1 ), BELOW( b.x - 1, b.y - 2 ), BELOW( b.x - 2, b.y - 2 ) );
-                        }
-                    }
+                else if( top ) {
+                    auto upper_left  = [ & ]() { return blend_tent_corner( BELOW( 0, 0 ), BELOW( 0, 1 ), BELOW( 1, 0 ), BELOW( 1, 1 ) ); };
+                    auto upper_right = [ & ]() { return blend_tent_corner( BELOW( b.x - 1, 0 ), BELOW( b.x - 2, 0 ), BELOW( b.x - 1, 1 ), BELOW( b.x - 2, 1 ) ); };
+                    if( do_left ) MIP( 0, 0 ) = right0 ? upper_right() : upper_left();
                     // upper edge
-                    for( int x = 1; x < maxx; x++ ) {
+                    for( int x = x0; x < x1; x++ ) {
                         MIP( x, 0 ) = blend_tent_edge( 
                             BELOW( x * 2,     0 ),
                             BELOW( x * 2 - 1, 0 ),
@@ -167,9 +132,23 @@ template< class T > void image< T >::mip_it() { // mip it good
                             BELOW( x * 2 + 1, 1 )
                         );
                     }
-                    for( int y = 1; y < maxy; y++ ) {
+                    if( do_right ) MIP( m.x - 1, 0 ) = upper_right();
+                }
+                else {
+                    auto right_edge = [ & ]() {
+                        return blend_tent_edge( 
+                            BELOW( b.x - 1, y * 2 ),
+                            BELOW( b.x - 2, y * 2 ),
+                            BELOW( b.x - 1, y * 2 - 1 ),
+                            BELOW( b.x - 1, y * 2 + 1 ),
+                            BELOW( b.x - 2, y * 2 - 1 ),
+                            BELOW( b.x - 2, y * 2 + 1 )
+                        );
+                    };
+                    if( do_left ) {
                         // left edge
-                        MIP( 0, y ) = blend_tent_edge( 
+                        if( right0 ) MIP( 0, y ) = right_edge();
+                        else MIP( 0, y ) = blend_tent_edge( 
                             BELOW( 0, y * 2 ),
                             BELOW( 0, y * 2 - 1 ),
                             BELOW( 0, y * 2 + 1 ),
@@ -177,68 +156,99 @@ template< class T > void image< T >::mip_it() { // mip it good
                             BELOW( 1, y * 2 - 1 ),
                             BELOW( 1, y * 2 + 1 )
                         );
-                        for( int x = 1; x < maxx; x++ ) {
-                            // central part of image
-                            MIP( x, y ) = blend_tent( 
-                                BELOW( x * 2,     y * 2 ),
-                                BELOW( x * 2 - 1, y * 2 ),
-                                BELOW( x * 2 + 1, y * 2 ),
-                                BELOW( x * 2,     y * 2 - 1 ),
-                                BELOW( x * 2,     y * 2 + 1 ),
-                                BELOW( x * 2 - 1, y * 2 - 1 ),
-                                BELOW( x * 2 + 1, y * 2 - 1 ),
-                                BELOW( x * 2 - 1, y * 2 + 1 ),
-                                BELOW( x * 2 + 1, y * 2 + 1 )
-                            );
-                        }
-                        if( b.x % 2 ) {
-                            // right edge
-                            MIP( m.x - 1, y ) = blend_tent_edge( 
-                                BELOW( b.x - 1, y * 2 ),
-                                BELOW( b.x - 2, y * 2 ),
-                                BELOW( b.x - 1, y * 2 - 1 ),
-                                BELOW( b.x - 1, y * 2 + 1 ),
-                                BELOW( b.x - 2, y * 2 - 1 ),
-                                BELOW( b.x - 2, y * 2 + 1 )
-                            );
-                        }
                     }
-                    if( b.y % 2 ) {
-                        // bottom edge
-                        for( int x = 1; x < maxx; x++ ) {
-                            MIP( x, m.y - 1 ) = blend_tent_edge( 
-                                BELOW( x * 2,     b.y - 1 ),
-                                BELOW( x * 2 - 1, b.y - 1 ),
-                                BELOW( x * 2 + 1, b.y - 1 ),
-                                BELOW( x * 2,     b.y - 2 ),
-                                BELOW( x * 2 - 1, b.y - 2 ),
-                                BELOW( x * 2 + 1, b.y - 2 )
-                            );
-                        }
+                    // central part of image
+                    int x = mip_tent_row( &MIP( 0, y ), &BELOW( 0, y * 2 - 1 ), &BELOW( 0, y * 2 ), &BELOW( 0, y * 2 + 1 ), x0, x1 );
+                    for( ; x < x1; x++ ) {
+                        MIP( x, y ) = blend_tent( 
+                            BELOW( x * 2,     y * 2 ),
+                            BELOW( x * 2 - 1, y * 2 ),
+                            BELOW( x * 2 + 1, y * 2 ),
+                            BELOW( x * 2,     y * 2 - 1 ),
+                            BELOW( x * 2,     y * 2 + 1 ),
+                            BELOW( x * 2 - 1, y * 2 - 1 ),
+                            BELOW( x * 2 + 1, y * 2 - 1 ),
+                            BELOW( x * 2 - 1, y * 2 + 1 ),
+                            BELOW( x * 2 + 1, y * 2 + 1 )
+                        );
                     }
+                    if( do_right ) MIP( m.x - 1, y ) = right_edge();
                 }
             }
+        } );
+    }
+}
+
+template< class T > void image< T >::mip_it() { // mip it good
+    kernel = MIP_TENT;
+    if( mip_me ) {
+        if( !mipped ) {
+            JOY_LOG( JOY_DEBUG, LOG_MIP, "mip_it: allocating levels for " << dim.x << " " << dim.y );
+            // mip[0] already contains base data - allocate levels above it
+            mip.add_levels();
+            mipped = true;
+            mip_utd = false;
+        }
+        int levels = mip.size();
+        if( !mip_utd ) {
+            JOY_LOG( JOY_DEBUG, LOG_MIP, "mip_it: rebuilding " << levels << " levels" );
+            // calculate mip-maps
+            for( int level = 1; level < levels; level++ ) mip_rect( level, bb2i( { 0, 0 }, mip.dim( level ) ) );
             mip_utd = true;
         }
+        else if( !dirty.empty() ) {
+            // Recompute only the footprint of changed rectangles. A pixel at one level reads columns
+            // 2x - 1 to 2x + 1 below, so each rectangle grows by at most one pixel per level.
+            // All rectangles advance together so no level is read before it is current
+            for( int level = 1; level < levels; level++ ) {
+                for( auto& r : dirty ) {
+                    r = bb2i( r.minv / 2, linalg::min( r.maxv / 2 + 1, mip.dim( level ) ) );
+                    mip_rect( level, r );
+                }
+            }
+        }
+        dirty.clear();
+    }
+}
+
+// Marks part of the base image as changed. If the pyramid is otherwise up to date,
+// mip_it() will only recompute the levels above changed rectangles
+template< class T > void image< T >::mip_dirty( const bb2i& bb ) {
+    if( !mip_utd ) return;  // whole pyramid will be rebuilt anyway
+    vec2i lo = linalg::max( bb.minv, ipbounds.minv );
+    vec2i hi = linalg::min( bb.maxv, ipbounds.maxv );
+    if( lo.x >= hi.x || lo.y >= hi.y ) return;
+    if( dirty.size() >= max_dirty ) {
+        // too many to track - fall back to full rebuild
+        dirty.clear();
+        mip_utd = false;
+        return;
     }
+    dirty.push_back( bb2i( lo, hi ) );
 }
 
 template< class T > void image< T >::de_mip() {  
     mipped = false;
     mip_utd = false;
     // deallocate all mip-maps except base
-    // remove all elements of mip vector except first
-    if( mip.size() > 1 ) mip.erase( mip.begin() + 1, mip.end() );
-    std::cout << "de_mip()" << std::endl;
-    mip_dim.clear();
+    mip.drop_levels();
+    JOY_LOG( JOY_DEBUG, LOG_MIP, "de_mip()" );
 }
 
 template< class T > void image< T >::reset() { 
-    std::cout << "image::reset()" << std::endl;
+    JOY_LOG( JOY_DEBUG, LOG_IMAGE, "image::reset()" );
     set_dim( { 0, 0 } );
     de_mip(); 
 }
 
+// keeps the memory of the base image
+template< class T > void image< T >::blank() { 
+    use_mip( false );
+    de_mip();
+    refresh_bounds();
+    fill( T() );
+}
+
 template< class T > void image< T >::use_mip( bool m ) {
     mip_me = m;
     /*
@@ -253,8 +263,7 @@ template< class T > const vec2i image< T >::get_dim() const { return dim; }
 template< class T > void image< T >::set_dim( const vec2i& dims ) {
     //std::cout << "image::set_dim()" << std::endl;
     if( dim != dims ) {
-        auto& base = mip[ 0 ];
-        base.resize( dims.x * dims.y );
+        mip.resize( dims );
         de_mip();
         dim = dims;
         refresh_bounds();
@@ -278,21 +287,16 @@ template< class T > void image< T >::set_bounds( const bounding_box< float, 2 >&
 
 template< class T > const T image< T >::index ( const vec2i& vi, const image_extend& extend ) const {
 
-    T result;   // expect zero initialization
+    T result{}; // zero outside the image - scalar T would otherwise be uninitialized
     auto& base = mip[ 0 ];
 
     if( extend == SAMP_SINGLE ) {
         if( ipbounds.in_bounds_half_open( vi ) ) result = base[ vi.y * dim.x + vi.x ]; // else retain zero-initialized result
     }
     else {
-        int xblock = vi.x / dim.x;  if( vi.x < 0 ) { xblock -= 1; }
-        int yblock = vi.y / dim.y;  if( vi.y < 0 ) { yblock -= 1; }
-        int x = vi.x - ( xblock * dim.x );
-        int y = vi.y - ( yblock * dim.y );
-        if( extend == SAMP_REFLECT ) {
-            if( xblock % 2 ) 	{ x = dim.x - 1 - x; }
-            if( yblock % 2 ) 	{ y = dim.y - 1 - y; }
-        }
+        int x, y;
+        if( extend == SAMP_REFLECT ) { x = extend_coord< SAMP_REFLECT >( vi.x, dim.x ); y = extend_coord< SAMP_REFLECT >( vi.y, dim.y ); }
+        else                         { x = extend_coord< SAMP_REPEAT  >( vi.x, dim.x ); y = extend_coord< SAMP_REPEAT  >( vi.y, dim.y ); }
         result = base[ y * dim.x + x ];
     }
     return result;
@@ -301,7 +305,7 @@ template< class T > const T image< T >::index ( const vec2i& vi, const image_ext
 template< class T > const T image< T >::index ( const int& level, const vec2i& vi, const image_extend& extend ) const {
 
     T result;   // expect zero initialization
-    const vec2i d = mip_dim[ level ];
+    const vec2i d = mip.dim( level );
 
     if( mipped ) {
         if( level >=0 && level < mip.size() ) {          
@@ -361,16 +365,16 @@ template< class T > const T image< T >::sample_tile ( const vec2f& v, const bool
 //// Fixed point version of sample
 //
 //template< class T > const T image< T >::sample ( const unsigned int& mip_level, const unsigned int& mip_blend, const vec2i& vi ) const  {
-//    int l_index = ( vi.x >> ( 16 + mip_level     ) ) + ( vi.y >> ( 16 + mip_level     ) ) * mip_dim[ mip_level     ].x;
-//    int u_index = ( vi.x >> ( 16 + mip_level + 1 ) ) + ( vi.y >> ( 16 + mip_level + 1 ) ) * mip_dim[ mip_level + 1 ].x;
+//    int l_index = ( vi.x >> ( 16 + mip_level     ) ) + ( vi.y >> ( 16 + mip_level     ) ) * mip.dim( mip_level ).x;
+//    int u_index = ( vi.x >> ( 16 + mip_level + 1 ) ) + ( vi.y >> ( 16 + mip_level + 1 ) ) * mip.dim( mip_level + 1 ).x;
 //    return  blendf(
 //                blendf(
-//                    blendf( mip[ mip_level + 1 ][ u_index + mip_dim[ mip_level + 1 ].x + 1 ], mip[ mip_level + 1 ][ u_index + mip_dim[ mip_level + 1 ].x ], ( ( vi.x >> ( mip_level + 1 ) ) & 0xffff ) / 65536.0f ),
+//                    blendf( mip[ mip_level + 1 ][ u_index + mip.dim( mip_level + 1 ).x + 1 ], mip[ mip_level + 1 ][ u_index + mip.dim( mip_level + 1 ).x ], ( ( vi.x >> ( mip_level + 1 ) ) & 0xffff ) / 65536.0f ),
 //                    blendf( mip[ mip_level + 1 ][ u_index                              + 1 ], mip[ mip_level + 1 ][ u_index                              ], ( ( vi.x >> ( mip_level + 1 ) ) & 0xffff ) / 65536.0f ),
 //                    ( ( vi.y >> mip_level ) & 0xffff ) / 65536.0f
 //                ),
 //                blendf(
-//                    blendf( mip[ mip_level ][ l_index + mip_dim[ mip_level ].x + 1 ], mip[ mip_level ][ l_index + mip_dim[ mip_level ].x ], ( ( vi.x >> mip_level ) & 0xffff ) / 65536.0f ),
+//                    blendf( mip[ mip_level ][ l_index + mip.dim( mip_level ).x + 1 ], mip[ mip_level ][ l_index + mip.dim( mip_level ).x ], ( ( vi.x >> mip_level ) & 0xffff ) / 65536.0f ),
 //                    blendf( mip[ mip_level ][ l_index                          + 1 ], mip[ mip_level ][ l_index                          ], ( ( vi.x >> mip_level ) & 0xffff ) / 65536.0f ),
 //                    ( ( vi.y >> ( mip_level ) ) & 0xffff ) / 65536.0f
 //                ),
@@ -379,58 +383,26 @@ template< class T > const T image< T >::sample_tile ( const vec2f& v, const bool
 //}
 
 
+// Single samples choose a sampler each call - loops should hoist with_sampler() themselves
 template< class T >
 const T image< T >::sample( const vec2f& pixel_coord_f, // Input is floating-point pixel coordinate
-                            const bool& use_bilinear,    // Renamed: true=bilinear, false=nearest
+                            const bool& use_bilinear,    // true=bilinear, false=nearest (rounded)
                             const image_extend& extend ) const
 {
-    if (use_bilinear) {
-        // --- BILINEAR INTERPOLATION ---
-        // Get integer and fractional parts relative to floor
-        float x_f = pixel_coord_f.x;
-        float y_f = pixel_coord_f.y;
-        int x_int = static_cast<int>(std::floor(x_f));
-        int y_int = static_cast<int>(std::floor(y_f));
-        float x_frac = x_f - x_int; // Fractional part (0.0 to <1.0)
-        float y_frac = y_f - y_int; // Fractional part (0.0 to <1.0)
-
-        // Get the 4 neighboring pixels using index(vec2i, extend)
-        // index() MUST correctly handle the 'extend' mode for coordinates outside the 0..dim-1 range.
-        T p00 = index( vec2i{x_int,   y_int},   extend );
-        T p10 = index( vec2i{x_int+1, y_int},   extend );
-        T p01 = index( vec2i{x_int,   y_int+1}, extend );
-        T p11 = index( vec2i{x_int+1, y_int+1}, extend );
-
-        // Interpolate horizontally using blendf (which should be lerp)
-        T temp1 = blendf( p00, p10, x_frac );
-        T temp2 = blendf( p01, p11, x_frac );
-
-        // Interpolate vertically using blendf
-        return blendf( temp1, temp2, y_frac );
-        // --- End Bilinear ---
-    }
-    else {
-        // --- NEAREST NEIGHBOR SAMPLING (Rounding) ---
-        // Round floating-point pixel coordinate to the nearest integer pixel
-        vec2i nearest_pixel_i = { static_cast<int>(std::round(pixel_coord_f.x)),
-                                  static_cast<int>(std::round(pixel_coord_f.y)) };
-
-        return index( nearest_pixel_i, extend );
-    }
+    return with_sampler( *this, extend, use_bilinear, [ & ]( const auto& samp ) { return samp( pixel_coord_f ); } );
 }
 
 template<class T> const T image<T>::sample(const unsigned int& mip_level, const unsigned int& mip_blend, const vec2i& vi) const {
     // safety check - if we don't have enough mipmap levels, fallback to the highest available
-    assert(mip_level < mip.size() && "Mip level out of bounds for mip vector");
-    assert(mip_level < mip_dim.size() && "Mip level out of bounds for mip_dim vector");
-    if (mip_level +  1 >= mip.size()) {
+    assert(mip_level < (unsigned int)mip.size() && "Mip level out of bounds for mip vector");
+    if (mip_level + 1 >= (unsigned int)mip.size()) {
         unsigned int safe_level = mip.size() - 1;
 
         // simple bilinear filtering at the highest mipmap level;
         int x = vi.x >> (16 + safe_level);
         int y = vi.y >> (16 + safe_level);
-        int width = mip_dim[safe_level].x;
-        int height = mip_dim[safe_level].y;
+        int width = mip.dim( safe_level ).x;
+        int height = mip.dim( safe_level ).y;
 
         // clamp coordinates to valid ranges
         x = std::min(std::max(0, x), width - 1);
@@ -441,10 +413,10 @@ template<class T> const T image<T>::sample(const unsigned int& mip_level, const
     }
 
     // sample with boundary safeguard
-    int width_l = mip_dim[mip_level].x;
-    int height_l = mip_dim[mip_level].y;
-    int width_u = mip_dim[mip_level + 1].x;
-    int height_u = mip_dim[mip_level + 1].y;
+    int width_l = mip.dim( mip_level ).x;
+    int height_l = mip.dim( mip_level ).y;
+    int width_u = mip.dim( mip_level + 1 ).x;
+    int height_u = mip.dim( mip_level + 1 ).y;
 
     // calculate indices with bound checking
     int x_l = std::min(std::max(0, vi.x >> (16 + mip_level)), width_l - 1);
@@ -480,15 +452,17 @@ template<class T> const T image<T>::sample(const unsigned int& mip_level, const
     int u_index11 = u_y1 * width_u + u_x1;
 
     // Perform bilinear filtering at both levels
+    const T* lo = mip[ mip_level ].data();
+    const T* hi = mip[ mip_level + 1 ].data();
     T sample_l = blendf(
-                    blendf(mip[mip_level][l_index00], mip[mip_level][l_index10], blend_x_l),
-                    blendf(mip[mip_level][l_index01], mip[mip_level][l_index11], blend_x_l),
+                    blendf(lo[l_index00], lo[l_index10], blend_x_l),
+                    blendf(lo[l_index01], lo[l_index11], blend_x_l),
                     blend_y_l
                 );
 
     T sample_u = blendf(
-                    blendf(mip[mip_level+1][u_index00], mip[mip_level+1][u_index10], blend_x_u),
-                    blendf(mip[mip_level+1][u_index01], mip[mip_level+1][u_index11], blend_x_u),
+                    blendf(hi[u_index00], hi[u_index10], blend_x_u),
+                    blendf(hi[u_index01], hi[u_index11], blend_x_u),
                     blend_y_u
                 );
 
@@ -506,13 +480,15 @@ template< class T > void image< T >::crop_circle( const T& background, const flo
     vec2f center = fpbounds.center();
     auto& base = mip[ 0 ];
     
-    for( int x = 0; x < dim.x; x++ ) {
-        for( int y = 0; y < dim.y; y++ ) {
-            float r = linalg::length2( vec2f( { x * 1.0f, y * 1.0f } ) - center );
-            if( r > r2 ) base[ y * dim.x + x ] = background;
-            else blendf( base[ y * dim.x + x ], background, ( 1.0f - sqrtf( r / r2 ) ) / ramp_width );
+    parallel_rows( dim.y, dim.x, [ & ]( int y0, int y1 ) {
+        for( int y = y0; y < y1; y++ ) {
+            for( int x = 0; x < dim.x; x++ ) {
+                float r = linalg::length2( vec2f( { x * 1.0f, y * 1.0f } ) - center );
+                if( r > r2 ) base[ y * dim.x + x ] = background;
+                else blendf( base[ y * dim.x + x ], background, ( 1.0f - sqrtf( r / r2 ) ) / ramp_width );
+            }
         }
-    }
+    } );
     mip_utd = false; 
 }
 
@@ -533,25 +509,28 @@ template< class T > void image< T >::mirror(    const image< T >& in,
     if( in.dim != dim ) throw std::runtime_error( "mirror: input image must have same dimensions" );                                               
     vec2i icenter = ipbounds.bb_map( center, bounds );
 
-    auto it = begin();
-    for( int y = 0; y < dim.y; y++ ) {
-        vec2i ip = { 0, y };
-        if( reflect_y ) {
-            if( !top_to_bottom ) 
-                 { if( y < icenter.y ) ip.y = icenter.y + ( y - icenter.y ); }   
-            else { if( y > icenter.y ) ip.y = icenter.y - ( y - icenter.y ); }
-        }
-        for( int x = 0; x < dim.x; x ++ ) {
-            ip.x = x;
-            if( reflect_x ) {
-                if( left_to_right ) 
-                     { if( x > icenter.x ) ip.x = icenter.x - ( x - icenter.x ); }
-                else { if( x < icenter.x ) ip.x = icenter.x + ( x - icenter.x ); }
+    T* pixels = mip[ 0 ].data();
+    parallel_rows( dim.y, dim.x, [ & ]( int y0, int y1 ) {
+        auto it = pixels + y0 * dim.x;
+        for( int y = y0; y < y1; y++ ) {
+            vec2i ip = { 0, y };
+            if( reflect_y ) {
+                if( !top_to_bottom ) 
+                     { if( y < icenter.y ) ip.y = icenter.y + ( y - icenter.y ); }   
+                else { if( y > icenter.y ) ip.y = icenter.y - ( y - icenter.y ); }
+            }
+            for( int x = 0; x < dim.x; x ++ ) {
+                ip.x = x;
+                if( reflect_x ) {
+                    if( left_to_right ) 
+                         { if( x > icenter.x ) ip.x = icenter.x - ( x - icenter.x ); }
+                    else { if( x < icenter.x ) ip.x = icenter.x + ( x - icenter.x ); }
+                }
+                *it = in.index( ip, extend );
+                it++;
             }
-            *it = in.index( ip, extend );
-            it++;
         }
-    }
+    } );
     mip_utd = false;
 }
 
@@ -563,61 +542,66 @@ template< class T > void image< T >::turn( const image< T >& in, const direction
     }
     else { // left or right
         if( in.dim.x != dim.y || in.dim.y != dim.x ) throw std::runtime_error( "turn: input image must have same dimensions, rotated 90 degrees\n" );
-        auto it = begin();
-        for( int y = 0; y < dim.y; y++ ) {
-            for( int x = 0; x < dim.x; x++ ) {
-                if( direction == D4_RIGHT ) *it = in.index( { dim.x - 1 - y, x } );
-                else                        *it = in.index( { y, dim.y - 1 - x } );
-                *it++;
+        T* pixels = mip[ 0 ].data();
+        parallel_rows( dim.y, dim.x, [ & ]( int y0, int y1 ) {
+            auto it = pixels + y0 * dim.x;
+            for( int y = y0; y < y1; y++ ) {
+                for( int x = 0; x < dim.x; x++ ) {
+                    if( direction == D4_RIGHT ) *it = in.index( { dim.x - 1 - y, x } );
+                    else                        *it = in.index( { y, dim.y - 1 - x } );
+                    it++;
+                }
             }
-        }
+        } );
     }
     mip_utd = false;
 }
 
 template< class T > void image< T >::flip( const image< T >& in, const bool& flip_x, const bool& flip_y ) {
     if( in.dim != dim ) throw std::runtime_error( "flip: image size mismatch" ); 
-    auto it = begin();
-    if( flip_x ) {
-        if( flip_y ) { std::reverse_copy( in.begin(), in.end(), begin() ); }
-        else {    
-            auto in_it = in.begin(); auto it = begin();
-            for( int y = 0; y < dim.y; y++ ) {
-                std::reverse_copy( in_it, in_it + dim.x - 1, it );
-                in_it += dim.x; it += dim.x;
+    T* pixels = mip[ 0 ].data();
+    parallel_rows( dim.y, dim.x, [ & ]( int y0, int y1 ) {
+        auto it = pixels + y0 * dim.x;
+        if( flip_x ) {
+            if( flip_y ) { 
+                // whole image reversed - rows y0 to y1 come from the mirrored band
+                auto in_end = in.begin() + ( dim.y - y0 ) * dim.x;
+                std::reverse_copy( in_end - ( y1 - y0 ) * dim.x, in_end, it );
+            }
+            else {    
+                auto in_it = in.begin() + y0 * dim.x;
+                for( int y = y0; y < y1; y++ ) {
+                    std::reverse_copy( in_it, in_it + dim.x - 1, it );
+                    in_it += dim.x; it += dim.x;
+                }
             }
         }
-    }
-    else {
-        if( flip_y ) {
-            auto in_it = in.begin() + (dim.y - 1 ) * dim.x; auto it = begin();
-            for( int y = 0; y < dim.y; y++ ) {
-                std::copy( in_it, in_it + dim.x - 1, it );
-                in_it -= dim.x; it += dim.x;
+        else {
+            if( flip_y ) {
+                auto in_it = in.begin() + ( dim.y - 1 - y0 ) * dim.x;
+                for( int y = y0; y < y1; y++ ) {
+                    std::copy( in_it, in_it + dim.x - 1, it );
+                    in_it -= dim.x; it += dim.x;
+                }
             }
+            else { std::copy( in.begin() + y0 * dim.x, in.begin() + y1 * dim.x, it ); } // no change
         }
-        else { std::copy( in.begin(), in.end(), begin() ); } // no change
-    }
+    } );
     mip_utd = false;
 }
 
 // copy image in place
 template< class T > void image< T >::copy( const image< T >& img ) {
     //std::cout << "image::copy()" << std::endl;
-    if( img.dim == dim ) {
-        mip.assign( img.mip.begin(), img.mip.end() );
-        mip_dim.assign( img.mip_dim.begin(), img.mip_dim.end() );
-    } else {
-        dim = img.dim;
-        mip = img.mip;
-        mip_dim = img.mip_dim;
-    }  
+    dim = img.dim;
+    mip = img.mip;  // shares pixels until either image writes
     bounds = img.bounds;
     ipbounds = img.ipbounds;
     fpbounds = img.fpbounds;
     mip_me = img.mip_me;
     mipped = img.mipped;
     mip_utd = img.mip_utd;
+    dirty = img.dirty;
     kernel = img.kernel;
 }
 
@@ -638,13 +622,12 @@ template< class T > void image< T >::fill( const T& c, const bb2i& bb ) {
             auto end_it = base.begin() + ( y * dim.x + bb1.maxv.x - 1);
             std::fill( beg_it, end_it, c );
         }
+        mip_dirty( bb1 );
     }
-    mip_utd = false;
 }
 
 template< class T > void image< T >::fill( const T& c, const bb2f& bb ) {
     fill( c, bb.map_box( bounds, ipbounds ) );
-    mip_utd = false;
 }
 
 template< class T > void image< T >::clear() {
@@ -669,8 +652,8 @@ template< class T > void image< T >::noise( const float& a, const bb2i& bb ) {
                 base[ y * dim.x + x ] = weighted_bit( a ) ? white< T > : black< T >;
             }
         }
+        mip_dirty( bb1 );
     }
-    mip_utd = false;
 }
 
 template< class T > void image< T >::noise( const float& a, const bb2f& bb ) {
@@ -679,12 +662,14 @@ template< class T > void image< T >::noise( const float& a, const bb2f& bb ) {
 
 template< class T > void image< T >::checkerboard( const int& box_size, const T& c1, const T& c2 ) {
     auto& base = mip[ 0 ];
-    for( int y = 0; y < dim.y; y++ ) {
-        for( int x = 0; x < dim.x; x++ ) {
-            if( ( x / box_size + y / box_size ) % 2 ) base[ y * dim.x + x ] = c1;
-            else base[ y * dim.x + x ] = c2;
+    parallel_rows( dim.y, dim.x, [ & ]( int y0, int y1 ) {
+        for( int y = y0; y < y1; y++ ) {
+            for( int x = 0; x < dim.x; x++ ) {
+                if( ( x / box_size + y / box_size ) % 2 ) base[ y * dim.x + x ] = c1;
+                else base[ y * dim.x + x ] = c2;
+            }
         }
-    }
+    } );
     mip_utd = false;
 }
 
@@ -709,6 +694,24 @@ template< class T > void image< T >::rotate_hue( const float& h ) {}
 template< class T > void image< T >::rotate_components( const int& r ) {}
 template< class T > void image< T >::clamp( float minc, float maxc ) {}
 
+typedef linalg::vec< long long, 2 > vec2ll;
+
+static inline long long floor_div( long long a, long long b ) { return a / b - ( ( a % b != 0 ) && ( ( a < 0 ) != ( b < 0 ) ) ); }
+static inline long long ceil_div(  long long a, long long b ) { return -floor_div( -a, b ); }
+
+// Narrows steps [ k0, k1 ) to those where 0 <= s + k * u <= hi
+static inline void clip_span( long long s, long long u, long long hi, int& k0, int& k1 ) {
+    long long lo_k, hi_k;   // inclusive
+    if( u == 0 ) {
+        if( s < 0 || s > hi ) k1 = k0;
+        return;
+    }
+    if( u > 0 ) { lo_k = ceil_div( -s, u );      hi_k = floor_div( hi - s, u ); }
+    else        { lo_k = ceil_div( s - hi, -u ); hi_k = floor_div( s, -u ); }
+    if( lo_k > k0 ) k0 = (int)std::min( lo_k, (long long)k1 );
+    if( hi_k + 1 < k1 ) k1 = (int)std::max( hi_k + 1, (long long)k0 );
+}
+
 template< class T > void image< T >::splat( 
     const image< T >& splat_image,      // image of the splat
     const bool& smooth, 			    // smooth splat?
@@ -720,7 +723,6 @@ template< class T > void image< T >::splat(
     const mask_mode& mmode              // how will mask be applied to splat and backround?
 )  
 {  
-    std::cout << "splat: smooth = " << smooth << std::endl;
     const image< T >& g( splat_image );
     T gval, mval;
     auto& base = mip[ 0 ];
@@ -754,7 +756,6 @@ template< class T > void image< T >::splat(
     vec2i scfix = ( vec2i )(( sc * g.dim / 2.0f + g.dim / 2.0f ) * 65536.0f );
     vec2i unxfix = ( vec2i )( unx * g.dim / 2.0f * 65536.0f );
     vec2i unyfix = ( vec2i )( uny * g.dim / 2.0f * 65536.0f );
-	vec2i sfix;
     bb2i fixbounds( { 0, 0 }, { ( g.dim.x - 1 ) << 16, ( g.dim.y - 1 ) << 16 });
 
     // calculate mip level and blend constant of splat
@@ -767,127 +768,95 @@ template< class T > void image< T >::splat(
         mip_level--; 
     }
 
-    std::cout << "mip_level: " << mip_level << " mip_blend: " << mip_blend << std::endl;
+    JOY_LOG( JOY_TRACE, LOG_SPLAT, "splat: smooth = " << smooth << " mip_level: " << mip_level << " mip_blend: " << mip_blend );
+    if( smooth && mip_level + 1 >= (unsigned int)g.mip.size() ) {
+        JOY_LOG( JOY_DEBUG, LOG_SPLAT, "splat: invalid mip_level (" << mip_level << ") for image with " << g.mip.size() << " levels" );
+        mip_level = ( g.mip.size() > 1 ) ? g.mip.size() - 2 : 0;
+    }
+    if( has_mask ) JOY_LOG( JOY_TRACE, LOG_SPLAT, "splat: g.mip.size() = " << g.mip.size() << " m.mip.size() = " << mask->get().mip.size() );
+
     // *** Critical loop below ***
     // Quick and dirty sampling, high speed but risk of aliasing. 
     // Should work best if splat is fairly large and smooth.
     // future: add option to smooth sample into splat's mip-map
     // future: add vector and color effects
-    if( has_mask ) {
-        const image< T >& m = mask->get();
-        std::cout << "g.mip.size() = " << g.mip.size() << std::endl;
-        for( int level = 0; level < g.mip.size(); level++ ) {
-            std::cout << "g.mip[" << level << "].size() = " << g.mip[ level ].size() << std::endl;
-        }
-        std::cout << "m.mip.size() = " << m.mip.size() << std::endl;
-        for( int level = 0; level < m.mip.size(); level++ ) {
-            std::cout << "m.mip[" << level << "].size() = " << m.mip[ level ].size() << std::endl;
-        }
-//        // image and mask same size
-//        if( m.dim == g.dim ) {
-//            for( int x = sbounds.minv.x; x < sbounds.maxv.x; x++ ) {
-//                sfix = scfix;
-//                if( ( x >= 0 ) && ( x < dim.x ) ) {
-//                    for( int y = sbounds.minv.y; y < sbounds.maxv.y; y++ ) {
-//                        if( ( y >= 0 ) && ( y < dim.y ) && fixbounds.in_bounds( sfix ) ) {
-//                            if( smooth ) {
-//                                std::cout << "smooth sample sfix.x = " << sfix.x << " sfix.y = " << sfix.y << std::endl;
-//                                gval = g.sample( mip_level, mip_blend, sfix );
-//                                mval = m.sample( mip_level, mip_blend, sfix );
-//                            }
-//                            else {
-//                                gval = *( g.begin() + (sfix.y >> 16) * g.dim.x + (sfix.x >> 16) );
-//                                mval = *( m.begin() + (sfix.y >> 16) * m.dim.x + (sfix.x >> 16) );
-//                            }
-//                            if( has_tint ) ::apply_mask( base[ y * dim.x + x ], mulc( gval, my_tint ), mval, mmode );
-//                            else ::apply_mask( base[ y * dim.x + x ], gval, mval, mmode );
-//                        }
-//                        sfix += unyfix;
-//                    }
-//                }
-//                scfix += unxfix;
-//            }
-//        }
-        if( m.dim == g.dim ) {
-            for( int x = sbounds.minv.x; x < sbounds.maxv.x; x++ ) {
-                sfix = scfix;
-                if( ( x >= 0 ) && ( x < dim.x ) ) {
-                    for( int y = sbounds.minv.y; y < sbounds.maxv.y; y++ ) {
-                        if( ( y >= 0 ) && ( y < dim.y ) && fixbounds.in_bounds( sfix ) ) {
-                            if (smooth && mip_level +1 >= g.mip.size()) {
-                                std::cerr << "Error: Invalid mip_level (" << mip_level << ") calculated in splat for image with " << g.mip.size() << " levels." << std::endl;
-                                mip_level = (g.mip.size() > 1) ? g.mip.size() - 2 : 0;
-                            } else if (smooth ) {
-                                std::cout << "smooth sample sfix.x = " << sfix.x << " sfix.y = " << sfix.y << std::endl;
-                                gval = g.sample( mip_level, mip_blend, sfix );
-                                mval = m.sample( mip_level, mip_blend, sfix );
-                            } else {
-                                gval = *( g.begin() + (sfix.y >> 16) * g.dim.x + (sfix.x >> 16) );
-                                mval = *( m.begin() + (sfix.y >> 16) * m.dim.x + (sfix.x >> 16) );
-                            }
-                            if( has_tint ) ::apply_mask( base[ y * dim.x + x ], mulc( gval, my_tint ), mval, mmode );
-                            else ::apply_mask( base[ y * dim.x + x ], gval, mval, mmode );
-                        }
-                        sfix += unyfix;
-                    }
-                }
-                scfix += unxfix;
-            }
-        }
-        else {        
-            unsigned int m_mip_level, m_mip_blend;
-            m_mip_level = mip_level;
-            m_mip_blend = mip_blend;
-            // if image and mask are different sizes, step through separately
-            vec2i mscfix = ( vec2i )(( sc * m.dim / 2.0f + m.dim / 2.0f ) * 65536.0f );
-            vec2i munxfix = ( vec2i )( unx * m.dim / 2.0f * 65536.0f );
-            vec2i munyfix = ( vec2i )( uny * m.dim / 2.0f * 65536.0f );
+    // Destination is walked in rows. Each row is clipped once to the columns where the splat
+    // coordinate lies inside the splat image, so the inner loops test nothing per pixel.
+    // Source coordinate at destination x, y is scfix + ( x - sbounds.minv.x ) * unxfix + ( y - sbounds.minv.y ) * unyfix
+    int xa = std::max( sbounds.minv.x, 0 ), xb = std::min( sbounds.maxv.x, dim.x );
+    int ya = std::max( sbounds.minv.y, 0 ), yb = std::min( sbounds.maxv.y, dim.y );
+    auto at = [ & ]( const vec2i& c, const vec2i& ux, const vec2i& uy, int x, int y ) {
+        return vec2ll( c.x + (long long)( x - sbounds.minv.x ) * ux.x + (long long)( y - sbounds.minv.y ) * uy.x,
+                       c.y + (long long)( x - sbounds.minv.x ) * ux.y + (long long)( y - sbounds.minv.y ) * uy.y );
+    };
+    // mask the size of the splat steps with it; otherwise through its own coordinates
+    const image< T >* mp = has_mask ? &mask->get() : nullptr;
+    bool mask_same = has_mask && ( mp->dim == g.dim );
+    vec2i mscfix, munxfix, munyfix;
+    if( has_mask && !mask_same ) {
+        mscfix  = ( vec2i )(( sc * mp->dim / 2.0f + mp->dim / 2.0f ) * 65536.0f );
+        munxfix = ( vec2i )( unx * mp->dim / 2.0f * 65536.0f );
+        munyfix = ( vec2i )( uny * mp->dim / 2.0f * 65536.0f );
+    }
+
+    // one specialization per combination of sampling, tint and mask
+    auto rows = [ & ]( auto smooth_c, auto tint_c, auto mask_c ) {
+        constexpr bool smooth_s = decltype( smooth_c )::value;
+        constexpr bool tint_s   = decltype( tint_c   )::value;
+        constexpr int  mask_s   = decltype( mask_c   )::value;   // 0 none, 1 same size as splat, 2 own coordinates
+        auto gtex = g.mip.texels( 0 );
+        auto mtex = gtex;
+        if constexpr( mask_s ) mtex = mp->mip.texels( 0 );
+        for( int y = ya; y < yb; y++ ) {
+            vec2ll s0 = at( scfix, unxfix, unyfix, xa, y );
+            int k0 = 0, k1 = xb - xa;
+            clip_span( s0.x, unxfix.x, fixbounds.maxv.x, k0, k1 );
+            clip_span( s0.y, unxfix.y, fixbounds.maxv.y, k0, k1 );
+            if( k0 >= k1 ) continue;
+            vec2i sfix( (int)( s0.x + (long long)k0 * unxfix.x ), (int)( s0.y + (long long)k0 * unxfix.y ) );
             vec2i msfix;
-            bb2i  mfixbounds( { 0, 0 }, { ( m.dim.x - 1 ) << 16, ( m.dim.y - 1 ) << 16 }); 
-            for( int x = sbounds.minv.x; x < sbounds.maxv.x; x++ ) {
-                sfix = scfix;
-                msfix = mscfix;
-                if( ( x >= 0 ) && ( x < dim.x ) ) {
-                for( int y = sbounds.minv.y; y < sbounds.maxv.y; y++ ) {
-                    if( ( y >= 0 ) && ( y < dim.y ) && fixbounds.in_bounds( sfix ) ) {
-                            if( smooth ) { 
-                                gval = g.sample( mip_level, mip_blend, sfix );
-                                mval = m.sample( m_mip_level, m_mip_blend, msfix );
-                            }
-                            else {
-                                gval = *( g.begin() + (sfix.y  >> 16) * g.dim.x + (sfix.x  >> 16) );
-                                mval = *( m.begin() + (msfix.y >> 16) * m.dim.x + (msfix.x >> 16) );
-                            }
-                            if( has_tint ) ::apply_mask( base[ y * dim.x + x ], mulc( gval, my_tint ), mval, mmode );
-                            else           ::apply_mask( base[ y * dim.x + x ], gval, mval, mmode );
-                        }
-                        sfix  +=  unyfix;
-                        msfix += munyfix;
-                    }
-                }
-                scfix += unxfix;
-                mscfix += munxfix;
+            if constexpr( mask_s == 2 ) {
+                vec2ll m0 = at( mscfix, munxfix, munyfix, xa + k0, y );
+                msfix = vec2i( (int)m0.x, (int)m0.y );
             }
-        }      
-    }
-    else {
-        for( int x = sbounds.minv.x; x < sbounds.maxv.x; x++ ) {
-            sfix = scfix;
-            if( ( x >= 0 ) && ( x < dim.x ) ) {
-                for( int y = sbounds.minv.y; y < sbounds.maxv.y; y++ ) {
-                    if( ( y >= 0 ) && ( y < dim.y ) && fixbounds.in_bounds( sfix ) ) {
-                        if( smooth ) gval = g.sample( mip_level, mip_blend, sfix );
-                        else gval = *( g.begin() + (sfix.y >> 16) * g.dim.x + (sfix.x >> 16) );
-                        if( has_tint ) addc( base[ y * dim.x + x ], mulc( gval, my_tint ) );
-                        else           addc( base[ y * dim.x + x ], gval );
-                    }
-                    sfix += unyfix;
+            T* out = &base[ y * dim.x + xa + k0 ];
+            for( int k = k0; k < k1; k++, out++ ) {
+                if constexpr( smooth_s ) gval = g.sample( mip_level, mip_blend, sfix );
+                else                     gval = gtex( sfix.x >> 16, sfix.y >> 16 );
+                if constexpr( tint_s ) gval = mulc( gval, my_tint );
+                if constexpr( mask_s == 0 ) addc( *out, gval );
+                else {
+                    const vec2i& mf = ( mask_s == 1 ) ? sfix : msfix;
+                    if constexpr( smooth_s ) mval = mp->sample( mip_level, mip_blend, mf );
+                    else                     mval = mtex( mf.x >> 16, mf.y >> 16 );
+                    ::apply_mask( *out, gval, mval, mmode );
                 }
+                sfix += unxfix;
+                if constexpr( mask_s == 2 ) msfix += munxfix;
             }
-            scfix += unxfix;
         }
-    }
-    mip_utd = false;
+    };
+    auto by_mask = [ & ]( auto smooth_c, auto tint_c ) {
+        if( !has_mask )      rows( smooth_c, tint_c, std::integral_constant< int, 0 >() );
+        else if( mask_same ) rows( smooth_c, tint_c, std::integral_constant< int, 1 >() );
+        else                 rows( smooth_c, tint_c, std::integral_constant< int, 2 >() );
+    };
+    auto by_tint = [ & ]( auto smooth_c ) {
+        if( has_tint ) by_mask( smooth_c, std::true_type() );
+        else           by_mask( smooth_c, std::false_type() );
+    };
+    if( smooth ) by_tint( std::true_type() );
+    else         by_tint( std::false_type() );
+    mip_dirty( sbounds );
+}
+
+// bb_map treats each axis alone, so the bounds coordinate of pixel ( x, y ) is column x's value in x
+// and row y's value in y. Tables of both give the same floats as mapping every pixel
+template< class T > void image< T >::coord_tables( std::vector< float >& cx, std::vector< float >& cy ) const {
+    cx.resize( dim.x );
+    cy.resize( dim.y );
+    for( int x = 0; x < dim.x; x++ ) cx[ x ] = bounds.bb_map( vec2i( x, 0 ), ipbounds ).x;
+    for( int y = 0; y < dim.y; y++ ) cy[ y ] = bounds.bb_map( vec2i( 0, y ), ipbounds ).y;
 }
 
 template< class T > void image< T >::warp (  const image< T >& in, 
@@ -898,24 +867,55 @@ template< class T > void image< T >::warp (  const image< T >& in,
                                     const image_extend& extend )  // default SAMP_SINGLE 
 {
     bool same_dims = compare_dims( vf ); // If vector field and input image are same dimension, interpolation not necessary
-    if( ( !relative ) && same_dims )
-        std::transform( begin(), end(), vf.begin(), begin(), [ &in, &smooth, &extend ] ( T &r, const vec2f &v ) { return in.sample( v, smooth, extend ); } );
-    else {
-        auto it = begin();
-        auto vfit = vf.begin();
-        vec2f v, coord;
-        bb2f vf_bounds = vf.get_bounds();
-        for( int y = 0; y < dim.y; y++ ) {
-            for( int x = 0; x < dim.x; x++ ) {
-                coord = bounds.bb_map( vec2i( x, y ), ipbounds );
-                if( same_dims ) { v = *vfit; vfit++; }
-                else { v = vf.sample( vf_bounds.bb_map( coord, bounds ), true ); }
-                if( relative ) v = v * step + coord;
-                *it = in.sample( v, smooth, extend );
-                it++;
-            }
-        }
+    bb2f vf_bounds = vf.get_bounds();
+    std::vector< float > cx, cy;
+    coord_tables( cx, cy );
+
+    // Vector field of another size is sampled bilinearly at the same place in bounds coordinates.
+    // Each column and row has fixed neighbors and weights, found once here as vf.sample() would -
+    // offsets of -1 are outside the field and read as zero
+    struct vf_axis { int i0, i1; float frac; };
+    std::vector< vf_axis > vcols, vrows;
+    vec2i vdim = vf.get_dim();
+    if( !same_dims ) {
+        auto axis = [ & ]( float f, int n, int stride ) {
+            int i = static_cast<int>(std::floor(f));
+            return vf_axis{ ( i >= 0 && i < n ) ? i * stride : -1, ( i + 1 >= 0 && i + 1 < n ) ? ( i + 1 ) * stride : -1, f - i };
+        };
+        for( int x = 0; x < dim.x; x++ ) vcols.push_back( axis( vf_bounds.bb_map( vec2f( cx[ x ], 0.0f ), bounds ).x, vdim.x, 1 ) );
+        for( int y = 0; y < dim.y; y++ ) vrows.push_back( axis( vf_bounds.bb_map( vec2f( 0.0f, cy[ y ] ), bounds ).y, vdim.y, vdim.x ) );
     }
+    const vec2f* vbase = vf.get_base_ptr();
+    auto vf_at = [ & ]( int row, int col ) { return ( row < 0 || col < 0 ) ? vec2f( 0.0f, 0.0f ) : vbase[ row + col ]; };
+
+    with_sampler( in, extend, smooth, [ & ]( const auto& samp ) {
+        T* pixels = mip[ 0 ].data();
+        parallel_rows( dim.y, dim.x, [ & ]( int y0, int y1 ) {
+            auto it = pixels + y0 * dim.x;
+            auto vfit = vf.begin() + ( same_dims ? y0 * dim.x : 0 );
+            if( ( !relative ) && same_dims ) {
+                std::transform( vfit, vfit + ( y1 - y0 ) * dim.x, it, samp );
+                return;
+            }
+            vec2f v, coord;
+            for( int y = y0; y < y1; y++ ) {
+                coord.y = cy[ y ];
+                for( int x = 0; x < dim.x; x++ ) {
+                    coord.x = cx[ x ];
+                    if( same_dims ) { v = *vfit; vfit++; }
+                    else { 
+                        const vf_axis& c = vcols[ x ];
+                        const vf_axis& r = vrows[ y ];
+                        v = blendf( blendf( vf_at( r.i0, c.i0 ), vf_at( r.i0, c.i1 ), c.frac ),
+                                    blendf( vf_at( r.i1, c.i0 ), vf_at( r.i1, c.i1 ), c.frac ), r.frac );
+                    }
+                    if( relative ) v = v * step + coord;
+                    *it = samp( v );
+                    it++;
+                }
+            }
+        } );
+    } );
     mip_utd = false;
 }
 
@@ -926,16 +926,23 @@ template< class T > void image< T >::warp (  const image< T >& in,
                                     const bool& relative,         // default true
                                     const image_extend& extend )  // default SAMP_SINGLE 
 {
-    auto it = begin();
-    for( int y = 0; y < dim.y; y++ ) {
-        for( int x = 0; x < dim.x; x++ ) {
-            vec2f coord = bounds.bb_map( vec2i( x, y ), ipbounds );
-            vec2f v = vfn( coord );
-            if( relative ) v = v * step + coord;
-            *it = in.sample( v, smooth, extend );
-            it++;
-        }
-    }
+    std::vector< float > cx, cy;
+    coord_tables( cx, cy );
+    with_sampler( in, extend, smooth, [ & ]( const auto& samp ) {
+        T* pixels = mip[ 0 ].data();
+        parallel_rows( dim.y, dim.x, [ & ]( int y0, int y1 ) {
+            auto it = pixels + y0 * dim.x;
+            for( int y = y0; y < y1; y++ ) {
+                for( int x = 0; x < dim.x; x++ ) {
+                    vec2f coord( cx[ x ], cy[ y ] );
+                    vec2f v = vfn( coord );
+                    if( relative ) v = v * step + coord;
+                    *it = samp( v );
+                    it++;
+                }
+            }
+        } );
+    } );
     mip_utd = false;
 }
 
@@ -943,7 +950,10 @@ template< class T > void image< T >::warp ( const image< T >& in,
                                             const image< int >& wf ) {
     if( !compare_dims( wf ) ) return; // Vector field and warp field must be same dimension
     if( !compare_dims( in ) ) return; // Vector field and input image must be same dimension
-    std::transform( begin(), end(), wf.begin(), begin(), [ &in ] ( T &r, const unsigned int &i ) { return in.index( i ); } );
+    T* pixels = mip[ 0 ].data();
+    parallel_rows( dim.y, dim.x, [ & ]( int y0, int y1 ) {
+        std::transform( wf.begin() + y0 * dim.x, wf.begin() + y1 * dim.x, pixels + y0 * dim.x, [ &in ] ( const unsigned int &i ) { return in.index( i ); } );
+    } );
     mip_utd = false;
 }
 
@@ -956,15 +966,23 @@ template< class T > void image< T >::warp(  const image< T > &in,
     auto warp_bounds = ipbounds;
     if( of_extend == SAMP_SINGLE ) warp_bounds.intersect( bb2i( slide, slide + of.get_dim() ) );
 
-    vec2i v;
-    for ( v.y = warp_bounds.minv.y; v.y < warp_bounds.maxv.y; v.y++) {
-        auto it = begin() + v.y * dim.x + warp_bounds.minv.x;
-        for ( v.x = warp_bounds.minv.x; v.x < warp_bounds.maxv.x; v.x++) {
-            vec2i coord = of.index( v - slide, of_extend );
-            *it = in.index( v + coord , extend );
-            it++;
-        }
-    }
+    int rows = warp_bounds.maxv.y - warp_bounds.minv.y;
+    with_extend< false >( of, of_extend, [ & ]( const auto& ofs ) {
+        with_extend< false >( in, extend, [ & ]( const auto& samp ) {
+            T* pixels = mip[ 0 ].data();
+            parallel_rows( rows, warp_bounds.maxv.x - warp_bounds.minv.x, [ & ]( int r0, int r1 ) {
+                vec2i v;
+                for ( v.y = warp_bounds.minv.y + r0; v.y < warp_bounds.minv.y + r1; v.y++) {
+                    auto it = pixels + v.y * dim.x + warp_bounds.minv.x;
+                    for ( v.x = warp_bounds.minv.x; v.x < warp_bounds.maxv.x; v.x++) {
+                        vec2i coord = ofs.at( v.x - slide.x, v.y - slide.y );
+                        *it = samp.at( v.x + coord.x, v.y + coord.y );
+                        it++;
+                    }
+                }
+            } );
+        } );
+    } );
     mip_utd = false;
 }
 
@@ -977,7 +995,6 @@ template< class T > void image< T >::read_binary(  const std::string &filename )
     std::ifstream in_file( filename, std::ios::in | std::ios::binary );
     in_file.read( (char*)&new_dim, sizeof( vec2i ) );
     set_dim( new_dim );
-    base.resize( dim.x * dim.y );
 
     in_file.read( (char*)&new_bounds, sizeof( bb2f ) );
     set_bounds( new_bounds );
@@ -989,7 +1006,7 @@ template< class T > void image< T >::read_binary(  const std::string &filename )
 
 template< class T > void image< T >::write_binary( const std::string &filename, int level )
 {
-    auto& pixels = mip[ level ];
+    const auto& pixels = std::as_const( mip )[ level ];
 
     std::ofstream out_file( filename, std::ios::out | std::ios::binary );
     out_file.write( (char*)&dim, sizeof( vec2i ) );
@@ -999,13 +1016,13 @@ template< class T > void image< T >::write_binary( const std::string &filename,
 }
 
 template< class T > void image< T >::write_file(const std::string &filename, file_type type, int quality, int level ) {
-    if( level > 0 && !mipped) { std::cout << "image::write_file: mip-map not generated\n"; return; }
-    if( level > mip.size() ) { std::cout << "image::write_file: mip-map level out of range\n"; return; }
+    if( level > 0 && !mipped) { JOY_LOG( JOY_WARN, LOG_IMAGE, "image::write_file: mip-map not generated" ); return; }
+    if( level > mip.size() ) { JOY_LOG( JOY_WARN, LOG_IMAGE, "image::write_file: mip-map level out of range" ); return; }
     switch( type ) {
         case FILE_JPG: write_jpg( filename, quality, level ); break;
         case FILE_PNG: write_png( filename, level ); break;
         case FILE_BINARY: write_binary( filename, level ); break;
-        default: std::cout << "image::write_file: unknown file type " << type << std::endl;
+        default: JOY_LOG( JOY_WARN, LOG_IMAGE, "image::write_file: unknown file type " << type );
     }
 }
 
@@ -1019,16 +1036,14 @@ template< class T > void image< T >::apply( const std::function< T ( const T&, c
 // copy assignment
 template< class T > image< T >& image< T >::operator = ( const image< T >& rhs ) {
     if( this != &rhs ) {
-        mip.resize( rhs.mip.size() );
-        for( size_t i = 0; i < rhs.mip.size(); ++i ) {
-            mip[ i ] = rhs.mip[ i ];
-        }
+        mip = rhs.mip;
         dim = rhs.dim;
         bounds = rhs.bounds;
         ipbounds = rhs.ipbounds;
         mip_me = rhs.mip_me;
         mip_utd = rhs.mip_utd;
         mipped = rhs.mipped;
+        dirty = rhs.dirty;
     }
     return *this;
 }
@@ -1043,13 +1058,14 @@ template< class T > image< T >& image< T >::operator = ( image< T >&& rhs ) {
         mip_me = rhs.mip_me;
         mip_utd = rhs.mip_utd;
         mipped = rhs.mipped;
+        dirty = std::move( rhs.dirty );
     }
     return *this;
 }
 
 template< class T > image< T >& image< T >::operator += ( image< T >& rhs ) {
     using namespace linalg;
-    std::transform( begin(), end(), rhs.begin(), begin(), [] ( const T &a, const T &b ) { return a + b; } );
+    std::transform( begin(), end(), std::as_const( rhs ).begin(), begin(), [] ( const T &a, const T &b ) { return a + b; } );
     mip_utd = false;
     return *this;
 }
@@ -1063,7 +1079,7 @@ template< class T > image< T >& image< T >::operator += ( const T& rhs ) {
 
 template< class T > image< T >& image< T >::operator -= ( image< T >& rhs ) {
     using namespace linalg;
-    std::transform( begin(), end(), rhs.begin(), begin(), []( const T &a, const T &b ) { return a - b; } );
+    std::transform( begin(), end(), std::as_const( rhs ).begin(), begin(), []( const T &a, const T &b ) { return a - b; } );
     mip_utd = false;
     return *this;
 }
@@ -1077,7 +1093,7 @@ template< class T > image< T >& image< T >::operator -= ( const T& rhs ) {
 
 template< class T > image< T >& image< T >::operator *= ( image< T >& rhs ) {
     using namespace linalg;
-    std::transform( begin(), end(), rhs.begin(), begin(), [] ( const T &a, const T &b ) { return a * b; } );
+    std::transform( begin(), end(), std::as_const( rhs ).begin(), begin(), [] ( const T &a, const T &b ) { return a * b; } );
     mip_utd = false;
     return *this;
 }
@@ -1098,7 +1114,7 @@ template< class T > image< T >& image< T >::operator *= ( const float& rhs ) {
 
 template< class T > image< T >& image< T >::operator /= ( image< T >& rhs ) {
     using namespace linalg;
-    std::transform( begin(), end(), rhs.begin(), begin(), [] ( const T &a, const T &b ) { return a / b; } );
+    std::transform( begin(), end(), std::as_const( rhs ).begin(), begin(), [] ( const T &a, const T &b ) { return a / b; } );
     mip_utd = false;
     return *this;
 }
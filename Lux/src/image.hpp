@@ -6,11 +6,14 @@
 #define __IMAGE_HPP
 
 #include "colors.hpp"
+#include "mip_pyramid.hpp"
 #include <iterator>
 #include <vector>
 #include <memory>
 #include <optional>
 #include <functional>
+#include <type_traits>
+#include <utility>
 //#include "any_image.hpp"
 
 typedef enum image_extend
@@ -51,6 +54,9 @@ static bool diagonal(   direction8 d ) { return ( (int)d % 2 ); }
 
 template< class T > class image;
 
+// Lazy pixel expressions - see image_expr.hpp
+template< class E > struct is_pix_expr : std::false_type {};
+
 // Root template for raster-based data
 template< class T > class image {
 
@@ -66,52 +72,39 @@ protected:
     // mip-mapping
     bool mip_me;      // Use mip-mapping for this image? Default false.
     bool mipped;      // has mip-map been allocated?
-    bool mip_utd;     // is mip-map up to date? Set to false with any modification of base image
+    bool mip_utd;     // is mip-map up to date outside of dirty rectangles? Set to false with any modification of whole base image
     mip_kernel kernel;
-    std::vector< std::vector< T > > mip;  // mip-map of image - first level points to base
-    std::vector< vec2i > mip_dim;  // dimensions of mip-map levels (int)
+    mip_pyramid< T > mip;  // base image and mip-map levels in one block - mip[ 0 ] is base
+    std::vector< bb2i > dirty;  // changed parts of base image since last mip_it()
+    static constexpr size_t max_dirty = 16;  // more than this and the whole pyramid is rebuilt
     //std::vector< std::unique_ptr< bb2i > > ipbounds_mip;  // pixel space bounding box of mipped image (int)
     //std::vector< std::unique_ptr< bb2f > > fpbounds_mip;  // pixel space bounding box of mipped image (float)
     // resamples image to crate mip-map            
     void de_mip();  // deallocate all mip-maps
+    void mip_rect( int level, const bb2i& r );  // recompute part of one level from the level below
 
 public:
     // default constructor - creates empty "stub" image
     image() : dim( { 0, 0 } ), bounds(), ipbounds( { 0, 0 }, { 0, 0 } ), fpbounds( ipbounds ),
-        mip_me( false ), mipped( false ), mip_utd( false ), kernel( MIP_TENT ) 
-        {
-            // create stub base vector
-            std::vector< T > v;
-            mip.push_back( v );
-        }     
+        mip_me( false ), mipped( false ), mip_utd( false ), kernel( MIP_TENT ) {}
 
     // creates image of particular size 
     image( vec2i dims ) 
         :  dim( dims ), bounds( { -1.0f, ( 1.0f * dim.y ) / dim.x }, { 1.0f, ( -1.0f * dim.y ) / dim.x } ), ipbounds( { 0, 0 }, dim ), fpbounds( { 0.0f, 0.0f }, ipbounds.maxv - 1.0f ), 
            mip_me( false ), mipped( false ), mip_utd( false ), kernel( MIP_TENT )
             { 
-                std::vector< T > v;
-                mip.push_back( v );
-                mip[ 0 ].resize( dim.x * dim.y ); 
+                mip.resize( dim ); 
             }     
 
     image( const vec2i& dims, const bb2f& bb ) :  dim( dims ), bounds( bb ), ipbounds( { 0, 0 }, dim ), fpbounds( { 0.0f, 0.0f }, ipbounds.maxv - 1.0f ) ,
         mip_me( false ), mipped( false ), mip_utd( false ), kernel( MIP_TENT )
         { 
-            std::vector< T > v;
-            mip.push_back( v );
-            mip[ 0 ].resize( dim.x * dim.y ); 
+            mip.resize( dim ); 
         }   
 
     // copy constructor
     image( const image< T >& img ) : dim( img.dim ), bounds( img.bounds ), ipbounds( img.ipbounds ), fpbounds( ipbounds ), 
-        mip_me( img.mip_me ), mipped( img.mipped ), mip_utd( img.mip_utd ), kernel( img.kernel ) 
-        {
-            mip.resize(img.mip.size()); // Resize the outer vector to match the source
-            for (size_t i = 0; i < img.mip.size(); ++i) {
-                mip[i] = img.mip[i]; // Use the assignment operator to copy each inner vector
-            }
-        }
+        mip_me( img.mip_me ), mipped( img.mipped ), mip_utd( img.mip_utd ), kernel( img.kernel ), mip( img.mip ), dirty( img.dirty ) {}
     
     // resize constructor
     // 
@@ -126,8 +119,7 @@ public:
             bounds = { { -1.0f, ( 1.0f * dim.y ) / dim.x }, { 1.0f, ( -1.0f * dim.y ) / dim.x } };
             ipbounds = { { 0, 0 }, dim };
             fpbounds = { { 0.0f, 0.0f }, ipbounds.maxv - 1.0f };
-            mip.resize( 1 );
-            mip[0].resize( dim.x * dim.y );
+            mip.resize( dim );
 
             //if( !img.mipped ) throw std::runtime_error( "image resize constructor: image to be resized has no mip-map" );
             // splat image into new image (smoothed if mip map is available)
@@ -137,19 +129,14 @@ public:
 
     // move constructor
     image( image< T >&& img ) : dim( img.dim ), bounds( img.bounds ), ipbounds( img.ipbounds ), fpbounds( ipbounds ), 
-        mip_me( img.mip_me ), mipped( img.mipped ), mip_utd( img.mip_utd ), kernel( img.kernel )
-        {
-            // move mip map
-            mip = std::move( img.mip );
-            //mip_it();
-        }
+        mip_me( img.mip_me ), mipped( img.mipped ), mip_utd( img.mip_utd ), kernel( img.kernel ), mip( std::move( img.mip ) ), dirty( std::move( img.dirty ) ) {}
 
     // load constructor
     image( const std::string& filename ) : image() { load( filename ); } 
 
     friend class vf_tools;  // additional functions for vector fields
 
-    std::vector< T >& get_base_vector() { return mip[0]; }
+    typename mip_pyramid< T >::level& get_base_vector() { return mip[0]; }
 
     T* get_base_ptr()  {
         return &(mip[0][0]);
@@ -167,16 +154,22 @@ public:
     const auto end() const noexcept   { return mip[ 0 ].end(); }
 
     void reset();                          // clear memory & set dimensions to zero (mip_me remembered)
+    void blank();                          // pixels, bounds and mip settings as in a new image of the same size
     void use_mip( bool m );
     void mip_it();  // mipit good
     void mip_dirty() { mip_utd = false; } // mark mip-map as out of date
+    void mip_dirty( const bb2i& bb );      // mark part of base image as changed
     const vec2i get_dim() const;
     void set_dim( const vec2i& dims );
     const int get_mip_levels() const { return mip.size(); } // returns number of mip-map levels
+    bool shared() const { return mip.shared(); }  // pixels shared with a copy - copied by the first write to either
+    const vec2i& get_mip_dim( int level ) const { return mip.dim( level ); }
+    const typename mip_pyramid< T >::level& get_mip_level( int level ) const { return mip[ level ]; }
     void refresh_bounds(); // calculates default bounding boxes based on pixel dimensions
     const bb2f get_bounds() const;
     const bb2i get_ipbounds() const;
     const bb2f get_fpbounds() const;
+    void coord_tables( std::vector< float >& cx, std::vector< float >& cy ) const; // bounds coordinates of each column and row
     void set_bounds( const bb2f& bb );
     template< class U > bool compare_dims( const image< U >& img ) const { return ( dim == img.get_dim() ); }  // returns true if images have same dimensions
 
@@ -262,7 +255,7 @@ public:
                 const bool& relative = true,
                 const image_extend& extend = SAMP_SINGLE );
 
-    // warp with vector function
+    // warp with vector function - large images call vfn from several threads at once
     void warp ( const image< T >& in, 
                 const std::function< vec2f( vec2f ) >& vfn, 
                 const float& step = 1.0f, 
@@ -297,11 +290,13 @@ public:
 
     // Debugging functions
     void dump() {} // dump image to console
-    unsigned int size() { return mip[0].size(); } // return size of image
+    unsigned int size() const { return mip[0].size(); } // return size of image
 
     // operators
     image< T >&  operator = ( const image< T >&  rhs ); // copy assignment
     image< T >&  operator = ( image< T >&& rhs );      // move assignment
+    template< class E, std::enable_if_t< is_pix_expr< E >::value, int > = 0 >
+    image< T >&  operator = ( const E& e );            // evaluate pixel expression in one pass - image_expr.hpp
     image< T >&  operator += ( image< T >&  rhs );      // add rhs to this
     image< T >&  operator += ( const T& rhs );
     image< T >&  operator -= ( image< T >&  rhs );
@@ -0,0 +1,188 @@
+// Lazy pixel expressions over frgb and vec2f images of the same size
+// Arithmetic between images, expressions and single values builds a tree instead of an image;
+// dst = expression then walks every pixel once, so a chain like a * 0.5f + b - c reads each source
+// one time and writes dst one time instead of a full pass per operator. dst may appear in its own
+// expression - each pixel is read before it is written.
+// assign() and reduce() also feed every value to reducers - sum, min, max, histogram - in that pass.
+// Rows are split into bands with parallel_rows(); each band reduces into its own copy of the reducers.
+
+#ifndef __IMAGE_EXPR_HPP
+#define __IMAGE_EXPR_HPP
+
+#include "image.hpp"
+#include "joy_thread.hpp"
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+// Leaves - pixels of an image, or one value for every pixel
+template< class T > struct pix_image {
+    const T* p;
+    vec2i dim;
+    pix_image( const image< T >& img ) : p( img.get_base_ptr() ), dim( img.get_dim() ) {}
+    T at( size_t i ) const { return p[ i ]; }
+    bool fits( const vec2i& d ) const { return dim == d; }
+};
+
+template< class S > struct pix_value {
+    S v;
+    S at( size_t ) const { return v; }
+    bool fits( const vec2i& ) const { return true; }
+};
+
+template< class A, class B, class Op > struct pix_binary {
+    A a; B b; Op op;
+    auto at( size_t i ) const { return op( a.at( i ), b.at( i ) ); }
+    bool fits( const vec2i& d ) const { return a.fits( d ) && b.fits( d ); }
+};
+
+template< class A, class Op > struct pix_unary {
+    A a; Op op;
+    auto at( size_t i ) const { return op( a.at( i ) ); }
+    bool fits( const vec2i& d ) const { return a.fits( d ); }
+};
+
+template< class T >                    struct is_pix_expr< pix_image< T > >         : std::true_type {};
+template< class S >                    struct is_pix_expr< pix_value< S > >         : std::true_type {};
+template< class A, class B, class Op > struct is_pix_expr< pix_binary< A, B, Op > > : std::true_type {};
+template< class A, class Op >          struct is_pix_expr< pix_unary< A, Op > >     : std::true_type {};
+
+// Images and expressions start expressions; anything else taking part is a value.
+// Only frgb and vec2f images - ucolor packs channels in an int, so its arithmetic would mix them
+template< class X > struct is_pix_image : std::false_type {};
+template<> struct is_pix_image< image< frgb > >  : std::true_type {};
+template<> struct is_pix_image< image< vec2f > > : std::true_type {};
+template< class X > constexpr bool is_pix_operand = is_pix_expr< std::decay_t< X > >::value || is_pix_image< std::decay_t< X > >::value;
+
+template< class X > auto pix_leaf( const X& x ) {
+    if constexpr( is_pix_image< X >::value )     return pix_image< typename std::decay_t< decltype( *x.get_base_ptr() ) > >( x );
+    else if constexpr( is_pix_expr< X >::value ) return x;
+    else                                         return pix_value< X >{ x };
+}
+
+template< class A, class B, class Op > auto pix_combine( const A& a, const B& b, Op op ) {
+    auto la = pix_leaf( a );
+    auto lb = pix_leaf( b );
+    return pix_binary< decltype( la ), decltype( lb ), Op >{ la, lb, op };
+}
+
+#define PIX_EXPR_OPERATOR( sym ) \
+template< class A, class B, std::enable_if_t< is_pix_operand< A > || is_pix_operand< B >, int > = 0 > \
+auto operator sym ( const A& a, const B& b ) { return pix_combine( a, b, []( const auto& x, const auto& y ) { return x sym y; } ); }
+
+PIX_EXPR_OPERATOR( + )
+PIX_EXPR_OPERATOR( - )
+PIX_EXPR_OPERATOR( * )
+PIX_EXPR_OPERATOR( / )
+#undef PIX_EXPR_OPERATOR
+
+template< class A, std::enable_if_t< is_pix_operand< A >, int > = 0 >
+auto operator - ( const A& a ) {
+    auto la = pix_leaf( a );
+    auto neg = []( const auto& x ) { return -x; };
+    return pix_unary< decltype( la ), decltype( neg ) >{ la, neg };
+}
+
+// Any function of one pixel - pix_map( a, []( const frgb& c ) { return gray( c ); } )
+template< class A, class F > auto pix_map( const A& a, F f ) {
+    auto la = pix_leaf( a );
+    return pix_unary< decltype( la ), F >{ la, f };
+}
+
+// Reducers - add() takes each value, merge() folds in another band's result
+template< class V > static inline V pix_min_of( const V& a, const V& b ) {
+    if constexpr( std::is_arithmetic_v< V > ) return std::min( a, b );
+    else return linalg::min( a, b );
+}
+template< class V > static inline V pix_max_of( const V& a, const V& b ) {
+    if constexpr( std::is_arithmetic_v< V > ) return std::max( a, b );
+    else return linalg::max( a, b );
+}
+
+template< class V > struct pix_sum {
+    V total{};
+    void add( const V& v ) { total += v; }
+    void merge( const pix_sum& r ) { total += r.total; }
+};
+
+// per channel for vector pixels
+template< class V > struct pix_min {
+    V result{};
+    bool any = false;
+    void add( const V& v ) { result = any ? pix_min_of( result, v ) : v; any = true; }
+    void merge( const pix_min& r ) { if( r.any ) add( r.result ); }
+};
+
+template< class V > struct pix_max {
+    V result{};
+    bool any = false;
+    void add( const V& v ) { result = any ? pix_max_of( result, v ) : v; any = true; }
+    void merge( const pix_max& r ) { if( r.any ) add( r.result ); }
+};
+
+// counts of bin( v ), clamped to [ 0, bins )
+template< class V, class F > struct pix_histogram {
+    std::vector< unsigned int > counts;
+    F bin;
+    pix_histogram( int bins, F bin ) : counts( bins, 0 ), bin( bin ) {}
+    void add( const V& v ) { counts[ std::clamp( bin( v ), 0, (int)counts.size() - 1 ) ]++; }
+    void merge( const pix_histogram& r ) { for( size_t i = 0; i < counts.size(); i++ ) counts[ i ] += r.counts[ i ]; }
+};
+template< class V, class F > pix_histogram< V, F > histogram( int bins, F bin ) { return pix_histogram< V, F >( bins, bin ); }
+
+// Runs f( first, count, reducers... ) over bands of pixels. Each band works on a copy of the
+// reducers as passed in - so pass them empty - and the copies are merged back in band order
+template< class F, class... Rs > void pix_bands( const vec2i& dim, F&& f, Rs&... rs ) {
+    if constexpr( sizeof...( Rs ) == 0 ) {
+        parallel_rows( dim.y, dim.x, [ & ]( int y0, int y1 ) { f( (size_t)y0 * dim.x, (size_t)( y1 - y0 ) * dim.x ); } );
+    }
+    else {
+        std::vector< std::pair< int, std::tuple< Rs... > > > partials;
+        std::mutex m;
+        std::tuple< Rs... > fresh( rs... );
+        parallel_rows( dim.y, dim.x, [ & ]( int y0, int y1 ) {
+            std::tuple< Rs... > local( fresh );
+            std::apply( [ & ]( auto&... r ) { f( (size_t)y0 * dim.x, (size_t)( y1 - y0 ) * dim.x, r... ); }, local );
+            std::lock_guard< std::mutex > lock( m );
+            partials.emplace_back( y0, std::move( local ) );
+        } );
+        std::sort( partials.begin(), partials.end(), []( const auto& a, const auto& b ) { return a.first < b.first; } );
+        for( auto& p : partials ) std::apply( [ & ]( auto&... r ) { ( rs.merge( r ), ... ); }, p.second );
+    }
+}
+
+// dst = e, with every new pixel also added to the reducers
+template< class T, class E, class... Rs > void assign( image< T >& dst, const E& e, Rs&... rs ) {
+    auto le = pix_leaf( e );
+    assert( le.fits( dst.get_dim() ) && "pixel expression over images of another size" );
+    T* out = dst.get_base_ptr();
+    pix_bands( dst.get_dim(), [ & ]( size_t first, size_t n, auto&... r ) {
+        for( size_t i = first; i < first + n; i++ ) {
+            out[ i ] = (T)le.at( i );
+            ( r.add( out[ i ] ), ... );
+        }
+    }, rs... );
+    dst.mip_dirty();
+}
+
+// Reducers over the values of e on an image of size dim, writing nothing
+template< class E, class... Rs > void reduce( const E& e, const vec2i& dim, Rs&... rs ) {
+    auto le = pix_leaf( e );
+    assert( le.fits( dim ) && "pixel expression over images of another size" );
+    pix_bands( dim, [ & ]( size_t first, size_t n, auto&... r ) {
+        for( size_t i = first; i < first + n; i++ ) {
+            auto v = le.at( i );
+            ( r.add( v ), ... );
+        }
+    }, rs... );
+}
+
+template< class T > template< class E, std::enable_if_t< is_pix_expr< E >::value, int > >
+image< T >& image< T >::operator = ( const E& e ) {
+    assign( *this, e );
+    return *this;
+}
+
+#endif // __IMAGE_EXPR_HPP
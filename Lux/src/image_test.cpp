@@ -4,7 +4,52 @@
 #include "fimage.hpp"
 #include "buffer_pair.hpp"
 #include "scene.hpp"
+#include "life.hpp"
+#include "joy_thread.hpp"
+#include "hsv_lut.hpp"
+#include "joy_log.hpp"
+#include "sampler.hpp"
+#include "image_expr.hpp"
+#include "vector_field.hpp"
+#include "pixel_pool.hpp"
 #include <map>
+#include <functional>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <utility>
+
+// Count heap allocations so benchmarks can check steady-state frames don't allocate
+static std::atomic< size_t > alloc_count = 0;
+static std::atomic< size_t > aligned_alloc_count = 0;
+
+// GCC takes these for the library operator new and delete and flags free() of their pointers once inlined
+#if defined( __GNUC__ ) && !defined( __clang__ ) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new( size_t n ) {
+    alloc_count++;
+    if( void* p = std::malloc( n ? n : 1 ) ) return p;
+    throw std::bad_alloc();
+}
+void operator delete( void* p ) noexcept { std::free( p ); }
+void operator delete( void* p, size_t ) noexcept { std::free( p ); }
+// aligned pixel arenas
+void* operator new( size_t n, std::align_val_t a ) {
+    alloc_count++;
+    aligned_alloc_count++;
+    size_t al = (size_t)a;
+    if( void* p = std::aligned_alloc( al, ( ( n ? n : 1 ) + al - 1 ) / al * al ) ) return p;
+    throw std::bad_alloc();
+}
+void operator delete( void* p, std::align_val_t ) noexcept { std::free( p ); }
+void operator delete( void* p, size_t, std::align_val_t ) noexcept { std::free( p ); }
+#if defined( __GNUC__ ) && !defined( __clang__ ) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
 
 void splat_test() {
     //uimage img( vec2i( 512, 512 ) );
@@ -121,15 +166,1470 @@ void copy_any_buffer(const std::string& prefix) {
     img1.write_jpg(output_filename, 100);
 }
 
+// Fills a buffer with a random Life soup
+void life_soup( ubuf_ptr& buf ) {
+    for( auto& c : buf->get_image() ) c = fair_coin( gen ) ? 0xffffffff : 0xff000000;
+}
+
+// Runs Life on a 2048x2048 torus - steady state frames should not touch the heap
+bool ca_alloc_bench() {
+    const vec2i dim( 2048, 2048 );
+    const int frames = 20;
+    scene s;
+    ubuf_ptr buf = std::make_shared< buffer_pair< ucolor > >( dim );
+    any_buffer_pair_ptr any_buf = buf;
+    life_soup( buf );
+    element_context context( s, any_buf );
+    CA< ucolor > ca;
+    std::shared_ptr< rule_life< ucolor > > r( new rule_life< ucolor > );
+    ca.rule = any_rule( r, std::ref( *r ), std::ref( *r ), "life" );
+    ca( any_buf, context ); // frame 0 is a no-op
+    ca( any_buf, context ); // first generation creates back buffer
+
+    size_t allocs = alloc_count;
+    auto start = std::chrono::steady_clock::now();
+    for( int i = 0; i < frames; i++ ) ca( any_buf, context );
+    std::chrono::duration< double, std::milli > elapsed = std::chrono::steady_clock::now() - start;
+    allocs = alloc_count - allocs;
+
+    std::cout << "ca_alloc: " << dim.x << "x" << dim.y << " life " << elapsed.count() / frames << " ms/frame, " 
+              << allocs << " allocations in " << frames << " frames" << std::endl;
+    return allocs == 0;
+}
+
+// Fills a buffer with random opaque colors
+void color_soup( ubuf_ptr& buf ) {
+    for( auto& c : buf->get_image() ) c = rand_uint( gen ) | 0xff000000;
+}
+
+template< class R > any_rule make_rule( std::shared_ptr< R > r, const std::string& name ) {
+    return any_rule( r, std::ref( *r ), std::ref( *r ), name );
+}
+
+// Straightforward toroidal Moore neighborhood - reference for the CA scanner
+// by_column visits cells down each column in turn, as bug mode box blur expects
+void moore_reference( const uimage& in, uimage& out, any_rule& rule, bool by_column = false ) {
+    vec2i dim = in.get_dim();
+    CA_tile< ucolor > ca{};
+    // offsets in neighbor order: UM, UR, MR, DR, DM, DL, ML, UL, MM
+    const int ox[ 9 ] = { 0, 1, 1,  1,  0, -1, -1, -1, 0 };
+    const int oy[ 9 ] = { -1, -1, 0, 1, 1,  1,  0, -1, 0 };
+    for( int j = 0; j < ( by_column ? dim.x : dim.y ); j++ ) {
+        for( int k = 0; k < ( by_column ? dim.y : dim.x ); k++ ) {
+            int x = by_column ? j : k, y = by_column ? k : j;
+            for( int i = 0; i < 9; i++ ) {
+                int nx = ( x + ox[ i ] + dim.x ) % dim.x;
+                int ny = ( y + oy[ i ] + dim.y ) % dim.y;
+                ca.neighbors[ i ] = in.index( vec2i( nx, ny ) );
+            }
+            ca.x = x; ca.y = y;
+            rule( ca );
+            out.set( y * dim.x + x, ca.result[ 0 ] );
+        }
+    }
+}
+
+// Largest difference between color components
+unsigned int max_channel_diff( const ucolor& a, const ucolor& b ) {
+    unsigned int d = 0;
+    for( int shift = 0; shift < 32; shift += 8 ) {
+        int ca = ( a >> shift ) & 0xff, cb = ( b >> shift ) & 0xff;
+        d = std::max( d, (unsigned int)std::abs( ca - cb ) );
+    }
+    return d;
+}
+
+// Moore rules must match the reference neighborhood
+// box blur rounds with a random bit, so allow off by one. Bug mode leaves the previous
+// cell's result in place, which depends on scan order - it is checked against a scan by column
+bool ca_moore_test() {
+    const vec2i dim( 257, 190 );
+    scene s;
+    std::vector< std::pair< any_rule, unsigned int > > rules;    // rule, tolerance
+    rules.push_back( { make_rule( std::make_shared< rule_life< ucolor > >(), "life" ), 0 } );
+    for( bool bug : { false, true } ) for( auto method : { BB_ORTHOGONAL, BB_DIAGONAL, BB_ALL } ) 
+        rules.push_back( { make_rule( std::make_shared< rule_box_blur< ucolor > >( 230, method, bug ), bug ? "box_blur bug" : "box_blur" ), 1 } );
+    bool pass = true;
+    for( auto& r : rules ) {
+        ubuf_ptr buf = std::make_shared< buffer_pair< ucolor > >( dim );
+        any_buffer_pair_ptr any_buf = buf;
+        if( r.first.name == "life" ) life_soup( buf ); else color_soup( buf );
+        element_context context( s, any_buf );
+        CA< ucolor > ca;
+        ca.rule = r.first;
+        ca.ca_frame = 1;
+        uimage expected( buf->get_image() );
+        r.first.init( context );
+        moore_reference( buf->get_image(), expected, r.first, r.first.name == "box_blur bug" );
+        ca( any_buf, context );
+        int diffs = 0;
+        for( int i = 0; i < expected.size(); i++ ) 
+            diffs += ( max_channel_diff( expected.get_base_ptr()[ i ], buf->get_image().get_base_ptr()[ i ] ) > r.second );
+        std::cout << "ca_moore: " << r.first.name << " " << diffs << " differing pixels" << std::endl;
+        pass &= ( diffs == 0 );
+    }
+    return pass;
+}
+
+// Random rules with a fixed seed must give the same result for any thread count
+bool ca_threads_test() {
+    const vec2i dim( 300, 202 );
+    const int frames = 4;
+    scene s;
+    ubuf_ptr start = std::make_shared< buffer_pair< ucolor > >( dim );
+    color_soup( start );
+    std::vector< any_rule > rules = {
+        make_rule( std::make_shared< rule_random_mix< ucolor > >(), "random_mix" ),
+        make_rule( std::make_shared< rule_diffuse< ucolor > >(), "diffuse" )
+    };
+    bool pass = true;
+    for( auto& rule : rules ) {
+        std::vector< uimage > results;
+        for( int threads : { 1, 2, 4 } ) {
+            thread_pool::get().set_threads( threads );
+            ubuf_ptr buf = std::make_shared< buffer_pair< ucolor > >( start->get_image() );
+            any_buffer_pair_ptr any_buf = buf;
+            element_context context( s, any_buf );
+            CA< ucolor > ca;
+            ca.rule = rule;
+            ca.seed = 1234;
+            ca.p = 0.5f;
+            for( int i = 0; i <= frames; i++ ) ca( any_buf, context );
+            results.push_back( buf->get_image() );
+        }
+        for( int i = 1; i < results.size(); i++ ) {
+            bool same = std::equal( results[ 0 ].begin(), results[ 0 ].end(), results[ i ].begin() );
+            if( !same ) std::cout << "ca_threads: " << rule.name << " differs with thread count" << std::endl;
+            pass &= same;
+        }
+    }
+    thread_pool::get().set_threads( 0 );
+    return pass;
+}
+
+// Vector funky sort kernels must match the scalar rules bit for bit
+bool ca_funky_test() {
+    scene s;
+    bool pass = true;
+    std::uniform_int_distribution< int > rand_diff( -50, 800 );
+    for( vec2i dim : { vec2i( 256, 64 ), vec2i( 131, 70 ) } ) {
+        ubuf_ptr start = std::make_shared< buffer_pair< ucolor > >( dim );
+        color_soup( start );
+        for( int diagonal = 0; diagonal < 2; diagonal++ ) {
+            for( int dir = 0; dir < 4; dir++ ) {
+                for( CA_hood hood : { HOOD_MARGOLUS, HOOD_HOUR, HOOD_SQUARE_REV } ) {
+                    any_rule rule;
+                    if( diagonal ) {
+                        auto r = std::make_shared< rule_diagonal_funky_sort< ucolor > >( ( (funk_factor)rand_uint( gen ) << 32 ) | rand_uint( gen ), rand_diff( gen ), ( direction4_diagonal )dir, hood );
+                        rule = make_rule( r, "diagonal_funky_sort" );
+                    }
+                    else {
+                        auto r = std::make_shared< rule_funky_sort< ucolor > >( ( (funk_factor)rand_uint( gen ) << 32 ) | rand_uint( gen ), ( (funk_factor)rand_uint( gen ) << 32 ) | rand_uint( gen ), rand_diff( gen ), ( direction4 )dir, hood );
+                        rule = make_rule( r, "funky_sort" );
+                    }
+                    uimage results[ 2 ];
+                    for( int simd = 0; simd < 2; simd++ ) {
+                        ubuf_ptr buf = std::make_shared< buffer_pair< ucolor > >( start->get_image() );
+                        any_buffer_pair_ptr any_buf = buf;
+                        element_context context( s, any_buf );
+                        CA< ucolor > ca;
+                        ca.rule = rule;
+                        ca.simd = simd;
+                        for( int i = 0; i < 6; i++ ) ca( any_buf, context );
+                        results[ simd ] = buf->get_image();
+                    }
+                    if( !std::equal( results[ 0 ].begin(), results[ 0 ].end(), results[ 1 ].begin() ) ) {
+                        std::cout << "ca_funky: " << rule.name << " direction " << dir << " hood " << hood << " " << dim.x << "x" << dim.y << " differs" << std::endl;
+                        pass = false;
+                    }
+                }
+            }
+        }
+    }
+    return pass;
+}
+
+// Bit-packed Life must match the scalar rule, including rows that don't fill a word
+bool ca_life_bits_test() {
+    scene s;
+    bool pass = true;
+    for( vec2i dim : { vec2i( 256, 64 ), vec2i( 257, 190 ), vec2i( 63, 1 ), vec2i( 1, 5 ), vec2i( 130, 2 ) } ) {
+        for( int threshold = 0; threshold < 2; threshold++ ) {
+            ubuf_ptr start = std::make_shared< buffer_pair< ucolor > >( dim );
+            if( threshold ) color_soup( start ); else life_soup( start );
+            auto r = std::make_shared< rule_life< ucolor > >( white< ucolor >, black< ucolor >, threshold, 384 );
+            any_rule rule = make_rule( r, "life" );
+            uimage results[ 2 ];
+            for( int packed = 0; packed < 2; packed++ ) {
+                ubuf_ptr buf = std::make_shared< buffer_pair< ucolor > >( start->get_image() );
+                any_buffer_pair_ptr any_buf = buf;
+                element_context context( s, any_buf );
+                CA< ucolor > ca;
+                ca.rule = rule;
+                ca.simd = packed;
+                for( int i = 0; i < 8; i++ ) ca( any_buf, context );
+                results[ packed ] = buf->get_image();
+            }
+            if( !std::equal( results[ 0 ].begin(), results[ 0 ].end(), results[ 1 ].begin() ) ) {
+                std::cout << "ca_life_bits: " << dim.x << "x" << dim.y << ( threshold ? " threshold" : "" ) << " differs" << std::endl;
+                pass = false;
+            }
+        }
+    }
+    return pass;
+}
+
+// advance( n ) must match n frames - hashlife on power of two tori, packed or frame by frame otherwise
+bool ca_advance_test() {
+    scene s;
+    bool pass = true;
+    struct advance_case { vec2i dim; int n; bool life; };
+    for( auto& c : { advance_case{ { 256, 256 }, 700, true }, advance_case{ { 128, 64 }, 300, true }, advance_case{ { 64, 64 }, 7, true },
+                     advance_case{ { 100, 60 }, 90, true }, advance_case{ { 64, 48 }, 20, false } } ) {
+        ubuf_ptr start = std::make_shared< buffer_pair< ucolor > >( c.dim );
+        if( c.life ) life_soup( start ); else color_soup( start );
+        any_rule rule = c.life ? make_rule( std::make_shared< rule_life< ucolor > >(), "life" ) : make_rule( std::make_shared< rule_gravitate< ucolor > >(), "gravitate" );
+        uimage results[ 2 ];
+        double ms[ 2 ];
+        for( int jump = 0; jump < 2; jump++ ) {
+            ubuf_ptr buf = std::make_shared< buffer_pair< ucolor > >( start->get_image() );
+            any_buffer_pair_ptr any_buf = buf;
+            element_context context( s, any_buf );
+            CA< ucolor > ca;
+            ca.rule = rule;
+            ca.seed = 1234;
+            auto t0 = std::chrono::steady_clock::now();
+            if( jump ) ca.advance( any_buf, context, c.n );
+            else for( int i = 0; i < c.n; i++ ) ca( any_buf, context );
+            ms[ jump ] = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - t0 ).count();
+            results[ jump ] = buf->get_image();
+        }
+        bool same = std::equal( results[ 0 ].begin(), results[ 0 ].end(), results[ 1 ].begin() );
+        std::cout << "ca_advance: " << rule.name << " " << c.dim.x << "x" << c.dim.y << " " << c.n << " frames " << ms[ 0 ] << " ms, advance " << ms[ 1 ] << " ms" << ( same ? "" : " differs" ) << std::endl;
+        pass &= same;
+    }
+    // tiny node table forces the overflow fallback
+    ubuf_ptr start = std::make_shared< buffer_pair< ucolor > >( vec2i( 128, 128 ) );
+    life_soup( start );
+    life_bits a, b;
+    a.pack( start->get_image().get_base_ptr(), vec2i( 128, 128 ), white< ucolor >, black< ucolor > );
+    b = a;
+    life_hash small( 1 << 12 );
+    small.advance( a, 1000 );
+    b.step( 1000 );
+    bool same = true;
+    for( int y = 0; y < 128; y++ ) for( int x = 0; x < 128; x++ ) same &= ( a.get( vec2i( x, y ) ) == b.get( vec2i( x, y ) ) );
+    std::cout << "ca_advance: overflow fallback" << ( same ? "" : " differs" ) << std::endl;
+    return pass && same;
+}
+
+// Skipping settled regions must not change the result, including after the image is
+// painted on between frames. Times the late frames, when most of the image has settled
+bool ca_track_test() {
+    const vec2i dim( 403, 300 );
+    const int frames = 300;
+    scene s;
+    std::vector< any_rule > rules = {
+        make_rule( std::make_shared< rule_gravitate< ucolor > >(), "gravitate" ),
+        make_rule( std::make_shared< rule_pixel_sort< ucolor > >(), "pixel_sort" ),
+        make_rule( std::make_shared< rule_funky_sort< ucolor > >(), "funky_sort" ),
+        make_rule( std::make_shared< rule_funky_sort< ucolor > >( 0xbbbbbbbbbbbbbbbbull, 0xbbbbbbbbbbbbbbbbull, 300, D4_LEFT, HOOD_SQUARE ), "funky_sort square" )
+    };
+    ubuf_ptr start = std::make_shared< buffer_pair< ucolor > >( dim );
+    color_soup( start );
+    // active patch on a black field
+    for( int y = 0; y < dim.y; y++ ) for( int x = 0; x < dim.x; x++ ) 
+        if( x < 100 || x >= 180 || y < 60 || y >= 140 ) start->get_image().set( y * dim.x + x, black< ucolor > );
+    bool pass = true;
+    for( auto& rule : rules ) {
+        uimage results[ 2 ];
+        double ms[ 2 ];
+        for( int track = 0; track < 2; track++ ) {
+            ubuf_ptr buf = std::make_shared< buffer_pair< ucolor > >( start->get_image() );
+            any_buffer_pair_ptr any_buf = buf;
+            element_context context( s, any_buf );
+            CA< ucolor > ca;
+            ca.rule = rule;
+            ca.track = track;
+            for( int i = 0; i < frames; i++ ) {
+                if( i == frames / 2 ) for( int x = 250; x < 290; x++ ) buf->get_image().set( 200 * dim.x + x, white< ucolor > );
+                if( i == frames - 100 ) ms[ track ] = 0.0;
+                auto t0 = std::chrono::steady_clock::now();
+                ca( any_buf, context );
+                ms[ track ] += std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - t0 ).count();
+            }
+            results[ track ] = buf->get_image();
+        }
+        bool same = std::equal( results[ 0 ].begin(), results[ 0 ].end(), results[ 1 ].begin() );
+        std::cout << "ca_track: " << rule.name << " last 100 frames " << ms[ 0 ] << " ms, tracked " << ms[ 1 ] << " ms" << ( same ? "" : " differs" ) << std::endl;
+        pass &= same;
+    }
+    return pass;
+}
+
+// Transformed target kept between frames must follow edits to the target - compared
+// with a fresh CA every frame, which always rebuilds it. Self is rebuilt every frame by both
+bool ca_target_test() {
+    const vec2i dim( 160, 120 );
+    const int frames = 8;
+    scene s;
+    ubuf_ptr start = std::make_shared< buffer_pair< ucolor > >( dim );
+    ubuf_ptr target = std::make_shared< buffer_pair< ucolor > >( dim );
+    color_soup( start );
+    color_soup( target );
+    s.buffers[ "target" ] = target;
+    std::vector< any_rule > rules = {
+        make_rule( std::make_shared< rule_pixel_sort< ucolor > >(), "pixel_sort" ),
+        make_rule( std::make_shared< rule_gravitate< ucolor > >(), "gravitate" )
+    };
+    bool pass = true;
+    for( auto& rule : rules ) for( std::string name : { "target", "Self" } ) {
+        for( float angle : { 0.0f, 90.0f } ) {
+            uimage results[ 2 ];
+            double ms[ 2 ];
+            for( int fresh = 0; fresh < 2; fresh++ ) {
+                ubuf_ptr buf = std::make_shared< buffer_pair< ucolor > >( start->get_image() );
+                any_buffer_pair_ptr any_buf = buf;
+                element_context context( s, any_buf );
+                uimage target_start( target->get_image() );
+                CA< ucolor > kept;
+                ms[ fresh ] = 0.0;
+                for( int i = 1; i <= frames; i++ ) {
+                    if( i == frames / 2 ) for( int x = 0; x < dim.x; x++ ) target->get_image().set( 60 * dim.x + x, white< ucolor > );
+                    CA< ucolor > once;
+                    CA< ucolor >& ca = fresh ? once : kept;
+                    ca.rule = rule;
+                    ca.ca_frame = i;
+                    ca.targeted = true;
+                    ca.invert_target = true;
+                    ca.target_color_angle = angle;
+                    ca.target_name = name;
+                    auto t0 = std::chrono::steady_clock::now();
+                    ca( any_buf, context );
+                    ms[ fresh ] += std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - t0 ).count();
+                }
+                results[ fresh ] = buf->get_image();
+                target->get_image().copy( target_start );
+            }
+            bool same = std::equal( results[ 0 ].begin(), results[ 0 ].end(), results[ 1 ].begin() );
+            std::cout << "ca_target: " << rule.name << " " << name << " angle " << angle << " " << ms[ 0 ] << " ms, rebuilt every frame " << ms[ 1 ] << " ms" << ( same ? "" : " differs" ) << std::endl;
+            pass &= same;
+        }
+    }
+    return pass;
+}
+
+// Double precision RGB <-> HSV (as hsv.cpp) with hue, saturation and value scaled to bytes
+void hsv_reference( const ucolor& c, double& h, double& s, double& v ) {
+    double r = ( ( c >> 16 ) & 0xff ) / 255.0, g = ( ( c >> 8 ) & 0xff ) / 255.0, b = ( c & 0xff ) / 255.0;
+    double max = std::max( { r, g, b } ), min = std::min( { r, g, b } ), delta = max - min;
+    v = max * 255.0;
+    s = max > 0.0 ? delta / max * 255.0 : 0.0;
+    h = 0.0;
+    if( delta < 0.00001 ) { s = 0.0; return; }
+    if( r >= max )      h = ( g - b ) / delta;
+    else if( g >= max ) h = 2.0 + ( b - r ) / delta;
+    else                h = 4.0 + ( r - g ) / delta;
+    h *= 256.0 / 6.0;
+    if( h < 0.0 ) h += 256.0;
+}
+
+// Fixed point conversion against double precision over every RGB color, and spans against single colors
+bool hsv_test() {
+    double max_err[ 3 ] = { 0.0, 0.0, 0.0 }, sum_err[ 3 ] = { 0.0, 0.0, 0.0 };
+    unsigned int max_trip = 0;
+    unsigned long long trip_sum = 0;
+    for( unsigned int rgb = 0; rgb < ( 1 << 24 ); rgb++ ) {
+        ucolor c = 0xff000000 | rgb;
+        double h, s, v;
+        hsv_reference( c, h, s, v );
+        ucolor q = rgb_to_hsv( c );
+        double dh = std::abs( ( ( q >> 16 ) & 0xff ) - h );
+        double err[ 3 ] = { std::min( dh, 256.0 - dh ), std::abs( ( ( q >> 8 ) & 0xff ) - s ), std::abs( ( q & 0xff ) - v ) };
+        for( int i = 0; i < 3; i++ ) { max_err[ i ] = std::max( max_err[ i ], err[ i ] ); sum_err[ i ] += err[ i ]; }
+        unsigned int trip = max_channel_diff( hsv_to_rgb( q ), c );
+        max_trip = std::max( max_trip, trip );
+        trip_sum += trip;
+    }
+    const double n = 1 << 24;
+    std::cout << "hsv: error against double precision, max ( mean ) - hue " << max_err[ 0 ] << " ( " << sum_err[ 0 ] / n << " ) saturation " 
+              << max_err[ 1 ] << " ( " << sum_err[ 1 ] / n << " ) value " << max_err[ 2 ] << " ( " << sum_err[ 2 ] / n << " )" << std::endl;
+    std::cout << "hsv: round trip channel error max " << max_trip << " mean " << trip_sum / n << std::endl;
+    bool pass = max_err[ 0 ] <= 1.0 && max_err[ 1 ] <= 1.0 && max_err[ 2 ] == 0.0;
+
+    std::vector< ucolor > in( 1 << 16 ), out( in.size() );
+    std::uniform_int_distribution< ucolor > rand_color( 0, 0xffffffff );
+    for( auto& c : in ) c = rand_color( gen );
+    bool same = true;
+    rgb_to_hsv_span( in.data(), out.data(), in.size() );
+    for( int i = 0; i < in.size(); i++ ) same &= ( out[ i ] == rgb_to_hsv( in[ i ] ) );
+    hsv_to_rgb_span( in.data(), out.data(), in.size() );
+    for( int i = 0; i < in.size(); i++ ) same &= ( out[ i ] == hsv_to_rgb( in[ i ] ) );
+    rotate_hue_span( in.data(), out.data(), in.size(), 0x00400000 );
+    for( int i = 0; i < in.size(); i++ ) same &= ( out[ i ] == hsv_to_rgb( rotate_hue( rgb_to_hsv( in[ i ] ), 0x00400000 ) ) );
+    if( !same ) std::cout << "hsv: spans differ from single conversions" << std::endl;
+    return pass && same;
+}
+
+// Hue rotation of an RGB image - per pixel through doubles, and fixed point spans
+bool hsv_bench() {
+    uimage img( vec2i( 1024, 1024 ) );
+    std::uniform_int_distribution< ucolor > rand_color( 0, 0xffffffff );
+    for( auto& c : img ) c = rand_color( gen );
+    const double mp = img.size() / 1.0e6;
+    auto time = [ & ]( auto&& f ) {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        return mp / std::chrono::duration< double >( std::chrono::steady_clock::now() - t0 ).count();
+    };
+    double mps_double = time( [ & ]() {
+        for( auto& c : img ) {
+            double h, s, v;
+            hsv_reference( c, h, s, v );
+            h = std::fmod( h + 64.0, 256.0 ) * 6.0 / 256.0;
+            int i = (int)h;
+            double f = h - i, vv = v, p = v * ( 1.0 - s / 255.0 ), q = v * ( 1.0 - s / 255.0 * f ), t = v * ( 1.0 - s / 255.0 * ( 1.0 - f ) );
+            double rgb[ 6 ][ 3 ] = { { vv, t, p }, { q, vv, p }, { p, vv, t }, { p, q, vv }, { t, p, vv }, { vv, p, q } };
+            c = ( c & 0xff000000 ) | ( (ucolor)( rgb[ i ][ 0 ] + 0.5 ) << 16 ) | ( (ucolor)( rgb[ i ][ 1 ] + 0.5 ) << 8 ) | (ucolor)( rgb[ i ][ 2 ] + 0.5 );
+        }
+    } );
+    double mps_span = time( [ & ]() { rotate_hue_span( img.get_base_ptr(), img.get_base_ptr(), img.size(), 0x00400000 ); } );
+    double mps_image = time( [ & ]() { img.rgb_to_hsv(); img.rotate_hue( 90.0f ); img.hsv_to_rgb(); } );
+    std::cout << "hsv_bench: rotate hue - double " << mps_double << " MP/s, span " << mps_span << " MP/s, uimage " << mps_image << " MP/s" << std::endl;
+    return true;
+}
+
+// Copies and moves of a mipped image keep every level. Copying into an image of the same
+// size reuses its pyramid without touching the heap
+bool mip_copy_test() {
+    uimage a( vec2i( 37, 23 ) );
+    for( auto& c : a ) c = rand_uint( gen ) | 0xff000000;
+    a.use_mip( true );
+    a.mip_it();
+    bool pass = ( a.get_mip_levels() == 7 );
+    // samples between each pair of levels
+    auto same = [ & ]( const uimage& b ) {
+        if( b.get_mip_levels() != a.get_mip_levels() || b.get_dim() != a.get_dim() ) return false;
+        vec2i d = a.get_dim();
+        for( int l = 0; l < a.get_mip_levels() - 1; l++ ) {
+            d = ( d + 1 ) / 2;  // upper level
+            for( int y = 0; y < d.y - 1; y++ ) for( int x = 0; x < d.x - 1; x++ ) {
+                vec2i vi( ( x << ( 17 + l ) ) + 0x8000, ( y << ( 17 + l ) ) + 0x4000 );
+                if( a.sample( l, 0x8000, vi ) != b.sample( l, 0x8000, vi ) ) return false;
+            }
+        }
+        return true;
+    };
+    uimage b( a );
+    uimage c;
+    c = a;
+    uimage d( vec2i( 37, 23 ) );
+    d.copy( a );
+    uimage e( std::move( uimage( a ) ) );
+    uimage f;
+    f = uimage( a );
+    for( uimage* img : { &b, &c, &d, &e, &f } ) pass &= same( *img );
+
+    uimage big( vec2i( 1024, 1024 ) ), dest( vec2i( 1024, 1024 ) );
+    big.use_mip( true ); big.mip_it();
+    dest.copy( big );
+    const int copies = 20;
+    size_t allocs = alloc_count;
+    auto t0 = std::chrono::steady_clock::now();
+    for( int i = 0; i < copies; i++ ) dest.copy( big );
+    double ms = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - t0 ).count() / copies;
+    allocs = alloc_count - allocs;
+    std::cout << "mip_copy: 1024x1024 with " << big.get_mip_levels() << " levels " << ms << " ms per copy, " << allocs << " allocations" << std::endl;
+    return pass && allocs == 0;
+}
+
+// Splats and rectangle fills on a mipped image recompute only the levels above them.
+// Result matches a full rebuild
+bool mip_dirty_test() {
+    uimage a( vec2i( 301, 203 ) );
+    for( auto& c : a ) c = rand_uint( gen ) | 0xff000000;
+    a.use_mip( true );
+    a.mip_it();
+    uimage dot( vec2i( 16, 16 ) );
+    dot.fill( 0xff204060 );
+    bool pass = true;
+    double part_ms = 0.0, full_ms = 0.0;
+    for( int i = 0; i < 20; i++ ) {
+        a.splat( dot, false, vec2f( rand1( gen ) * 1.8f - 0.9f, rand1( gen ) * 1.2f - 0.6f ), 0.05f );
+        if( i % 4 == 0 ) a.fill( 0xff00ff00, bb2i( vec2i( i * 7, i * 3 ), vec2i( i * 7 + 13, i * 3 + 9 ) ) );
+        if( i % 5 == 0 ) a.noise( 0.5f, bb2i( vec2i( 300 - i * 5, 200 - i ), vec2i( 301, 203 ) ) );
+        uimage b( a );
+        auto t0 = std::chrono::steady_clock::now();
+        a.mip_it();
+        auto t1 = std::chrono::steady_clock::now();
+        b.mip_dirty();
+        b.mip_it();
+        auto t2 = std::chrono::steady_clock::now();
+        part_ms += std::chrono::duration< double, std::milli >( t1 - t0 ).count();
+        full_ms += std::chrono::duration< double, std::milli >( t2 - t1 ).count();
+        for( int l = 1; l < a.get_mip_levels(); l++ ) {
+            const vec2i& d = a.get_mip_dim( l );
+            auto& pa = a.get_mip_level( l );
+            auto& pb = b.get_mip_level( l );
+            for( int y = 0; y < d.y; y++ ) for( int x = 0; x < d.x; x++ ) {
+                int diff = max_channel_diff( pa[ y * d.x + x ], pb[ y * d.x + x ] );
+                if( diff ) {
+                    std::cout << "mip_dirty: frame " << i << " level " << l << " pixel " << x << ", " << y << " differs by " << diff << std::endl;
+                    pass = false;
+                }
+            }
+        }
+    }
+    std::cout << "mip_dirty: 20 frames, dirty rectangles " << part_ms << " ms, full rebuild " << full_ms << " ms" << std::endl;
+    return pass;
+}
+
+// Interior of every mip level against the scalar tent filter - exact for ucolor, within rounding for frgb
+bool mip_simd_test() {
+    bool pass = true;
+    for( vec2i dim : { vec2i( 37, 23 ), vec2i( 64, 48 ), vec2i( 301, 203 ), vec2i( 2, 9 ) } ) {
+        uimage a( dim );
+        fimage f( dim );
+        for( auto& c : a ) c = rand_uint( gen ) | 0xff000000;
+        for( auto& c : f ) c = frgb( rand1( gen ), rand1( gen ), rand1( gen ) );
+        a.use_mip( true ); a.mip_it();
+        f.use_mip( true ); f.mip_it();
+        for( int l = 1; l < a.get_mip_levels(); l++ ) {
+            const vec2i& m = a.get_mip_dim( l );
+            const vec2i& b = a.get_mip_dim( l - 1 );
+            auto& ua = a.get_mip_level( l );     auto& ub = a.get_mip_level( l - 1 );
+            auto& fa = f.get_mip_level( l );     auto& fb = f.get_mip_level( l - 1 );
+            int maxx = ( b.x % 2 ) ? m.x - 1 : m.x;
+            int maxy = ( b.y % 2 ) ? m.y - 1 : m.y;
+            for( int y = 1; y < maxy; y++ ) for( int x = 1; x < maxx; x++ ) {
+                unsigned int ch[ 3 ] = { 8, 8, 8 };
+                frgb fs( 0.0f, 0.0f, 0.0f );
+                for( int j = -1; j <= 1; j++ ) for( int i = -1; i <= 1; i++ ) {
+                    int w = ( 2 - std::abs( i ) ) * ( 2 - std::abs( j ) );
+                    ucolor c = ub[ ( y * 2 + j ) * b.x + x * 2 + i ];
+                    ch[ 0 ] += w * rc( c ); ch[ 1 ] += w * gc( c ); ch[ 2 ] += w * bc( c );
+                    fs += fb[ ( y * 2 + j ) * b.x + x * 2 + i ] * (float)w;
+                }
+                ucolor expected = 0xff000000 | ( ( ch[ 0 ] >> 4 ) << 16 ) | ( ( ch[ 1 ] >> 4 ) << 8 ) | ( ch[ 2 ] >> 4 );
+                fs /= 16.0f;
+                frgb fd = fa[ y * m.x + x ] - fs;
+                if( ua[ y * m.x + x ] != expected || std::abs( fd.x ) + std::abs( fd.y ) + std::abs( fd.z ) > 1e-5f ) {
+                    std::cout << "mip_simd: " << dim.x << "x" << dim.y << " level " << l << " pixel " << x << ", " << y << " differs" << std::endl;
+                    pass = false;
+                }
+            }
+        }
+    }
+    // levels large enough to be built in bands match the single thread build
+    uimage big( vec2i( 611, 419 ) );
+    for( auto& c : big ) c = rand_uint( gen ) | 0xff000000;
+    big.use_mip( true );
+    uimage built[ 2 ];
+    for( int threads : { 1, 4 } ) {
+        thread_pool::get().set_threads( threads );
+        big.mip_dirty();
+        big.mip_it();
+        built[ threads > 1 ] = big;     // keeps its levels when big is rebuilt
+    }
+    thread_pool::get().set_threads( 0 );
+    for( int l = 1; l < big.get_mip_levels(); l++ ) {
+        auto& l0 = built[ 0 ].get_mip_level( l );
+        auto& l1 = built[ 1 ].get_mip_level( l );
+        pass &= std::equal( l0.begin(), l0.end(), l1.begin() );
+    }
+    return pass;
+}
+
+// Full pyramid rebuild of a 4K image
+bool mip_bench() {
+    const vec2i dim( 3840, 2160 );
+    const int reps = 10;
+    uimage a( dim );
+    fimage f( dim );
+    for( auto& c : a ) c = rand_uint( gen ) | 0xff000000;
+    for( auto& c : f ) c = frgb( rand1( gen ), rand1( gen ), rand1( gen ) );
+    a.use_mip( true ); a.mip_it();
+    f.use_mip( true ); f.mip_it();
+    auto time = [ & ]( auto& img ) {
+        auto t0 = std::chrono::steady_clock::now();
+        for( int i = 0; i < reps; i++ ) { img.mip_dirty(); img.mip_it(); }
+        return std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - t0 ).count() / reps;
+    };
+    double ums = time( a ), fms = time( f );
+    std::cout << "mip_bench: 3840x2160 " << a.get_mip_levels() << " levels - ucolor " << ums << " ms, frgb " << fms << " ms per pyramid" << std::endl;
+    return true;
+}
+
+// Column order splat as it was before the row-major rewrite - reference for splat_rows
+void splat_reference( uimage& dst, const uimage& g, bool smooth, vec2f center, float scale, float theta, const uimage* m, std::optional< ucolor > tint ) {
+    bb2f bounds = dst.get_bounds();
+    bb2i ipbounds = dst.get_ipbounds();
+    vec2i dim = dst.get_dim();
+    vec2i gdim = g.get_dim();
+    ucolor* base = dst.get_base_ptr();
+    float thrad = theta / 360.0 * TAU;
+    vec2i p = ipbounds.bb_map( center, bounds );
+    int size = scale / ( bounds.b2.x - bounds.b1.x ) * dim.x;
+    bb2i sbounds( p, size );
+    vec2f smin = bounds.bb_map( sbounds.minv, ipbounds );
+    vec2f sc( ( smin.x - center.x ) / scale, ( smin.y - center.y ) / scale );
+    sc = linalg::rot( -thrad, sc );
+    vec2f unx( 1.0f / dim.x * ( bounds.b2.x - bounds.b1.x ) / scale, 0.0f );
+    unsigned int unit_scale = (unsigned int)( std::fabs( unx.x ) * gdim.x / 2.0f * 65536.0f );
+    unx = linalg::rot( -thrad, unx );
+    vec2f uny( 0.0f, -1.0f / dim.y * ( bounds.b2.y - bounds.b1.y ) / scale );
+    uny = linalg::rot( -thrad, uny );
+    vec2i scfix  = ( vec2i )( ( sc * gdim / 2.0f + gdim / 2.0f ) * 65536.0f );
+    vec2i unxfix = ( vec2i )( unx * gdim / 2.0f * 65536.0f );
+    vec2i unyfix = ( vec2i )( uny * gdim / 2.0f * 65536.0f );
+    bb2i fixbounds( { 0, 0 }, { ( gdim.x - 1 ) << 16, ( gdim.y - 1 ) << 16 } );
+    vec2i mdim = m ? m->get_dim() : gdim;
+    vec2i mscfix  = ( vec2i )( ( sc * mdim / 2.0f + mdim / 2.0f ) * 65536.0f );
+    vec2i munxfix = ( vec2i )( unx * mdim / 2.0f * 65536.0f );
+    vec2i munyfix = ( vec2i )( uny * mdim / 2.0f * 65536.0f );
+    unsigned int mip_level = 0, mip_blend = 0;
+    while( unit_scale >> ( mip_level + 16 ) ) mip_level++;
+    if( mip_level > 0 ) { mip_blend = ( unit_scale >> mip_level ) & 0xffff; mip_level--; }
+    for( int x = sbounds.minv.x; x < sbounds.maxv.x; x++ ) {
+        vec2i sfix = scfix, msfix = mscfix;
+        if( x >= 0 && x < dim.x ) {
+            for( int y = sbounds.minv.y; y < sbounds.maxv.y; y++ ) {
+                if( y >= 0 && y < dim.y && fixbounds.in_bounds( sfix ) ) {
+                    ucolor gval = smooth ? g.sample( mip_level, mip_blend, sfix ) : g.index( vec2i( sfix.x >> 16, sfix.y >> 16 ) );
+                    if( tint ) gval = mulc( gval, *tint );
+                    if( m ) {
+                        ucolor mval = smooth ? m->sample( mip_level, mip_blend, msfix ) : m->index( vec2i( msfix.x >> 16, msfix.y >> 16 ) );
+                        apply_mask( base[ y * dim.x + x ], gval, mval, MASK_BLEND );
+                    }
+                    else addc( base[ y * dim.x + x ], gval );
+                }
+                sfix += unyfix;
+                msfix += munyfix;
+            }
+        }
+        scfix += unxfix;
+        mscfix += munxfix;
+    }
+}
+
+// Row-major splat with clipped spans matches the column order reference in every combination
+bool splat_rows_test() {
+    uimage g( vec2i( 96, 64 ) ), msame( vec2i( 96, 64 ) ), msmall( vec2i( 48, 32 ) );
+    for( uimage* i : { &g, &msame, &msmall } ) {
+        for( auto& c : *i ) c = rand_uint( gen ) | 0xff000000;
+        i->use_mip( true );
+        i->mip_it();
+    }
+    uimage start( vec2i( 200, 150 ) );
+    for( auto& c : start ) c = rand_uint( gen ) | 0xff000000;
+    bool pass = true;
+    int cases = 0;
+    for( float theta : { 0.0f, 17.0f, 45.0f, 90.0f, 180.0f, 231.0f } )
+    for( bool smooth : { false, true } )
+    for( int mk = 0; mk < 3; mk++ )
+    for( bool tinted : { false, true } ) {
+        vec2f center( rand1( gen ) * 2.4f - 1.2f, rand1( gen ) * 1.6f - 0.8f );
+        float scale = 0.2f + rand1( gen ) * 0.6f;
+        uimage* m = ( mk == 0 ) ? nullptr : ( mk == 1 ? &msame : &msmall );
+        std::optional< ucolor > tint;
+        if( tinted ) tint = 0xff80c0ff;
+        uimage a( start ), b( start );
+        if( m ) a.splat( g, smooth, center, scale, theta, std::ref( *m ), tint );
+        else    a.splat( g, smooth, center, scale, theta, std::nullopt, tint );
+        splat_reference( b, g, smooth, center, scale, theta, m, tint );
+        if( !std::equal( a.begin(), a.end(), b.begin() ) ) {
+            std::cout << "splat_rows: theta " << theta << " smooth " << smooth << " mask " << mk << " tint " << tinted << " differs" << std::endl;
+            pass = false;
+        }
+        cases++;
+    }
+    std::cout << "splat_rows: " << cases << " cases" << std::endl;
+    return pass;
+}
+
+// Debug messages build only for enabled categories, and not at all below JOY_LOG_LEVEL
+bool log_test() {
+    int built = 0;
+    auto count = [ & ]() { return ++built; };
+    bool compiled = JOY_DEBUG >= JOY_LOG_LEVEL;
+    log_enable( LOG_ALL, false );
+    JOY_LOG( JOY_DEBUG, LOG_SPLAT, "log_test: disabled " << count() );
+    bool pass = ( built == 0 );
+    log_enable( LOG_SPLAT | LOG_MIP );
+    JOY_LOG( JOY_DEBUG, LOG_SPLAT, "log_test: enabled " << count() );
+    JOY_LOG( JOY_DEBUG, LOG_CA, "log_test: other category " << count() );
+    pass &= ( built == ( compiled ? 1 : 0 ) );
+    pass &= ( JOY_LOG_ON( JOY_DEBUG, LOG_MIP ) == compiled ) && !JOY_LOG_ON( JOY_DEBUG, LOG_CA );
+    log_enable( LOG_MIP, false );
+    pass &= !JOY_LOG_ON( JOY_DEBUG, LOG_MIP ) && ( JOY_LOG_ON( JOY_ERROR, LOG_MIP ) == ( JOY_ERROR >= JOY_LOG_LEVEL ) );
+    log_enable( LOG_ALL, false );
+    // image functions are quiet unless asked
+    uimage a( vec2i( 16, 16 ) );
+    a.use_mip( true );
+    a.mip_it();
+    a.reset();
+    std::cout << "log_test: level " << JOY_LOG_LEVEL << " built " << built << std::endl;
+    return pass;
+}
+
+// Edge handling written out plainly - blocks of the image counted with floor division
+template< class T > static T extend_reference( const image< T >& img, int x, int y, image_extend extend ) {
+    vec2i dim = img.get_dim();
+    if( extend == SAMP_SINGLE ) {
+        if( x < 0 || y < 0 || x >= dim.x || y >= dim.y ) return T{};
+        return img.get_base_ptr()[ y * dim.x + x ];
+    }
+    int bx = (int)std::floor( (double)x / dim.x ), by = (int)std::floor( (double)y / dim.y );
+    x -= bx * dim.x; y -= by * dim.y;
+    if( extend == SAMP_REFLECT ) {
+        if( bx & 1 ) x = dim.x - 1 - x;
+        if( by & 1 ) y = dim.y - 1 - y;
+    }
+    return img.get_base_ptr()[ y * dim.x + x ];
+}
+
+// Samplers with hoisted edge modes match index() and plain edge handling, inside and outside the image
+template< class T > static bool sampler_check( const vec2i& dim, const std::string& name ) {
+    image< T > a( dim );
+    for( auto& c : a ) c = blendf( black< T >, white< T >, rand1( gen ) );
+    bool pass = true;
+    for( image_extend extend : { SAMP_SINGLE, SAMP_REPEAT, SAMP_REFLECT } ) {
+        int diffs = 0;
+        with_sampler( a, extend, true, [ & ]( const auto& samp ) {
+            for( int i = 0; i < 20000; i++ ) {
+                // every fourth coordinate an exact multiple of the size
+                vec2i vi( (int)( rand_uint( gen ) % ( dim.x * 7 ) ) - dim.x * 3, (int)( rand_uint( gen ) % ( dim.y * 7 ) ) - dim.y * 3 );
+                if( i % 4 == 0 ) vi = vec2i( vi.x / dim.x * dim.x, vi.y / dim.y * dim.y );
+                vec2f v( vi.x + rand1( gen ), vi.y + rand1( gen ) );
+                vec2i f( (int)std::floor( v.x ), (int)std::floor( v.y ) );
+                T expected = blendf( blendf( extend_reference( a, f.x, f.y,     extend ), extend_reference( a, f.x + 1, f.y,     extend ), v.x - f.x ),
+                                     blendf( extend_reference( a, f.x, f.y + 1, extend ), extend_reference( a, f.x + 1, f.y + 1, extend ), v.x - f.x ), v.y - f.y );
+                if constexpr( !std::is_same_v< T, ucolor > ) diffs += ( samp( v ) != expected );  // ucolor in sampler_fixed
+                diffs += ( a.index( vi, extend ) != extend_reference( a, vi.x, vi.y, extend ) );
+                diffs += ( a.sample( v, false, extend ) != extend_reference( a, (int)std::round( v.x ), (int)std::round( v.y ), extend ) );
+            }
+        } );
+        if( diffs ) std::cout << "sampler: " << name << " extend " << extend << " " << diffs << " differences" << std::endl;
+        pass &= ( diffs == 0 );
+    }
+    return pass;
+}
+
+bool sampler_test() {
+    bool pass = sampler_check< ucolor >( vec2i( 37, 23 ), "ucolor" );
+    pass &= sampler_check< frgb >( vec2i( 16, 41 ), "frgb" );
+    pass &= sampler_check< vec2f >( vec2i( 5, 3 ), "vec2f" );
+    return pass;
+}
+
+// Channels of a, b, c, d blended in floating point - bilinear with fractions tx, ty
+static float lerp_channel( ucolor a, ucolor b, ucolor c, ucolor d, int shift, float tx, float ty ) {
+    auto ch = [ & ]( ucolor u ) { return (float)( ( u >> shift ) & 0xff ); };
+    return std::lerp( std::lerp( ch( a ), ch( b ), tx ), std::lerp( ch( c ), ch( d ), tx ), ty );
+}
+
+// Largest channel difference between u and floating point channels in f
+static float channel_error( ucolor u, const float f[ 4 ] ) {
+    float err = 0.0f;
+    for( int k = 0; k < 4; k++ ) err = std::max( err, std::abs( (float)( ( u >> ( k * 8 ) ) & 0xff ) - f[ k ] ) );
+    return err;
+}
+
+// Fixed point ucolor sampling stays within two levels per channel of bilinear and trilinear
+// blends in floating point - samples of a rotated, scaled grid compared pixel by pixel
+bool sampler_fixed_test() {
+    const float max_error = 2.0f;
+    uimage a( vec2i( 61, 43 ) );
+    for( auto& c : a ) c = rand_uint( gen );
+    bool pass = true;
+    vec2i odim( 200, 150 );
+    vec2f ux( 0.37f, 0.11f ), uy( -0.11f, 0.37f ), start( -20.3f, -12.7f );
+    for( image_extend extend : { SAMP_SINGLE, SAMP_REPEAT, SAMP_REFLECT } ) {
+        float worst = 0.0f;
+        double total = 0.0;
+        for( int y = 0; y < odim.y; y++ ) for( int x = 0; x < odim.x; x++ ) {
+            vec2f v = start + ux * (float)x + uy * (float)y;
+            ucolor s = a.sample( v, true, extend );
+            vec2i f( (int)std::floor( v.x ), (int)std::floor( v.y ) );
+            ucolor p00 = extend_reference( a, f.x, f.y, extend ),     p10 = extend_reference( a, f.x + 1, f.y, extend );
+            ucolor p01 = extend_reference( a, f.x, f.y + 1, extend ), p11 = extend_reference( a, f.x + 1, f.y + 1, extend );
+            float expected[ 4 ];
+            for( int k = 0; k < 4; k++ ) expected[ k ] = lerp_channel( p00, p10, p01, p11, k * 8, v.x - f.x, v.y - f.y );
+            float err = channel_error( s, expected );
+            worst = std::max( worst, err );
+            total += err;
+        }
+        std::cout << "sampler_fixed: bilinear extend " << extend << " max error " << worst << " mean " << total / ( odim.x * odim.y ) << std::endl;
+        pass &= ( worst <= max_error );
+    }
+
+    // trilinear between each pair of levels
+    a.use_mip( true );
+    a.mip_it();
+    float worst = 0.0f;
+    for( int l = 0; l < a.get_mip_levels() - 2; l++ ) {
+        vec2i dl = a.get_mip_dim( l ), du = a.get_mip_dim( l + 1 );
+        auto& lo = a.get_mip_level( l );
+        auto& hi = a.get_mip_level( l + 1 );
+        for( int j = 0; j < 20000; j++ ) {
+            // inside the last column and row of the upper level
+            vec2i vi( rand_uint( gen ) % ( ( du.x - 1 ) << ( 17 + l ) ), rand_uint( gen ) % ( ( du.y - 1 ) << ( 17 + l ) ) );
+            unsigned int blend = rand_uint( gen ) & 0xffff;
+            ucolor s = a.sample( l, blend, vi );
+            vec2i pl = vi >> ( 16 + l ), pu = vi >> ( 17 + l );
+            float txl = ( ( vi.x >> ( 8 + l ) ) & 0xff ) / 256.0f, tyl = ( ( vi.y >> ( 8 + l ) ) & 0xff ) / 256.0f;
+            float txu = ( ( vi.x >> ( 9 + l ) ) & 0xff ) / 256.0f, tyu = ( ( vi.y >> ( 9 + l ) ) & 0xff ) / 256.0f;
+            auto L = [ & ]( int x, int y ) { return lo[ y * dl.x + x ]; };
+            auto U = [ & ]( int x, int y ) { return hi[ y * du.x + x ]; };
+            float expected[ 4 ];
+            for( int k = 0; k < 4; k++ ) {
+                float fl = lerp_channel( L( pl.x, pl.y ), L( pl.x + 1, pl.y ), L( pl.x, pl.y + 1 ), L( pl.x + 1, pl.y + 1 ), k * 8, txl, tyl );
+                float fu = lerp_channel( U( pu.x, pu.y ), U( pu.x + 1, pu.y ), U( pu.x, pu.y + 1 ), U( pu.x + 1, pu.y + 1 ), k * 8, txu, tyu );
+                expected[ k ] = std::lerp( fu, fl, ( blend >> 8 ) / 256.0f );
+            }
+            worst = std::max( worst, channel_error( s, expected ) );
+        }
+    }
+    std::cout << "sampler_fixed: trilinear max error " << worst << std::endl;
+    pass &= ( worst <= max_error );
+    return pass;
+}
+
+// Vector field warp as it was, mapping every pixel's coordinates - reference for warp_coords
+template< class T > void warp_reference( image< T >& out, const image< T >& in, const image< vec2f >& vf, float step, bool smooth, bool relative, image_extend extend ) {
+    bool same_dims = out.compare_dims( vf );
+    bb2f bounds = out.get_bounds(), vf_bounds = vf.get_bounds();
+    bb2i ipbounds = out.get_ipbounds();
+    vec2i dim = out.get_dim();
+    auto it = out.begin();
+    auto vfit = vf.begin();
+    for( int y = 0; y < dim.y; y++ ) {
+        for( int x = 0; x < dim.x; x++ ) {
+            vec2f v, coord = bounds.bb_map( vec2i( x, y ), ipbounds );
+            if( same_dims ) { v = *vfit; vfit++; }
+            else { v = vf.sample( vf_bounds.bb_map( coord, bounds ), true ); }
+            if( relative ) v = v * step + coord;
+            *it = in.sample( v, smooth, extend );
+            it++;
+        }
+    }
+}
+
+// Column and row coordinate tables with a fused field fetch match the per-pixel mapping bit for bit
+template< class T > static bool warp_coords_check( const vec2i& dim, const std::string& name ) {
+    image< T > a( dim );
+    for( auto& c : a ) c = blendf( black< T >, white< T >, rand1( gen ) );
+    bool pass = true;
+    for( vec2i vdim : { dim, dim / 3, vec2i( dim.x * 2, dim.y / 2 ), vec2i( 7, 5 ) } ) {
+        image< vec2f > vf( vdim );
+        for( auto& v : vf ) v = vec2f( rand1( gen ) - 0.5f, rand1( gen ) - 0.5f ) * 3.0f;
+        for( bool smooth : { false, true } )
+        for( bool relative : { false, true } )
+        for( image_extend extend : { SAMP_SINGLE, SAMP_REPEAT, SAMP_REFLECT } ) {
+            image< T > b( dim ), c( dim );
+            b.warp( a, vf, 0.7f, smooth, relative, extend );
+            warp_reference( c, a, vf, 0.7f, smooth, relative, extend );
+            if( !std::equal( b.begin(), b.end(), c.begin() ) ) {
+                std::cout << "warp_coords: " << name << " field " << vdim.x << "x" << vdim.y << " smooth " << smooth << " relative " << relative << " extend " << extend << " differs" << std::endl;
+                pass = false;
+            }
+        }
+    }
+    return pass;
+}
+
+bool warp_coords_test() {
+    bool pass = warp_coords_check< ucolor >( vec2i( 317, 211 ), "ucolor" );
+    pass &= warp_coords_check< frgb >( vec2i( 120, 190 ), "frgb" );
+    return pass;
+}
+
+// Vector warp at 1080p - per-pixel mapping against coordinate tables, one thread
+bool warp_bench() {
+    const int reps = 5;
+    const vec2i dim( 1920, 1080 );
+    uimage a( dim ), b( dim );
+    for( auto& c : a ) c = rand_uint( gen ) | 0xff000000;
+    thread_pool::get().set_threads( 1 );
+    for( vec2i vdim : { dim, dim / 4 } ) {
+        image< vec2f > vf( vdim );
+        for( auto& v : vf ) v = vec2f( rand1( gen ) - 0.5f, rand1( gen ) - 0.5f ) * 0.05f;
+        for( bool smooth : { false, true } ) {
+            auto t0 = std::chrono::steady_clock::now();
+            for( int i = 0; i < reps; i++ ) warp_reference( b, a, vf, 1.0f, smooth, true, SAMP_REPEAT );
+            auto t1 = std::chrono::steady_clock::now();
+            for( int i = 0; i < reps; i++ ) b.warp( a, vf, 1.0f, smooth, true, SAMP_REPEAT );
+            auto t2 = std::chrono::steady_clock::now();
+            double ms0 = std::chrono::duration< double, std::milli >( t1 - t0 ).count() / reps;
+            double ms1 = std::chrono::duration< double, std::milli >( t2 - t1 ).count() / reps;
+            std::cout << "warp_bench: field " << vdim.x << "x" << vdim.y << ( smooth ? " smooth" : " nearest" ) << " per pixel " << ms0 << " ms, tables " << ms1 << " ms" << std::endl;
+        }
+    }
+    thread_pool::get().set_threads( 0 );
+    return true;
+}
+
+// Row-parallel image operations, run on the given source with each thread count
+static std::vector< std::pair< std::string, std::function< void ( uimage& ) > > > row_ops( const uimage& a ) {
+    vec2i dim = a.get_dim();
+    auto vf = std::make_shared< image< vec2f > >( dim );
+    auto vf_small = std::make_shared< image< vec2f > >( dim / 3 );
+    auto wf = std::make_shared< image< int > >( dim );
+    auto of = std::make_shared< image< vec2i > >( dim / 2 );
+    for( auto& v : *vf ) v = vec2f( rand1( gen ) - 0.5f, rand1( gen ) - 0.5f ) * 0.2f;
+    for( auto& v : *vf_small ) v = vec2f( rand1( gen ) - 0.5f, rand1( gen ) - 0.5f ) * 0.2f;
+    for( auto& i : *wf ) i = rand_uint( gen ) % ( dim.x * dim.y );
+    for( auto& v : *of ) v = vec2i( rand_uint( gen ) % 21 - 10, rand_uint( gen ) % 21 - 10 );
+    std::function< vec2f( vec2f ) > swirl = []( vec2f v ) { return vec2f( -v.y, v.x ) * 0.1f; };
+    return {
+        { "warp vf",          [ =, &a ]( uimage& b ) { b.warp( a, *vf, 1.0f, false, true, SAMP_REFLECT ); } },
+        { "warp vf smooth",   [ =, &a ]( uimage& b ) { b.warp( a, *vf, 1.0f, true, true, SAMP_REPEAT ); } },
+        { "warp vf absolute", [ =, &a ]( uimage& b ) { b.warp( a, *vf, 1.0f, true, false, SAMP_REPEAT ); } },
+        { "warp vf scaled",   [ =, &a ]( uimage& b ) { b.warp( a, *vf_small, 1.0f, true, true, SAMP_REFLECT ); } },
+        { "warp fn",          [ =, &a ]( uimage& b ) { b.warp( a, swirl, 1.0f, true, true, SAMP_REPEAT ); } },
+        { "warp wf",          [ =, &a ]( uimage& b ) { b.warp( a, *wf ); } },
+        { "warp of",          [ =, &a ]( uimage& b ) { b.warp( a, *of, vec2i( 13, 7 ), SAMP_REPEAT, SAMP_SINGLE ); } },
+        { "warp of repeat",   [ =, &a ]( uimage& b ) { b.warp( a, *of, vec2i( 13, 7 ), SAMP_REFLECT, SAMP_REPEAT ); } },
+        { "mirror",           [ &a ]( uimage& b ) { b.mirror( a, true, true, false, true, vec2f( 0.2f, -0.1f ), SAMP_REFLECT ); } },
+        { "mirror flipped",   [ &a ]( uimage& b ) { b.mirror( a, true, true, true, false, vec2f( -0.3f, 0.4f ) ); } },
+        { "turn up",          [ &a ]( uimage& b ) { b.turn( a, D4_UP ); } },
+        { "turn down",        [ &a ]( uimage& b ) { b.turn( a, D4_DOWN ); } },
+        { "flip x",           [ &a ]( uimage& b ) { b.flip( a, true, false ); } },
+        { "flip y",           [ &a ]( uimage& b ) { b.flip( a, false, true ); } },
+        { "flip xy",          [ &a ]( uimage& b ) { b.flip( a, true, true ); } },
+        { "flip none",        [ &a ]( uimage& b ) { b.flip( a, false, false ); } },
+        { "crop_circle",      [ &a ]( uimage& b ) { b.copy( a ); b.crop_circle( 0xff204060, 0.2f ); } },
+        { "checkerboard",     [ ]( uimage& b ) { b.checkerboard( 37, 0xffff0000, 0xff0000ff ); } }
+    };
+}
+
+// Row bands must give the same pixels as a single thread
+bool image_threads_test() {
+    uimage a( vec2i( 611, 419 ) );
+    for( auto& c : a ) c = rand_uint( gen ) | 0xff000000;
+    a.use_mip( true );
+    a.mip_it();
+    bool pass = true;
+    for( auto& op : row_ops( a ) ) {
+        std::vector< uimage > results;
+        for( int threads : { 1, 3, 8 } ) {
+            thread_pool::get().set_threads( threads );
+            uimage b( a.get_dim() );
+            for( auto& c : b ) c = 0xff808080;  // unwritten pixels must match too
+            op.second( b );
+            results.push_back( b );
+        }
+        for( int i = 1; i < results.size(); i++ ) {
+            bool same = std::equal( results[ 0 ].begin(), results[ 0 ].end(), results[ i ].begin() );
+            if( !same ) std::cout << "image_threads: " << op.first << " differs with thread count" << std::endl;
+            pass &= same;
+        }
+    }
+    // turned a quarter, the output is transposed
+    uimage t( vec2i( 419, 611 ) );
+    std::vector< uimage > turned;
+    for( direction4 d : { D4_LEFT, D4_RIGHT } ) {
+        for( int threads : { 1, 8 } ) {
+            thread_pool::get().set_threads( threads );
+            t.turn( a, d );
+            turned.push_back( t );
+        }
+    }
+    for( int i = 0; i < 4; i += 2 ) pass &= std::equal( turned[ i ].begin(), turned[ i ].end(), turned[ i + 1 ].begin() );
+    // a throwing task reaches the caller and the pool keeps working
+    thread_pool::get().set_threads( 8 );
+    for( int thrower : { 0, 37 } ) {
+        bool caught = false;
+        try { parallel_for( 64, [ & ]( int i ) { if( i == thrower ) throw std::runtime_error( "task" ); } ); }
+        catch( const std::runtime_error& ) { caught = true; }
+        std::atomic< int > count( 0 );
+        parallel_for( 64, [ & ]( int ) { count++; } );
+        pass &= caught && count == 64;
+    }
+    thread_pool::get().set_threads( 0 );
+    return pass;
+}
+
+// frgb arithmetic, gray, constrain and SRGB conversion kernels against the per pixel functions.
+// Odd widths leave tails for the scalar loops; the larger image runs in several bands
+bool fimage_ops_test() {
+    bool pass = true;
+    auto rnd = [ & ]() { return frgb( rand1( gen ) * 2.5f - 0.5f, rand1( gen ) * 2.5f - 0.5f, rand1( gen ) * 2.5f - 0.5f ); };
+    for( vec2i dim : { vec2i( 37, 23 ), vec2i( 301, 250 ) } ) {
+        fimage a( dim ), b( dim );
+        for( auto& c : a ) c = rnd();
+        for( auto& c : b ) c = rnd() + frgb( 1.0f, 1.0f, 1.0f );
+        std::vector< frgb > va( a.begin(), a.end() ), vb( b.begin(), b.end() );
+        frgb k = rnd() + frgb( 0.5f, 0.5f, 0.5f );
+        float s = 1.7f;
+        // operation on the image, expected result of one pixel
+        auto check = [ & ]( const std::string& name, const std::function< void ( fimage& ) >& op,
+                            const std::function< frgb ( const frgb&, const frgb& ) >& ref, float tolerance = 0.0f ) {
+            fimage c( a );
+            op( c );
+            int diffs = 0;
+            auto it = c.begin();
+            for( size_t i = 0; i < va.size(); i++, it++ ) {
+                frgb d = *it - ref( va[ i ], vb[ i ] );
+                if( linalg::maxelem( linalg::abs( d ) ) > tolerance ) diffs++;
+            }
+            if( diffs ) std::cout << "fimage_ops: " << name << " " << dim.x << "x" << dim.y << " " << diffs << " differences" << std::endl;
+            pass &= ( diffs == 0 );
+        };
+        check( "+= image", [ & ]( fimage& c ) { c += b; }, []( const frgb& x, const frgb& y ) { return x + y; } );
+        check( "-= image", [ & ]( fimage& c ) { c -= b; }, []( const frgb& x, const frgb& y ) { return x - y; } );
+        check( "*= image", [ & ]( fimage& c ) { c *= b; }, []( const frgb& x, const frgb& y ) { return x * y; } );
+        check( "/= image", [ & ]( fimage& c ) { c /= b; }, []( const frgb& x, const frgb& y ) { return x / y; } );
+        check( "+= color", [ & ]( fimage& c ) { c += k; }, [ & ]( const frgb& x, const frgb& ) { return x + k; } );
+        check( "-= color", [ & ]( fimage& c ) { c -= k; }, [ & ]( const frgb& x, const frgb& ) { return x - k; } );
+        check( "*= color", [ & ]( fimage& c ) { c *= k; }, [ & ]( const frgb& x, const frgb& ) { return x * k; } );
+        check( "/= color", [ & ]( fimage& c ) { c /= k; }, [ & ]( const frgb& x, const frgb& ) { return x / k; } );
+        check( "*= float", [ & ]( fimage& c ) { c *= s; }, [ & ]( const frgb& x, const frgb& ) { return x * s; } );
+        check( "/= float", [ & ]( fimage& c ) { c /= s; }, [ & ]( const frgb& x, const frgb& ) { return x / s; } );
+        check( "clamp", []( fimage& c ) { c.clamp( 0.0f, 1.0f ); }, []( const frgb& x, const frgb& ) { return linalg::clamp( x, 0.0f, 1.0f ); } );
+        check( "invert", []( fimage& c ) { c.invert(); }, []( const frgb& x, const frgb& ) { return invert( x ); } );
+        check( "constrain", []( fimage& c ) { c.constrain(); }, []( const frgb& x, const frgb& ) { frgb y = x; constrain( y ); return y; } );
+        check( "grayscale", []( fimage& c ) { c.grayscale(); }, []( const frgb& x, const frgb& ) { return gray( x ); }, 1.0e-5f );
+    }
+
+    // conversions, including values outside [0, 1] and NaN
+    std::vector< frgb > f( 1001 );
+    for( auto& c : f ) c = frgb( rand1( gen ) * 1.2f - 0.1f, rand1( gen ) * 0.001f, rand1( gen ) );
+    f[ 0 ] = frgb( 0.0f, 1.0f, std::nanf( "" ) );
+    f[ 1 ] = frgb( 0.00003f, 0.999999f, 2.0f );
+    std::vector< unsigned char > bytes( f.size() * 3 );
+    std::vector< unsigned int > u( f.size() );
+    frgb_to_bytes( bytes.data(), f.data(), f.size() );
+    frgb_to_ucolor( u.data(), f.data(), f.size() );
+    int diffs = 0;
+    for( size_t i = 2; i < f.size(); i++ ) {
+        diffs += ( bytes[ i * 3 ] != rc( f[ i ] ) ) + ( bytes[ i * 3 + 1 ] != gc( f[ i ] ) ) + ( bytes[ i * 3 + 2 ] != bc( f[ i ] ) );
+        diffs += ( u[ i ] != ( 0xff000000u | ( rc( f[ i ] ) << 16 ) | ( gc( f[ i ] ) << 8 ) | bc( f[ i ] ) ) );
+    }
+    diffs += ( bytes[ 0 ] != 0 ) + ( bytes[ 1 ] != 0xff ) + ( bytes[ 3 ] != 1 ) + ( bytes[ 5 ] != 0xff );
+    for( auto& c : u ) c = rand_uint( gen );
+    frgb_from_ucolor( f.data(), u.data(), f.size() );
+    for( size_t i = 0; i < f.size(); i++ ) diffs += ( f[ i ] != fsetu( u[ i ] ) );
+    if( diffs ) std::cout << "fimage_ops: conversion " << diffs << " differences" << std::endl;
+    return pass && diffs == 0;
+}
+
+// frgb kernels against the per pixel loops they replace, on one thread
+bool fimage_ops_bench() {
+    const int reps = 10;
+    const vec2i dim( 1920, 1080 );
+    fimage a( dim ), b( dim );
+    for( auto& c : a ) c = frgb( rand1( gen ), rand1( gen ), rand1( gen ) ) * 2.0f;
+    for( auto& c : b ) c = frgb( rand1( gen ), rand1( gen ), rand1( gen ) );
+    std::vector< unsigned char > bytes( dim.x * dim.y * 3 );
+    thread_pool::get().set_threads( 1 );
+    auto time = [ & ]( const std::function< void () >& f ) {
+        auto t0 = std::chrono::steady_clock::now();
+        for( int i = 0; i < reps; i++ ) f();
+        return std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - t0 ).count() / reps;
+    };
+    auto report = [ & ]( const std::string& name, double ms0, double ms1 ) {
+        std::cout << "fimage_ops_bench: " << name << " per pixel " << ms0 << " ms, kernel " << ms1 << " ms" << std::endl;
+    };
+    report( "+= image",
+        time( [ & ]() { std::transform( a.begin(), a.end(), b.begin(), a.begin(), []( const frgb& x, const frgb& y ) { return x + y; } ); } ),
+        time( [ & ]() { a += b; } ) );
+    report( "*= float",
+        time( [ & ]() { std::transform( a.begin(), a.end(), a.begin(), []( const frgb& x ) { return x * 0.999f; } ); } ),
+        time( [ & ]() { a *= 0.999f; } ) );
+    report( "*= color",
+        time( [ & ]() { std::transform( a.begin(), a.end(), a.begin(), []( const frgb& x ) { return x * frgb( 0.999f, 1.0f, 0.998f ); } ); } ),
+        time( [ & ]() { a *= frgb( 0.999f, 1.0f, 0.998f ); } ) );
+    report( "constrain",
+        time( [ & ]() { for( auto& c : a ) constrain( c ); } ),
+        time( [ & ]() { a.constrain(); } ) );
+    report( "grayscale",
+        time( [ & ]() { for( auto& c : b ) c = gray( c ); } ),
+        time( [ & ]() { b.grayscale(); } ) );
+    report( "to SRGB bytes",
+        time( [ & ]() { size_t i = 0; for( auto& c : a ) { bytes[ i++ ] = rc( c ); bytes[ i++ ] = gc( c ); bytes[ i++ ] = bc( c ); } } ),
+        time( [ & ]() { frgb_to_bytes( bytes.data(), a.get_base_ptr(), dim.x * dim.y ); } ) );
+    thread_pool::get().set_threads( 0 );
+    return true;
+}
+
+// Fused expressions and their reductions match the operators applied one at a time
+bool image_expr_test() {
+    static_assert( is_pix_operand< fimage > && is_pix_operand< vector_field > && !is_pix_operand< uimage >, "packed ucolor images take no part in expressions" );
+    bool pass = true;
+    for( vec2i dim : { vec2i( 37, 23 ), vec2i( 301, 250 ) } ) {
+        fimage a( dim ), b( dim ), c( dim ), d( dim );
+        for( auto& p : a ) p = frgb( rand1( gen ), rand1( gen ), rand1( gen ) );
+        for( auto& p : b ) p = frgb( rand1( gen ), rand1( gen ), rand1( gen ) );
+        for( auto& p : c ) p = frgb( rand1( gen ), rand1( gen ), rand1( gen ) );
+        // one pass per operator
+        fimage e( a ), half( a );
+        half *= 0.5f; e = half; e += b; e -= c;
+        d = a * 0.5f + b - c;
+        pass &= std::equal( d.begin(), d.end(), e.begin() );
+        // destination read inside its own expression
+        fimage f( a );
+        f = -( f * 2.0f ) / b;
+        auto it = a.begin();
+        auto bt = b.begin();
+        for( auto& p : f ) pass &= ( p == -( *it++ * 2.0f ) / *bt++ );
+
+        // reductions in the same pass, against a plain walk in pixel order
+        pix_sum< frgb > sum;
+        pix_min< frgb > lo;
+        pix_max< frgb > hi;
+        auto hist = histogram< frgb >( 16, []( const frgb& p ) { return (int)( gray( p ).x * 8.0f ); } );
+        assign( d, a + b, sum, lo, hi, hist );
+        frgb s( 0.0f, 0.0f, 0.0f ), mn = a.index( vec2i( 0, 0 ) ) + b.index( vec2i( 0, 0 ) ), mx = mn;
+        std::vector< unsigned int > counts( 16, 0 );
+        int n = 0;
+        it = a.begin(); bt = b.begin();
+        for( auto& p : d ) {
+            frgb q = *it++ + *bt++;
+            pass &= ( p == q );
+            s += q; mn = linalg::min( mn, q ); mx = linalg::max( mx, q );
+            counts[ std::clamp( (int)( gray( q ).x * 8.0f ), 0, 15 ) ]++;
+            n++;
+        }
+        pass &= linalg::maxelem( linalg::abs( sum.total - s ) ) < 1.0e-3f * n;
+        pass &= ( lo.result == mn ) && ( hi.result == mx ) && ( hist.counts == counts );
+        pix_sum< vec2f > vsum;
+        image< vec2f > v( dim );
+        for( auto& p : v ) p = vec2f( 1.0f, -2.0f );
+        reduce( v * 0.5f, dim, vsum );
+        pass &= ( vsum.total == vec2f( 0.5f, -1.0f ) * (float)( dim.x * dim.y ) );
+        if( !pass ) std::cout << "image_expr: mismatch at " << dim.x << "x" << dim.y << std::endl;
+    }
+
+    // turbulent field accumulated in one pass per vortex matches scale then add
+    image< vec2f > field( vec2i( 120, 80 ) ), expected( vec2i( 120, 80 ) );
+    vortex_field vf( 5 );
+    vf.generate();
+    vf_tools( field ).turbulent( vf );
+    expected.fill( vec2f( 0.0f, 0.0f ) );
+    image< vec2f > buffer( expected );
+    for( auto& vort : vf.vorts ) { vf_tools( buffer ).vortex( vort ); expected += buffer; }
+    pass &= std::equal( field.begin(), field.end(), expected.begin() );
+    return pass;
+}
+
+// One frame of an ephemeral effect list - copy the source, double-buffered effects, a temporary
+static void pool_frame( buffer_pair< ucolor >& src, buffer_pair< ucolor >& list ) {
+    list.copy_first( src );
+    for( int e = 0; e < 3; e++ ) {
+        list.get_buffer().copy( list.get_image() );
+        list.swap();
+    }
+    uimage tmp( list.get_image() );
+    fimage scratch( tmp.get_dim() );
+    scratch.fill( frgb( 0.5f ) );
+}
+
+bool pixel_pool_test() {
+    bool pass = true;
+    // classes cover their sizes with at most a quarter to spare
+    for( size_t n : { (size_t)1, (size_t)64, (size_t)65, (size_t)100, (size_t)4096, (size_t)4097, (size_t)921600, (size_t)8294400, (size_t)1 << 40 } ) {
+        size_t b = pixel_pool::class_bytes( pixel_pool::size_class( n ) );
+        pass &= ( b >= n && ( n <= 64 || b <= n + n / 4 ) );
+    }
+    for( size_t n = 1; n < 100000; n += 37 ) pass &= ( pixel_pool::size_class( n ) <= pixel_pool::size_class( n + 37 ) );
+    if( !pass ) std::cout << "pixel_pool: bad size classes" << std::endl;
+
+    vec2i dim( 640, 360 );
+    buffer_pair< ucolor > src( dim ), list;
+    for( auto& c : src.get_image() ) c = rand_uint( gen ) | 0xff000000;
+    pass &= ( ( (size_t)src.get_image().get_base_ptr() & 63 ) == 0 );
+    for( int i = 0; i < 2; i++ ) pool_frame( src, list );  // warm up
+
+    const int frames = 20;
+    pixel_pool::get().reset_stats();
+    size_t pixel_allocs = aligned_alloc_count, allocs = alloc_count;
+    for( int i = 0; i < frames; i++ ) pool_frame( src, list );
+    pixel_allocs = aligned_alloc_count - pixel_allocs;
+    allocs = alloc_count - allocs;
+    pixel_pool_stats st = pixel_pool::get().stats();
+    std::cout << "pixel_pool: " << frames << " frames " << st.hits << " hits " << st.misses << " misses " << pixel_allocs << " pixel allocations "
+              << allocs << " allocations " << st.bytes_live / 1024 << " KB live " << st.bytes_cached / 1024 << " KB cached" << std::endl;
+    pass &= ( allocs == 0 && pixel_allocs == 0 && st.misses == 0 && st.hits >= (size_t)frames );
+    pass &= ( list.get_image().get_dim() == dim && list.get_image().index( vec2i( 7, 5 ) ) == src.get_image().index( vec2i( 7, 5 ) ) );
+
+    pixel_pool::get().trim();
+    pass &= ( pixel_pool::get().stats().bytes_cached == 0 );
+    return pass;
+}
+
+// Reuse of both images by reset() and copy_first(), including the sequences that used to crash
+bool buffer_pair_test() {
+    bool pass = true;
+    vec2i dim( 64, 48 ), other( 32, 40 );
+    buffer_pair< ucolor > bp( dim );
+    for( auto& c : bp.get_image() ) c = rand_uint( gen ) | 0xff000000;
+    uimage* first = &bp.get_image();
+    uimage* second = &bp.get_buffer();
+    unsigned int gen0 = bp.get_generation();
+    pass &= ( bp.get_buffer().index( vec2i( 3, 4 ) ) == bp.get_image().index( vec2i( 3, 4 ) ) );
+    // reads through a const pair leave the version, write access and swaps move it
+    unsigned int v0 = bp.get_version();
+    pass &= ( std::as_const( bp ).get_image().index( vec2i( 3, 4 ) ) == bp.get_buffer().index( vec2i( 3, 4 ) ) && bp.get_version() == v0 );
+    bp.get_image();
+    pass &= ( bp.get_version() != v0 );
+    v0 = bp.get_version();
+    bp.swap();
+    bp.swap();
+    pass &= ( bp.get_version() != v0 );
+
+    // same size - same images, cleared, buffer refreshed from image
+    bp.swap();
+    bp.get_buffer().fill( ucolor( 0xffffffff ) );
+    bp.reset( dim );
+    pass &= ( !bp.is_swapped() && bp.get_generation() == gen0 );
+    pass &= ( ( &bp.get_image() == first || &bp.get_image() == second ) && bp.get_image().index( vec2i( 3, 4 ) ) == 0 );
+    pass &= ( bp.get_buffer().index( vec2i( 3, 4 ) ) == 0 && &bp.get_buffer() != &bp.get_image() );
+    // settings are reset too
+    bp.get_image().set_bounds( bb2f( { 0.0f, 0.0f }, { 3.0f, 2.0f } ) );
+    bp.get_image().use_mip( true );
+    bp.get_image().mip_it();
+    bp.reset( dim );
+    bb2f fresh_bounds = uimage( dim ).get_bounds();
+    pass &= ( bp.get_image().get_bounds().minv == fresh_bounds.minv && bp.get_image().get_bounds().maxv == fresh_bounds.maxv );
+    pass &= ( bp.get_image().get_mip_levels() == 1 );
+
+    // back buffer resized behind the pair's back, then reset to the original size
+    bp.get_buffer().copy( uimage( other ) );
+    bp.reset( dim );
+    pass &= ( bp.get_buffer().get_dim() == dim );
+    bp.get_buffer().fill( ucolor( 0xff00ff00 ) );  // would write past a stale smaller buffer
+
+    // new size - new generation, both images follow
+    bp.reset( other );
+    pass &= ( bp.get_generation() != gen0 && bp.get_image().get_dim() == other && bp.get_buffer().get_dim() == other );
+
+    // copy_first from a source of another size, from an empty source, and back
+    buffer_pair< ucolor > src( dim );
+    src.get_image().fill( ucolor( 0xff123456 ) );
+    unsigned int gen1 = bp.get_generation();
+    bp.copy_first( src );
+    pass &= ( bp.get_generation() != gen1 && bp.get_buffer().get_dim() == dim && bp.get_buffer().index( vec2i( 5, 5 ) ) == ucolor( 0xff123456 ) );
+    gen1 = bp.get_generation();
+    src.get_image().fill( ucolor( 0xff654321 ) );
+    bp.copy_first( src );
+    pass &= ( bp.get_generation() == gen1 && bp.get_buffer().index( vec2i( 5, 5 ) ) == ucolor( 0xff654321 ) );
+    buffer_pair< ucolor > empty;
+    bp.copy_first( empty );
+    pass &= ( !bp.has_image() && bp.get_generation() != gen1 );
+    bp.swap();  // nothing to swap
+    bp.copy_first( src );
+    pass &= ( bp.has_image() && bp.get_image().get_dim() == dim );
+    // swap with a stale buffer leaves the image in front, the buffer is refreshed when asked for
+    bp.get_buffer();
+    src.get_image().fill( ucolor( 0xff0000ff ) );
+    bp.copy_first( src );
+    uimage* front = &bp.get_image();
+    bp.swap();
+    pass &= ( &bp.get_image() == front && bp.get_image().index( vec2i( 5, 5 ) ) == ucolor( 0xff0000ff ) );
+    pass &= ( bp.get_buffer().index( vec2i( 5, 5 ) ) == ucolor( 0xff0000ff ) );
+
+    // swap before the buffer exists keeps an image in front
+    buffer_pair< ucolor > fresh( dim );
+    fresh.get_image().fill( ucolor( 0xff0000ff ) );
+    fresh.swap();
+    pass &= ( fresh.has_image() && fresh.get_image().index( vec2i( 1, 1 ) ) == ucolor( 0xff0000ff ) );
+
+    bool threw = false;
+    try { empty.get_buffer(); } catch( std::runtime_error& ) { threw = true; }
+    pass &= threw;
+    return pass;
+}
+
+// Copies share pixels until one side writes - also when bands of a shared image are written in parallel
+bool copy_on_write_test() {
+    bool pass = true;
+    vec2i dim( 300, 260 );
+    uimage a( dim );
+    for( auto& c : a ) c = rand_uint( gen ) | 0xff000000;
+    ucolor a0 = a.index( 0 );
+    uimage b( a ), c;
+    c = a;
+    pass &= ( a.shared() && b.shared() && std::as_const( b ).get_base_ptr() == std::as_const( a ).get_base_ptr() );
+    // reads leave the pixels shared
+    pass &= ( b.size() == a.size() && b.index( vec2i( 299, 259 ) ) == a.index( vec2i( 299, 259 ) ) && b.shared() );
+    b.set( 0, ~a0 );
+    pass &= ( !b.shared() && c.shared() && a.index( 0 ) == a0 && c.index( 0 ) == a0 && b.index( 0 ) == ~a0 );
+    pass &= ( b.index( vec2i( 299, 259 ) ) == a.index( vec2i( 299, 259 ) ) );
+
+    // bands written on several threads into a shared image
+    thread_pool::get().set_threads( 4 );
+    uimage d( a );
+    d.flip( a, true, true );
+    thread_pool::get().set_threads( 0 );
+    bool flipped = !d.shared();
+    for( int y = 0; y < dim.y; y++ ) for( int x = 0; x < dim.x; x++ )
+        flipped &= ( d.index( vec2i( x, y ) ) == a.index( vec2i( dim.x - 1 - x, dim.y - 1 - y ) ) );
+    pass &= flipped && ( a.index( 0 ) == a0 );
+
+    // ephemeral list copying its source each frame
+    vec2i frame( 1920, 1080 );
+    buffer_pair< ucolor > src( frame ), list( frame );
+    src.get_image().fill( ucolor( 0xff336699 ) );
+    list.copy_first( src );
+    pixel_pool::get().reset_stats();
+    const int frames = 20;
+    auto t0 = std::chrono::steady_clock::now();
+    for( int i = 0; i < frames; i++ ) list.copy_first( src );
+    double shared_ms = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - t0 ).count() / frames;
+    pixel_pool_stats st = pixel_pool::get().stats();
+    pass &= ( list.get_image().shared() && st.hits + st.misses == 0 );
+    t0 = std::chrono::steady_clock::now();
+    for( int i = 0; i < frames; i++ ) { list.copy_first( src ); list.get_image().set( 0, black< ucolor > ); }
+    double written_ms = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - t0 ).count() / frames;
+    pass &= ( src.get_image().index( 0 ) == ucolor( 0xff336699 ) && !list.get_image().shared() );
+    std::cout << "copy_on_write: 1920x1080 copy_first " << shared_ms << " ms shared, " << written_ms << " ms with a write" << std::endl;
+    return pass;
+}
+
+// Chain of three operators as separate passes and as one expression, on one thread
+bool image_expr_bench() {
+    const int reps = 10;
+    const vec2i dim( 1920, 1080 );
+    fimage a( dim ), b( dim ), c( dim ), d( dim );
+    for( auto& p : a ) p = frgb( rand1( gen ), rand1( gen ), rand1( gen ) );
+    b = a; c = a;
+    thread_pool::get().set_threads( 1 );
+    auto t0 = std::chrono::steady_clock::now();
+    for( int i = 0; i < reps; i++ ) { d = a; d *= 0.5f; d += b; d -= c; }
+    auto t1 = std::chrono::steady_clock::now();
+    for( int i = 0; i < reps; i++ ) d = a * 0.5f + b - c;
+    auto t2 = std::chrono::steady_clock::now();
+    pix_sum< frgb > sum;
+    pix_max< frgb > hi;
+    for( int i = 0; i < reps; i++ ) assign( d, a * 0.5f + b - c, sum, hi );
+    auto t3 = std::chrono::steady_clock::now();
+    auto ms = [ & ]( auto u, auto v ) { return std::chrono::duration< double, std::milli >( v - u ).count() / reps; };
+    std::cout << "image_expr_bench: d = a * 0.5 + b - c 1920x1080 operators " << ms( t0, t1 ) << " ms, expression " << ms( t1, t2 )
+              << " ms, with sum and max " << ms( t2, t3 ) << " ms" << std::endl;
+    thread_pool::get().set_threads( 0 );
+    return true;
+}
+
+// Scaling of row-parallel operations from one thread to the hardware thread count
+bool image_threads_bench() {
+    const int reps = 5;
+    uimage a( vec2i( 1920, 1080 ) );
+    for( auto& c : a ) c = rand_uint( gen ) | 0xff000000;
+    a.use_mip( true );
+    a.mip_it();
+    uimage b( a.get_dim() );
+    int max_threads = std::max( (int)std::thread::hardware_concurrency(), 2 );
+    std::vector< int > counts;
+    for( int threads = 1; threads < max_threads; threads *= 2 ) counts.push_back( threads );
+    counts.push_back( max_threads );
+    for( auto& op : row_ops( a ) ) {
+        std::cout << "image_threads_bench: " << op.first;
+        for( int threads : counts ) {
+            thread_pool::get().set_threads( threads );
+            op.second( b );   // warm up workers
+            auto t0 = std::chrono::steady_clock::now();
+            for( int i = 0; i < reps; i++ ) op.second( b );
+            double ms = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - t0 ).count() / reps;
+            std::cout << " - " << threads << ( threads == 1 ? " thread " : " threads " ) << ms << " ms";
+        }
+        std::cout << std::endl;
+    }
+    thread_pool::get().set_threads( 0 );
+    return true;
+}
+
+// Throughput of each rule in megapixels per second
+bool ca_bench() {
+    const vec2i dim( 1024, 1024 );
+    const int frames = 10;
+    scene s;
+    std::vector< any_rule > rules = {
+        make_rule( std::make_shared< rule_life< ucolor > >(), "life" ),
+        make_rule( std::make_shared< rule_random_copy< ucolor > >(), "random_copy" ),
+        make_rule( std::make_shared< rule_random_mix< ucolor > >(), "random_mix" ),
+        make_rule( std::make_shared< rule_box_blur< ucolor > >(), "box_blur" ),
+        make_rule( std::make_shared< rule_diffuse< ucolor > >(), "diffuse" ),
+        make_rule( std::make_shared< rule_gravitate< ucolor > >(), "gravitate" ),
+        make_rule( std::make_shared< rule_snow< ucolor > >(), "snow" ),
+        make_rule( std::make_shared< rule_pixel_sort< ucolor > >(), "pixel_sort" ),
+        make_rule( std::make_shared< rule_funky_sort< ucolor > >(), "funky_sort" ),
+        make_rule( std::make_shared< rule_diagonal_funky_sort< ucolor > >(), "diagonal_funky_sort" )
+    };
+    for( auto& rule : rules ) {
+        ubuf_ptr buf = std::make_shared< buffer_pair< ucolor > >( dim );
+        any_buffer_pair_ptr any_buf = buf;
+        if( rule.name == "life" ) life_soup( buf ); else color_soup( buf );
+        element_context context( s, any_buf );
+        CA< ucolor > ca;
+        ca.rule = rule;
+        ca( any_buf, context ); ca( any_buf, context ); // warm up
+        auto start = std::chrono::steady_clock::now();
+        for( int i = 0; i < frames; i++ ) ca( any_buf, context );
+        std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "ca_bench: " << rule.name << " " << thread_pool::get().threads() << " threads " << (double)dim.x * dim.y * frames / elapsed.count() / 1.0e6 << " MP/s" << std::endl;
+    }
+    return true;
+}
+
+// named tests and benchmarks - image_test <name> returns nonzero on failure
+std::map< std::string, std::function< bool () > > tests = {
+    { "ca_alloc", ca_alloc_bench },
+    { "ca_moore", ca_moore_test },
+    { "ca_threads", ca_threads_test },
+    { "ca_funky", ca_funky_test },
+    { "ca_life_bits", ca_life_bits_test },
+    { "ca_advance", ca_advance_test },
+    { "ca_track", ca_track_test },
+    { "ca_target", ca_target_test },
+    { "hsv", hsv_test },
+    { "mip_copy", mip_copy_test },
+    { "mip_dirty", mip_dirty_test },
+    { "mip_simd", mip_simd_test },
+    { "splat_rows", splat_rows_test },
+    { "log", log_test },
+    { "image_threads", image_threads_test },
+    { "warp_coords", warp_coords_test },
+    { "sampler", sampler_test },
+    { "sampler_fixed", sampler_fixed_test },
+    { "fimage_ops", fimage_ops_test },
+    { "pixel_pool", pixel_pool_test },
+    { "buffer_pair", buffer_pair_test },
+    { "copy_on_write", copy_on_write_test },
+    { "image_expr", image_expr_test },
+    { "hsv_bench", hsv_bench },
+    { "mip_bench", mip_bench },
+    { "image_threads_bench", image_threads_bench },
+    { "warp_bench", warp_bench },
+    { "fimage_ops_bench", fimage_ops_bench },
+    { "image_expr_bench", image_expr_bench },
+    { "ca_bench", ca_bench }
+};
+
 int main(int argc, char* argv[]) {
     
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <input_filename>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <input_filename> | <test name> | all" << std::endl;
         return 1;
     }
 
     std::string input_filename = argv[1]; 
 
+    if( input_filename == "all" ) {
+        bool pass = true;
+        for( auto& t : tests ) {
+            bool ok = t.second();
+            std::cout << t.first << ( ok ? " PASS" : " FAIL" ) << std::endl;
+            pass &= ok;
+        }
+        return pass ? 0 : 1;
+    }
+    if( tests.contains( input_filename ) ) {
+        bool ok = tests[ input_filename ]();
+        std::cout << input_filename << ( ok ? " PASS" : " FAIL" ) << std::endl;
+        return ok ? 0 : 1;
+    }
+
     read_write_image(input_filename);
     //copy_any_buffer( input_filename );
     //splat_test();
@@ -0,0 +1,100 @@
+// Leveled logging by category
+// JOY_LOG( level, category, stream expression ) - messages below JOY_LOG_LEVEL compile to nothing,
+// so their arguments are never evaluated. Debug and trace messages are also filtered at run time
+// by a category mask, off by default - turn categories on with log_enable(). Info and above
+// always print when compiled in. Warnings and errors go to std::cerr, the rest to std::cout.
+
+#ifndef __JOY_LOG_HPP
+#define __JOY_LOG_HPP
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <atomic>
+
+enum log_level {
+    JOY_TRACE,      // per pixel or per row - never in optimized builds
+    JOY_DEBUG,      // per call or per frame
+    JOY_INFO,       // occasional state changes - loading, resizing
+    JOY_WARN,
+    JOY_ERROR,
+    JOY_SILENT      // as JOY_LOG_LEVEL, compiles out all messages
+};
+
+enum log_category : unsigned int {
+    LOG_IMAGE   = 1 << 0,
+    LOG_MIP     = 1 << 1,
+    LOG_SPLAT   = 1 << 2,
+    LOG_BUFFER  = 1 << 3,
+    LOG_CA      = 1 << 4,
+    LOG_SCENE   = 1 << 5,
+    LOG_UI      = 1 << 6,
+    LOG_VIDEO   = 1 << 7,
+    LOG_CAMERA  = 1 << 8,
+    LOG_AUDIO   = 1 << 9,
+    LOG_ALL     = 0xffffffff
+};
+
+// Lowest level compiled in. Optimized builds keep info and above unless overridden with -DJOY_LOG_LEVEL=
+#ifndef JOY_LOG_LEVEL
+#if defined( NDEBUG ) || defined( __OPTIMIZE__ )
+#define JOY_LOG_LEVEL JOY_INFO
+#else
+#define JOY_LOG_LEVEL JOY_TRACE
+#endif
+#endif
+
+// categories printing debug and trace messages
+inline std::atomic< unsigned int > log_categories{ 0 };
+
+inline void log_enable( unsigned int categories, bool on = true ) {
+    if( on ) log_categories |= categories;
+    else     log_categories &= ~categories;
+}
+
+inline bool log_enabled( log_level level, unsigned int category ) {
+    return level >= JOY_INFO || ( log_categories.load( std::memory_order_relaxed ) & category );
+}
+
+inline const char* log_category_name( unsigned int category ) {
+    switch( category ) {
+        case LOG_IMAGE:  return "image";
+        case LOG_MIP:    return "mip";
+        case LOG_SPLAT:  return "splat";
+        case LOG_BUFFER: return "buffer";
+        case LOG_CA:     return "CA";
+        case LOG_SCENE:  return "scene";
+        case LOG_UI:     return "UI";
+        case LOG_VIDEO:  return "video";
+        case LOG_CAMERA: return "camera";
+        case LOG_AUDIO:  return "audio";
+        default:         return "";
+    }
+}
+
+// message is assembled first so lines from worker threads don't interleave
+inline void log_write( log_level level, unsigned int category, const std::string& msg ) {
+    std::ostream& os = ( level >= JOY_WARN ) ? std::cerr : std::cout;
+    std::string line;
+    if( level == JOY_WARN )  line = "Warning: ";
+    if( level == JOY_ERROR ) line = "Error: ";
+    if( level <= JOY_DEBUG ) line = std::string( "[" ) + log_category_name( category ) + "] ";
+    line += msg;
+    line += '\n';
+    os << line << std::flush;
+}
+
+// true if a message would print - guards work done only to build a message
+#define JOY_LOG_ON( level, category ) ( ( level ) >= JOY_LOG_LEVEL && log_enabled( ( level ), ( category ) ) )
+
+#define JOY_LOG( level, category, msg ) do {                                    \
+    if constexpr( ( level ) >= JOY_LOG_LEVEL ) {                               \
+        if( log_enabled( ( level ), ( category ) ) ) {                         \
+            std::ostringstream joy_log_os;                                     \
+            joy_log_os << msg;                                                 \
+            log_write( ( level ), ( category ), joy_log_os.str() );            \
+        }                                                                      \
+    }                                                                          \
+} while( 0 )
+
+#endif // __JOY_LOG_HPP
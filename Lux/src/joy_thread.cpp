@@ -0,0 +1,119 @@
+#include "joy_thread.hpp"
+
+// true on pool threads, and on the caller while it runs a job - nested calls run serially
+static thread_local bool in_pool = false;
+
+thread_pool& thread_pool::get() {
+    static thread_pool pool;
+    return pool;
+}
+
+// a throw drops the tasks not yet handed out
+void thread_pool::work() {
+    try {
+        for( int i = next++; i < ntasks; i = next++ ) task( data, i );
+    }
+    catch( ... ) {
+        next = ntasks;
+        throw;
+    }
+}
+
+#ifdef JOY_SERIAL
+
+thread_pool::thread_pool( int n ) : nthreads( 1 ), task( nullptr ), data( nullptr ), ntasks( 0 ), next( 0 ) {}
+
+thread_pool::~thread_pool() {}
+
+void thread_pool::set_threads( int n ) {}
+
+void thread_pool::run( int n, task_fn f, void* d ) {
+    for( int i = 0; i < n; i++ ) f( d, i );
+}
+
+#else
+
+thread_pool::thread_pool( int n ) : task( nullptr ), data( nullptr ), ntasks( 0 ), next( 0 ), job_id( 0 ), pending( 0 ), stop( false ) {
+    set_threads( n );
+}
+
+thread_pool::~thread_pool() { finish(); }
+
+void thread_pool::set_threads( int n ) {
+    std::lock_guard< std::mutex > run_lock( run_mutex );
+    finish();
+    if( n <= 0 ) n = std::thread::hardware_concurrency();
+    if( n <= 0 ) n = 1;
+    nthreads = n;
+    // workers are started on first use
+}
+
+void thread_pool::start() {
+    stop = false;
+    for( int i = 1; i < nthreads; i++ ) workers.emplace_back( &thread_pool::worker, this, job_id );
+}
+
+void thread_pool::finish() {
+    {
+        std::lock_guard< std::mutex > lock( m );
+        stop = true;
+    }
+    work_cv.notify_all();
+    for( auto& w : workers ) w.join();
+    workers.clear();
+}
+
+void thread_pool::worker( unsigned long long seen ) {
+    in_pool = true;
+    for( ;; ) {
+        {
+            std::unique_lock< std::mutex > lock( m );
+            work_cv.wait( lock, [ & ] { return stop || job_id != seen; } );
+            if( stop ) return;
+            seen = job_id;
+        }
+        std::exception_ptr e;
+        try { work(); }
+        catch( ... ) { e = std::current_exception(); }
+        {
+            std::lock_guard< std::mutex > lock( m );
+            if( e && !error ) error = e;
+            if( --pending == 0 ) done_cv.notify_one();
+        }
+    }
+}
+
+void thread_pool::run( int n, task_fn f, void* d ) {
+    if( n <= 0 ) return;
+    if( nthreads <= 1 || n == 1 || in_pool ) {
+        for( int i = 0; i < n; i++ ) f( d, i );
+        return;
+    }
+    std::lock_guard< std::mutex > run_lock( run_mutex );
+    if( workers.empty() ) start();
+    {
+        std::lock_guard< std::mutex > lock( m );
+        task = f; data = d; ntasks = n; next = 0;
+        pending = workers.size();
+        error = nullptr;
+        job_id++;
+    }
+    work_cv.notify_all();
+    // workers may still be running the job when the caller's share throws
+    struct job_guard {
+        thread_pool& pool;
+        job_guard( thread_pool& p ) : pool( p ) { in_pool = true; }
+        ~job_guard() {
+            in_pool = false;
+            std::unique_lock< std::mutex > lock( pool.m );
+            pool.done_cv.wait( lock, [ & ] { return pool.pending == 0; } );
+        }
+    };
+    {
+        job_guard guard( *this );
+        work();
+    }
+    if( error ) std::rethrow_exception( std::exchange( error, nullptr ) );
+}
+
+#endif // JOY_SERIAL
@@ -0,0 +1,82 @@
+// Persistent worker pool shared by CA and image operations
+// parallel_for() hands out task indices to the workers and the calling thread
+// parallel_rows() splits an image into bands of rows for it
+// A task that throws stops the job - the first exception is rethrown on the calling thread
+
+#ifndef __JOY_THREAD_HPP
+#define __JOY_THREAD_HPP
+
+#include <vector>
+#include <atomic>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
+#include <exception>
+
+// Emscripten builds without -pthread run everything on the calling thread
+#if defined( __EMSCRIPTEN__ ) && !defined( __EMSCRIPTEN_PTHREADS__ )
+#define JOY_SERIAL
+#endif
+
+#ifndef JOY_SERIAL
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+class thread_pool {
+    typedef void ( *task_fn )( void* data, int i );
+
+    int nthreads;                 // total threads including caller
+    task_fn task;                 // current job
+    void* data;
+    int ntasks;
+    std::atomic< int > next;      // next task index to hand out
+#ifndef JOY_SERIAL
+    std::vector< std::thread > workers;
+    std::mutex m, run_mutex;
+    std::condition_variable work_cv, done_cv;
+    unsigned long long job_id;
+    int pending;                  // workers still busy with current job
+    bool stop;
+    std::exception_ptr error;     // first exception thrown by a worker during the current job
+
+    void worker( unsigned long long seen );
+    void start();
+    void finish();
+#endif
+    void work();
+    void run( int n, task_fn f, void* d );
+
+public:
+    static thread_pool& get();    // shared pool, sized to hardware concurrency
+
+    int threads() const { return nthreads; }
+    void set_threads( int n );    // n <= 0 uses hardware concurrency
+
+    // calls f( i ) for i in [0, n) - order and thread assignment unspecified
+    template< class F > void parallel_for( int n, F&& f ) {
+        run( n, []( void* d, int i ) { ( *static_cast< std::remove_reference_t< F >* >( d ) )( i ); }, &f );
+    }
+
+    thread_pool( int n = 0 );
+    ~thread_pool();
+};
+
+template< class F > void parallel_for( int n, F&& f ) { thread_pool::get().parallel_for( n, std::forward< F >( f ) ); }
+
+// Images smaller than this many pixels are cheaper to process on the calling thread
+static const int parallel_min_pixels = 1 << 16;
+
+// calls f( y0, y1 ) on bands of rows covering [0, rows) - in parallel if rows * cols reaches min_pixels.
+// A few bands per thread keeps the load even when rows cost different amounts
+template< class F > void parallel_rows( int rows, int cols, F&& f, int min_pixels = parallel_min_pixels ) {
+    int nthreads = thread_pool::get().threads();
+    if( rows <= 0 ) return;
+    if( nthreads <= 1 || (long long)rows * cols < min_pixels ) { f( 0, rows ); return; }
+    int band_rows = ( rows + nthreads * 4 - 1 ) / ( nthreads * 4 );
+    int bands = ( rows + band_rows - 1 ) / band_rows;
+    parallel_for( bands, [ & ]( int band ) { f( band * band_rows, std::min( ( band + 1 ) * band_rows, rows ) ); } );
+}
+
+#endif // __JOY_THREAD_HPP
@@ -3,6 +3,9 @@
 #include "ucolor.hpp"
 #include "vect2.hpp"
 #include "scene.hpp"
+#include "joy_thread.hpp"
+#include "life_simd.hpp"
+#include "joy_log.hpp"
 
 // Moore neighborhood shortcuts
 // First eight rotate counterclockwise from upper middle
@@ -63,11 +66,147 @@
 }
 */
 
+// mixes seed, frame and tile index into the seed of a tile's random stream
+static unsigned int tile_seed( unsigned int seed, int frame, int tile ) {
+    unsigned long long z = ( (unsigned long long)seed << 32 ) ^ ( (unsigned long long)frame << 16 ) ^ (unsigned long long)tile;
+    z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;   // splitmix64 finalizer
+    z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+    return (unsigned int)( z ^ ( z >> 31 ) );
+}
+
+// seeds each tile's random stream for this frame
+template< class T > void CA< T >::init_tiles( int ntiles ) {
+    tiles.resize( ntiles );
+    for( int i = 0; i < ntiles; i++ ) tiles[ i ].gen.seed( tile_seed( seed, ca_frame, i ) );
+}
+
+// Sets up vector kernel for rules that have one
+// returns 0 - none, 1 - funky sort, 2 - diagonal funky sort
+template< class R > static int vector_kernel( R& r, funky_kernel& k ) { return 0; }
+
+static int vector_kernel( rule_funky_sort< ucolor >& r, funky_kernel& k ) {
+    k = { (int)*r.direction, *r.max_diff, *r.dafunk_l, *r.dafunk_r };
+    return 1;
+}
+
+static int vector_kernel( rule_diagonal_funky_sort< ucolor >& r, funky_kernel& k ) {
+    k = { (int)*r.direction, *r.max_diff, *r.dafunk_d, 0 };
+    return 2;
+}
+
+// Mixes parameters of deterministic rules into key
+// Rules that use random numbers return false - their settled regions can still change
+static void mix_key( unsigned long long& key, unsigned long long v ) { key = ( key ^ v ) * 0x100000001b3ull; }
+
+template< class R > static bool rule_key( R& r, unsigned long long& key ) { return false; }
+
+template< class T > static bool rule_key( rule_identity< T >& r, unsigned long long& key ) { return true; }
+
+template< class T > static bool rule_key( rule_life< T >& r, unsigned long long& key ) {
+    mix_key( key, *r.on ); mix_key( key, *r.off ); mix_key( key, r.use_threshold ); mix_key( key, *r.threshold );
+    return true;
+}
+
+template< class T > static bool rule_key( rule_gravitate< T >& r, unsigned long long& key ) {
+    mix_key( key, *r.direction );
+    return true;
+}
+
+template< class T > static bool rule_key( rule_snow< T >& r, unsigned long long& key ) {
+    mix_key( key, *r.direction );
+    return true;
+}
+
+template< class T > static bool rule_key( rule_pixel_sort< T >& r, unsigned long long& key ) {
+    mix_key( key, *r.direction ); mix_key( key, *r.max_diff );
+    return true;
+}
+
+template< class T > static bool rule_key( rule_funky_sort< T >& r, unsigned long long& key ) {
+    mix_key( key, *r.direction ); mix_key( key, *r.max_diff ); mix_key( key, *r.dafunk_l ); mix_key( key, *r.dafunk_r );
+    return true;
+}
+
+template< class T > static bool rule_key( rule_diagonal_funky_sort< T >& r, unsigned long long& key ) {
+    mix_key( key, *r.direction ); mix_key( key, *r.max_diff ); mix_key( key, *r.dafunk_d );
+    return true;
+}
+
+// Returns target with inversion and hue rotation applied. Moore rules compare in HSV, the
+// Margolus family converts the rotated target back to RGB. The plane is kept between frames
+// and rebuilt only if the source buffer, its version or the transform differ from last time.
+// Self (no source) changes every frame and is always rebuilt
+template< class T > const T* CA< T >::transform_target( const std::shared_ptr< buffer_pair< T > >& source, const T* tar, const vec2i& tar_dim, bool inverted, unsigned int rotation, bool hsv ) {
+    size_t n = (size_t)tar_dim.x * tar_dim.y;
+    unsigned int form = rotation | ( inverted ? 1 : 0 ) | ( hsv ? 2 : 0 );
+    if( source && form == target_form && target_plane.size() == n && target_version == source->get_version() && target_pair.lock() == source ) 
+        return target_plane.data();
+    target_form = form;
+    target_pair = source;
+    if( source ) target_version = source->get_version();
+    target_plane.resize( n );
+    int nbands = ( tar_dim.y + tile_rows - 1 ) / tile_rows;
+    parallel_for( nbands, [ & ]( int band ) {
+        size_t end = std::min( (size_t)( band + 1 ) * tile_rows * tar_dim.x, n );
+        for( size_t i = (size_t)band * tile_rows * tar_dim.x; i < end; i++ ) {
+            ucolor t = tar[ i ];
+            if( inverted ) invert( t );
+            if( rotation != 0 ) {
+                t = rotate_hue( rgb_to_hsv( t ), rotation );
+                if( !hsv ) t = hsv_to_rgb( t );
+            }
+            target_plane[ i ] = t;
+        }
+    } );
+    return target_plane.data();
+}
+
+// Chooses regions to skip this frame. A region is skipped if every region around it has gone
+// period frames (one cycle of block offsets) without change, and the image still matches the
+// back buffer there - so the rule would reproduce the back buffer, which already holds the result.
+// Anything that breaks the history (other buffers, new parameters, outside edits) starts it over
+template< class T > void CA< T >::plan_regions( const vec2i& grid, int period, bool tracking, unsigned long long key, const T* in, const T* out ) {
+    int n = grid.x * grid.y;
+    bool same_buffers = ( in == track_front && out == track_back ) || ( in == track_back && out == track_front );
+    if( !tracking || grid != regions || key != track_key || !same_buffers ) {
+        regions = grid;
+        quiet.assign( n, 0 );
+    }
+    idle.assign( n, 0 );
+    changed.assign( n, 0 );
+    track_key = key;
+    if( !tracking ) return;
+
+    // settled regions edited since last frame start over
+    parallel_for( grid.y, [ & ]( int ry ) {
+        int y1 = std::min( ( ry + 1 ) * tile_rows, dim.y );
+        for( int rx = 0; rx < grid.x; rx++ ) {
+            unsigned char& q = quiet[ ry * grid.x + rx ];
+            if( q < period ) continue;
+            int x0 = rx * region_cols, x1 = std::min( x0 + region_cols, dim.x );
+            for( int y = ry * tile_rows; y < y1 && q; y++ ) 
+                if( !std::equal( in + y * dim.x + x0, in + y * dim.x + x1, out + y * dim.x + x0 ) ) q = 0;
+        }
+    } );
+    for( int ry = 0; ry < grid.y; ry++ ) {
+        for( int rx = 0; rx < grid.x; rx++ ) {
+            bool settled = true;
+            for( int dy = -1; dy <= 1 && settled; dy++ )
+                for( int dx = -1; dx <= 1 && settled; dx++ )
+                    settled = quiet[ ( ( ry + dy + grid.y ) % grid.y ) * grid.x + ( rx + dx + grid.x ) % grid.x ] >= period;
+            idle[ ry * grid.x + rx ] = settled;
+        }
+    }
+}
+
 // evaluates conditions then executes rule
-template< class T > void CA< T >::run_rule() {
+// R is the concrete rule type, so the call below is direct and can be inlined
+template< class T > template< class R > void CA< T >::run_rule( CA_tile< T >& t, R& r ) {
+    auto& neighbors = t.neighbors;
+    auto& result = t.result;
     bool block = false;
-    if( *p < 1.0f ) if( rand1( gen ) > *p ) block = true;
-    if( *edge_block ) if( x <= 0 || x >= dim.x - 1 || y <= 0 || y >= dim.y - 1 ) block = true;
+    if( *p < 1.0f ) if( rand1( t.gen ) > *p ) block = true;
+    if( *edge_block ) if( t.x <= 0 || t.x >= dim.x - 1 || t.y <= 0 || t.y >= dim.y - 1 ) block = true;
     //if( alpha_block ) 
     //if(image_block)
     if( *bright_block ) {
@@ -84,15 +223,17 @@ template< class T > void CA< T >::run_rule() {
     }
     if( block ) {
         if( hood == HOOD_MOORE) result[ 0 ] = MM;
-        else result = neighbors; // Margolus family assumed
+        else std::copy_n( neighbors.begin(), 4, result.begin() ); // Margolus family assumed
     }
     else {
-        rule( *this );
+        r( t );
     }
 }
 
 // future - implement multiresolution rule on mip-map
 // Uses toroidal boundary conditions
+// Image is split into bands of tile_rows rows which run in parallel, each with its own random stream.
+// Output depends only on seed and frame, not on thread count
 template< class T > void CA< T >::operator() ( any_buffer_pair_ptr& buf, element_context& context ) {
     if( ca_frame == 0 ) {
         ca_frame++;
@@ -107,16 +248,17 @@ template< class T > void CA< T >::operator() ( any_buffer_pair_ptr& buf, element
     unsigned int target_byte_rotation = static_cast<unsigned int>(static_cast<int>( std::floor( *target_color_angle / 360.0f * 256.0f + 0.5f ) ) % 256) << 16;
     hood = rule.init( context );
     if ( std::holds_alternative< std::shared_ptr< buffer_pair< T > > >( buf ) ) {
-        auto buf_ptr = std::get< std::shared_ptr< buffer_pair< T > > >( buf ); 
-        auto tar_ptr = buf_ptr;
+        auto& buf_ptr = std::get< std::shared_ptr< buffer_pair< T > > >( buf ); 
         if( !buf_ptr->has_image() ) throw std::runtime_error( "CA: no image buffer" );
-        auto img = buf_ptr->get_image();
-        auto in =  img.begin();
-        auto out = buf_ptr->get_buffer().begin();
-        auto tar = in;
+        // borrow front and back images - a generation reads each source pixel in place and writes the back buffer directly
+        T* out = buf_ptr->get_buffer().get_base_ptr();   // creates back buffer on first frame only
+        const image< T >& img = buf_ptr->get_image();
+        const T* in = img.get_base_ptr();
+        const T* tar = in;
         bool use_target = false; // *targeted == true and target is valid image
+        std::shared_ptr< buffer_pair< T > > tar_pair;   // target buffer unless Self
         bool use_wf = false;
-        std::vector<int>::iterator wf;
+        const int* wf = nullptr;
 
         dim = img.get_dim();
         vec2i tar_dim;
@@ -130,147 +272,197 @@ template< class T > void CA< T >::operator() ( any_buffer_pair_ptr& buf, element
             }
             else {
                 if( context.s.buffers.contains( *target_name ) ) {
-                    any_buffer_pair_ptr target = context.s.buffers[ *target_name ];
+                    any_buffer_pair_ptr& target = context.s.buffers[ *target_name ];
                     if( std::holds_alternative< std::shared_ptr< buffer_pair< T > > >( target ) ) {
-                        tar_ptr = std::get<     std::shared_ptr< buffer_pair< T > > >( target );
+                        auto& tar_ptr = std::get<     std::shared_ptr< buffer_pair< T > > >( target );
                         if( tar_ptr.get() ) {   // check for null pointer
                             if( tar_ptr->has_image() ) {
-                                tar_dim = tar_ptr->get_image().get_dim();
-                                tar = tar_ptr->get_image().begin();
+                                // read only - leaves the target's version alone
+                                const image< T >& tar_img = std::as_const( *tar_ptr ).get_image();
+                                tar_dim = tar_img.get_dim();
+                                tar = tar_img.get_base_ptr();
+                                tar_pair = tar_ptr;
                                 use_target = true;  // target image is valid
                             }
                             else {
-                                std::cout << "CA: target buffer has no image" << std::endl;
+                                JOY_LOG( JOY_DEBUG, LOG_CA, "CA: target buffer has no image" );
                             }
                         }
                         else {
-                            std::cout << "CA: target buffer is null" << std::endl;
+                            JOY_LOG( JOY_DEBUG, LOG_CA, "CA: target buffer is null" );
                         }
                     } else {
-                        std::cout << "CA: target buffer type mismatch" << std::endl;
+                        JOY_LOG( JOY_DEBUG, LOG_CA, "CA: target buffer type mismatch" );
                     }
                 } else {
-                    std::cout << "CA: target buffer " << *target_name << " not found" << std::endl;
+                    JOY_LOG( JOY_DEBUG, LOG_CA, "CA: target buffer " << *target_name << " not found" );
                 }
             }
             if( context.s.buffers.contains( *warp_name ) ) {
-                any_buffer_pair_ptr wf_buf = context.s.buffers[ *warp_name ];
+                any_buffer_pair_ptr& wf_buf = context.s.buffers[ *warp_name ];
                 if( std::holds_alternative< std::shared_ptr< buffer_pair< int > > >( wf_buf ) ) {
-                    auto wf_ptr = std::get<     std::shared_ptr< buffer_pair< int > > >( wf_buf );
+                    auto& wf_ptr = std::get<     std::shared_ptr< buffer_pair< int > > >( wf_buf );
                     if( wf_ptr.get() ) {   // check for null pointer
                         if( wf_ptr->has_image() ) {
                             // get warp field image
-                            wf = wf_ptr->get_image().begin();
-                            auto wf_dim = wf_ptr->get_image().get_dim();
+                            const image< int >& wf_img = wf_ptr->get_image();
+                            wf = wf_img.get_base_ptr();
+                            auto wf_dim = wf_img.get_dim();
                             if( wf_dim == tar_dim ) use_wf = true;
-                            else std::cout << "CA: warp field dimension mismatch" << wf_dim.x << " " << wf_dim.y << std::endl;
+                            else JOY_LOG( JOY_DEBUG, LOG_CA, "CA: warp field dimension mismatch " << wf_dim.x << " " << wf_dim.y );
                         }
                         else {
-                            std::cout << "CA: warp field buffer has no image" << std::endl;
+                            JOY_LOG( JOY_DEBUG, LOG_CA, "CA: warp field buffer has no image" );
                         }
                     }
                     else {
-                        std::cout << "CA: warp field buffer is null" << std::endl;
+                        JOY_LOG( JOY_DEBUG, LOG_CA, "CA: warp field buffer is null" );
                     }
                 }
             }
         }
         dm1 = dim - vec2i( 1, 1 );
         tdm1 = tar_dim - vec2i( 1, 1 );
-        int tx, ty;
+        // color transforms of target are done once, not per cell
+        if( use_target && ( *invert_target || target_byte_rotation != 0 ) ) 
+            tar = transform_target( tar_pair, tar, tar_dim, *invert_target, target_byte_rotation, hood == HOOD_MOORE );
+
+        int generations = 1;
+        // dispatch on concrete rule type once per frame
+        std::visit( [ & ]( auto& rule_ptr ) {
+        auto& r = *rule_ptr;
+
+        // Game of Life on packed cells if no per-cell conditions apply
+        if constexpr( std::is_same_v< std::decay_t< decltype( r ) >, rule_life< ucolor > > ) {
+            if( simd && !use_target && *p >= 1.0f && !*edge_block && !*bright_block ) {
+                bits.pack( in, dim, *r.on, *r.off, r.use_threshold, *r.threshold );
+                generations = std::max( skip, 1 );
+                if( generations > 1 ) hash.advance( bits, generations );
+                else bits.step();
+                bits.unpack( out );
+                // activity history doesn't cover packed frames
+                regions = vec2i( 0, 0 );
+                quiet.clear();
+                return;
+            }
+        }
+
+        // activity tracking for deterministic rules
+        unsigned long long key = 0xcbf29ce484222325ull;
+        mix_key( key, rule.rule_ptr.index() ); mix_key( key, (unsigned long long)&r ); mix_key( key, hood );
+        mix_key( key, *edge_block ); mix_key( key, *bright_block ); mix_key( key, (*bright_range).min ); mix_key( key, (*bright_range).max );
+        mix_key( key, buf_ptr->get_generation() );    // replaced images may reuse the old pixel addresses
+        bool tracking = track && !use_target && *p >= 1.0f && hood != HOOD_RANDOM && rule_key( r, key );
+        vec2i grid( ( dim.x + region_cols - 1 ) / region_cols, 
+                    hood == HOOD_MOORE ? ( dim.y + tile_rows - 1 ) / tile_rows : ( ( dim.y + 1 ) / 2 + tile_rows / 2 - 1 ) / ( tile_rows / 2 ) );
+        int period = hood == HOOD_MOORE ? 1 : ( hood == HOOD_MARGOLUS ? 2 : 4 );
+        plan_regions( grid, period, tracking, key, in, out );
+        int ncols = tracking ? grid.x : 1;
+
+        // Moore output cell - the rule's result, or the center if that is closer to the target.
+        // tar_row and wf_row point to the target row of the cell
+        auto moore_cell = [ & ]( CA_tile< T >& tile, const T* tar_row, const int* wf_row ) -> T {
+            auto& neighbors = tile.neighbors;
+            auto& result = tile.result;
+            if( !use_target ) return result[ 0 ];
+            int tx = tile.x * tdm1.x / dm1.x;
+            ucolor t = use_wf ? tar[ wf_row[ tx ] ] : tar_row[ tx ];   // transformed target
+            if( target_byte_rotation != 0 ) return manhattan( t, rgb_to_hsv( result[0] ) ) < manhattan( t, rgb_to_hsv( MM ) ) ? result[0] : MM;
+            return manhattan( t, result[0] ) < manhattan( t, MM ) ? result[0] : MM;
+        };
+
+        // Bug mode box blur leaves the previous cell's result wherever it doesn't blur. That value
+        // runs down each column and from the bottom of one column to the top of the next, so these
+        // frames are scanned by column on one thread
+        bool column_order = false;
+        if constexpr( std::is_same_v< std::decay_t< decltype( r ) >, rule_box_blur< T > > ) column_order = *r.bug_mode;
 
         // check neighborhood type
-        if( hood == HOOD_MOORE ) {
-            neighbors.resize( 9 );
-            result.resize( 1 );
-            if( use_target ) targ.resize( 1 );
-            auto out_it = out;
-            auto dl_it = in;
-            auto dm_it = in;
-            auto dr_it = in;
-            auto tar_it = tar;
-            // scan through image by column
+        if( hood == HOOD_MOORE && column_order ) {
+            init_tiles( 1 );
+            CA_tile< T >& tile = tiles[ 0 ];
+            auto& neighbors = tile.neighbors;
+            int& x = tile.x;
+            int& y = tile.y;
             for( x = 0; x < dim.x; x++ ) {
-                // set intial neighborhood
-                if( x == 0 ) {
-                    UL = *(in + ( dim.y - 1 ) * dim.x + dim.x - 1);
-                    ML = *(in + dim.x - 1);
-                    dl_it = in + (2 * dim.x - 1); 
-                }
-                else {
-                    UL = *(in + ( dim.y - 1 ) * dim.x + x - 1);
-                    ML = *(in + x - 1);
-                    dl_it = in + (dim.x + x - 1);
-                }
-                DL = *dl_it;
-                UM = *(in + ( dim.y - 1 ) * dim.x + x);
-                MM = *(in + x); 
-                dm_it = in + (dim.x + x); DM = *dm_it;
-                if( x == dim.x - 1 ) {
-                    UR = *(in + ( dim.y - 1 ) * dim.x);
-                    MR = *in; 
-                    dr_it = in + dim.x; 
-                }
-                else {
-                    UR = *(in + ( dim.y - 1 ) * dim.x + x + 1);
-                    MR = *(in + x + 1);
-                    dr_it = in + (dim.x + x + 1);
-                }
-                DR = *dr_it;
-                out_it = out + x;
-                if( use_target ) tx = x * tdm1.x / dm1.x;
-                for( y = 0; y < dim.y - 1; y++ ) {
-                    run_rule();  // apply rule
-                    if( use_target ) {    // if targeted, compare with target
-                        ty = y * tdm1.y / dm1.y;
-                        if( use_wf ) { tar_it = tar + *( wf + ty * tar_dim.x + tx ); }
-                        else { tar_it = tar + ty * tar_dim.x + tx; }
-                        ucolor t = *tar_it;
-                        if( *invert_target ) invert( t );
-                        //if( target_byte_rotation != 0 ) t = hsv_to_rgb( rotate_hue( rgb_to_hsv( t ), target_byte_rotation ) );
-                        if( target_byte_rotation != 0 ) {
-                            t = rotate_hue( rgb_to_hsv( t ), target_byte_rotation );
-                            if( manhattan( t, rgb_to_hsv( result[0] ) ) < manhattan( t, rgb_to_hsv( MM ) ) ) *out_it = result[0];
-                            else *out_it = MM;
-                        }
-                        else {
-                            if( manhattan( t, result[0] ) < manhattan( t, MM ) ) *out_it = result[0];
-                            else *out_it = MM;
-                        }
-                        //if( manhattan( t, result[0] ) < manhattan( t, MM ) ) *out_it = result[0];
-                        //else *out_it = MM;
-                    }
-                    else *out_it = result[0];        // set output
-                    out_it += dim.x;
-                    // update neighborhood
+                int xl = x ? x - 1 : dim.x - 1;
+                int xr = x < dim.x - 1 ? x + 1 : 0;
+                const T* up = in + ( dim.y - 1 ) * dim.x;
+                UL = up[ xl ]; UM = up[ x ]; UR = up[ xr ];
+                ML = in[ xl ]; MM = in[ x ]; MR = in[ xr ];
+                for( y = 0; y < dim.y; y++ ) {
+                    const T* dn = in + ( ( y + 1 ) % dim.y ) * dim.x;
+                    DL = dn[ xl ]; DM = dn[ x ]; DR = dn[ xr ];
+                    run_rule( tile, r );  // apply rule
+                    int ty = use_target ? y * tdm1.y / dm1.y : 0;
+                    out[ y * dim.x + x ] = moore_cell( tile, tar + ty * tar_dim.x, wf + ( use_wf ? ty * tar_dim.x : 0 ) );
+                    // slide window down
                     UL = ML; UM = MM; UR = MR;
                     ML = DL; MM = DM; MR = DR;
-                    dl_it += dim.x; dm_it += dim.x; dr_it += dim.x;
-                    DL = *dl_it; DM = *dm_it; DR = *dr_it;
                 }
-                // set last row
-                if( x == 0 ) DL = *(in + dim.x - 1); else DL = *(in + x - 1);
-                DM = *(in + x);
-                if( x == dim.x - 1 ) DR = *in; else DR = *(in + x + 1);
-                run_rule();  // apply rule
-                if( use_target ) {    // if targeted, compare with target
+            }
+        }
+        else if( hood == HOOD_MOORE ) {
+          int ntiles = ( dim.y + tile_rows - 1 ) / tile_rows;
+          init_tiles( ntiles );
+          parallel_for( ntiles, [ & ]( int i ) {
+            CA_tile< T >& tile = tiles[ i ];
+            auto& neighbors = tile.neighbors;
+            auto& result = tile.result;
+            int& x = tile.x;
+            int& y = tile.y;
+            int ty;
+            const T* tar_row = tar;
+            const int* wf_row = wf;
+            auto write_cell = [&]( T* out_it ) { *out_it = moore_cell( tile, tar_row, wf_row ); };
+
+            // scan through image by row, sliding a three row window along x
+            // rows above and below wrap around (toroidal)
+            int yend = std::min( ( i + 1 ) * tile_rows, dim.y );
+            for( y = i * tile_rows; y < yend; y++ ) {
+                const T* up  = in + ( ( y + dim.y - 1 ) % dim.y ) * dim.x;
+                const T* mid = in + y * dim.x;
+                const T* dn  = in + ( ( y + 1 ) % dim.y ) * dim.x;
+                T* out_row = out + y * dim.x;
+                if( use_target ) {
                     ty = y * tdm1.y / dm1.y;
-                    tar_it = tar + ty * tar_dim.x + tx;
-                    if( manhattan( *tar_it, result[0] ) < manhattan( *tar_it, MM ) ) *out_it = result[0];
-                    else *out_it = MM;
+                    tar_row = tar + ty * tar_dim.x;
+                    if( use_wf ) wf_row = wf + ty * tar_dim.x;
+                }
+
+                // whole row, or one region at a time if tracking activity
+                for( int c = 0; c < ncols; c++ ) {
+                    int x0 = tracking ? c * region_cols : 0;
+                    int x1 = tracking ? std::min( x0 + region_cols, dim.x ) : dim.x;
+                    if( tracking && idle[ i * ncols + c ] ) continue;
+                    // left edge - left column wraps to right side of image
+                    int xl = x0 ? x0 - 1 : dim.x - 1;
+                    UL = up[ xl ]; ML = mid[ xl ]; DL = dn[ xl ];
+                    UM = up[ x0 ]; MM = mid[ x0 ]; DM = dn[ x0 ];
+                    // interior - no wrapping
+                    int xi = std::min( x1, dim.x - 1 );
+                    for( x = x0; x < xi; x++ ) {
+                        UR = up[ x + 1 ]; MR = mid[ x + 1 ]; DR = dn[ x + 1 ];
+                        run_rule( tile, r );  // apply rule
+                        write_cell( out_row + x );
+                        // slide window
+                        UL = UM; ML = MM; DL = DM;
+                        UM = UR; MM = MR; DM = DR;
+                    }
+                    // right edge pass - right column wraps to left side of image
+                    if( x1 == dim.x ) {
+                        UR = up[ 0 ]; MR = mid[ 0 ]; DR = dn[ 0 ];
+                        run_rule( tile, r );  // apply rule
+                        write_cell( out_row + x );
+                    }
+                    if( tracking && !changed[ i * ncols + c ] && !std::equal( mid + x0, mid + x1, out_row + x0 ) ) changed[ i * ncols + c ] = 1;
                 }
-                else *out_it = result[0];
             }
+          } );
         } 
         // Margolus neighborhood family
         // Works best if image dimensions are multiples of 2
         else if((int)hood >= (int)HOOD_MARGOLUS ){ 
-            neighbors.resize( 4 );
-            result.resize( 4 );
-            if( use_target ) targ.resize( 4 );
-            auto out_ul = out; auto out_ur = out; auto out_ll = out; auto out_lr = out;
-            auto in_ul  = in;  auto in_ur  = in;  auto in_ll  = in;  auto in_lr  = in;
-            auto tar_ul = tar; auto tar_ur = tar; auto tar_ll = tar; auto tar_lr = tar;
             // initialize iterators
             int startx, starty;
             if( hood == HOOD_MARGOLUS ) { 
@@ -303,21 +495,57 @@ template< class T > void CA< T >::operator() ( any_buffer_pair_ptr& buf, element
                 if( ( ca_frame / 2 )         % 2 ) starty = 0; else starty = -1;
             } 
             else if( hood == HOOD_RANDOM ) {
-                if( fair_coin( gen ) ) startx = 0; else startx = 1;  // random
-                if( fair_coin( gen ) ) starty = 0; else starty = -1;
+                unsigned int coin = tile_seed( seed, ca_frame, -1 );
+                if( coin & 1 ) startx = 0; else startx = 1;  // random
+                if( coin & 2 ) starty = 0; else starty = -1;
             }
 
-            // scan through image by row
+            // vector kernel runs whole rows of blocks if no per-cell conditions apply
+            funky_kernel kernel;
+            int simd_rule = 0;
+            if( simd && !use_target && *p >= 1.0f && !*edge_block && !*bright_block ) simd_rule = vector_kernel( r, kernel );
+
+            // each tile runs tile_rows / 2 rows of blocks
+            int block_rows = ( dim.y - starty ) / 2;
+            int tile_blocks = tile_rows / 2;
+            int ntiles = ( block_rows + tile_blocks - 1 ) / tile_blocks;
+            init_tiles( ntiles );
+            parallel_for( ntiles, [ & ]( int i ) {
+            CA_tile< T >& tile = tiles[ i ];
+            auto& neighbors = tile.neighbors;
+            auto& result = tile.result;
+            auto& targ = tile.targ;
+            int& x = tile.x;
+            int& y = tile.y;
+            T *out_ul, *out_ur, *out_ll, *out_lr;
+            const T *in_ul, *in_ur, *in_ll, *in_lr;
+            const T *tar_ul, *tar_ur, *tar_ll, *tar_lr;
+
+            // scan through tile by row
             int xl, xr, yu, yl;
             int txl, txr, tyu, tyl;
-            for( y = starty; y < dim.y - 1; y+=2 ) {
+            int yend = std::min( starty + 2 * ( i + 1 ) * tile_blocks, dim.y - 1 );
+            for( y = starty + 2 * i * tile_blocks; y < yend; y+=2 ) {
                 yu = ( y + dim.y ) % dim.y;
                 yl = ( y + 1 + dim.y ) % dim.y;
                 if( use_target ) {
                     tyu = yu * tdm1.y / dm1.y;
                     tyl = yl * tdm1.y / dm1.y;
                 }
-                for( x= startx; x < dim.x; x += 2 ) {
+                // whole row of blocks, or one region at a time if tracking activity
+                for( int c = 0; c < ncols; c++ ) {
+                int cx0 = tracking ? c * region_cols + startx : startx;
+                int cx1 = tracking ? std::min( ( c + 1 ) * region_cols, dim.x ) : dim.x;
+                if( tracking && idle[ i * ncols + c ] ) continue;
+                int x0 = cx0;
+                if( simd_rule ) {
+                    int nblocks = std::max( std::min( cx1, dim.x - 1 ) - cx0 + 1, 0 ) / 2;  // blocks that don't wrap around right edge
+                    const T* up = in  + yu * dim.x + cx0; const T* lo = in  + yl * dim.x + cx0;
+                    T* out_up   = out + yu * dim.x + cx0; T* out_lo   = out + yl * dim.x + cx0;
+                    if( simd_rule == 1 ) x0 += 2 * funky_sort_blocks< false >( kernel, up, lo, out_up, out_lo, nblocks );
+                    else                 x0 += 2 * funky_sort_blocks< true  >( kernel, up, lo, out_up, out_lo, nblocks );
+                }
+                for( x = x0; x < cx1; x += 2 ) {
                     xl = ( x + dim.x ) % dim.x;
                     xr = ( x + 1 + dim.x ) % dim.x;
 
@@ -342,16 +570,10 @@ template< class T > void CA< T >::operator() ( any_buffer_pair_ptr& buf, element
                         TUL = *tar_ul; TUR = *tar_ur; TLL = *tar_ll; TLR = *tar_lr;
                     }
 
-                    run_rule();  // apply rule
+                    run_rule( tile, r );  // apply rule
                     if( use_target ) {
-                        if( *invert_target ) {
-                            invert( TUL ); invert( TUR ); invert( TLL ); invert( TLR );
-                        }
+                        // target is already inverted and rotated
                         if( target_byte_rotation != 0 ) {
-                            TUL = hsv_to_rgb( rotate_hue( rgb_to_hsv( TUL ), target_byte_rotation ) );
-                            TUR = hsv_to_rgb( rotate_hue( rgb_to_hsv( TUR ), target_byte_rotation ) );
-                            TLL = hsv_to_rgb( rotate_hue( rgb_to_hsv( TLL ), target_byte_rotation ) );
-                            TLR = hsv_to_rgb( rotate_hue( rgb_to_hsv( TLR ), target_byte_rotation ) );
                             if( manhattan( rgb_to_hsv( RUL ), TUL ) + manhattan( rgb_to_hsv( RUR ), TUR ) + manhattan( rgb_to_hsv( RLR ), TLR ) + manhattan( rgb_to_hsv( RLL ), TLL ) <
                                 manhattan( rgb_to_hsv( MUL ), TUL ) + manhattan( rgb_to_hsv( MUR ), TUR ) + manhattan( rgb_to_hsv( MLR ), TLR ) + manhattan( rgb_to_hsv( MLL ), TLL ) )
                                     { *out_ul = RUL; *out_ur = RUR; *out_ll = RLL; *out_lr = RLR; }
@@ -365,21 +587,50 @@ template< class T > void CA< T >::operator() ( any_buffer_pair_ptr& buf, element
                         }
                     } else { *out_ul = RUL; *out_ur = RUR; *out_ll = RLL; *out_lr = RLR; }
                 }
+                if( tracking && !changed[ i * ncols + c ] ) {
+                    // blocks write cx0 up to cx1, and wrap around to column 0 if one starts in the last column
+                    int x1 = std::min( cx1 + 1, dim.x );
+                    bool wraps = cx1 == dim.x && cx0 < dim.x && ( dim.x - 1 - cx0 ) % 2 == 0;
+                    if( !std::equal( in + yu * dim.x + cx0, in + yu * dim.x + x1, out + yu * dim.x + cx0 ) ||
+                        !std::equal( in + yl * dim.x + cx0, in + yl * dim.x + x1, out + yl * dim.x + cx0 ) ||
+                        ( wraps && ( in[ yu * dim.x ] != out[ yu * dim.x ] || in[ yl * dim.x ] != out[ yl * dim.x ] ) ) )
+                        changed[ i * ncols + c ] = 1;
+                }
+                }
             }
+            } );
         }
-        ca_frame++;
+        }, rule.rule_ptr );
+        ca_frame += generations;
         buf_ptr->swap();
+        // settled regions count another quiet frame
+        for( int i = 0; i < quiet.size(); i++ ) quiet[ i ] = changed[ i ] ? 0 : std::min( quiet[ i ] + 1, 255 );
+        track_front = out;
+        track_back = in;
     }
 } 
 
+// Runs n generations. Game of Life covers them in one frame (hashlife on power of two tori),
+// other rules run frame by frame. Rule parameters are evaluated once per frame run
+template< class T > void CA< T >::advance( any_buffer_pair_ptr& buf, element_context& context, int n ) {
+    while( n > 0 ) {
+        int start = ca_frame;
+        skip = n;
+        ( *this )( buf, context );
+        skip = 0;
+        if( ca_frame == start ) break;   // no image to run on
+        n -= ca_frame - start;
+    }
+}
+
 template< class T > CA_hood rule_identity< T >::operator () ( element_context &context )
 { return HOOD_MARGOLUS; }
 
-template< class T > void rule_identity< T >::operator () ( CA< T >& ca ) { 
+template< class T > void rule_identity< T >::operator () ( CA_tile< T >& ca ) { 
     auto& neighbors = ca.neighbors;
     auto& result = ca.result;
 
-    result.assign( neighbors.begin(), neighbors.end() );
+    std::copy_n( neighbors.begin(), 4, result.begin() );
 }
 
 // Moore neighborhood family
@@ -396,7 +647,7 @@ template< class T > CA_hood rule_life< T >::operator () ( element_context &conte
     return HOOD_MOORE;
 }
 
-template< class T > void rule_life< T >::operator () ( CA< T >& ca ) { 
+template< class T > void rule_life< T >::operator () ( CA_tile< T >& ca ) { 
     auto& neighbors = ca.neighbors;
     auto& result = ca.result;
 
@@ -424,10 +675,10 @@ template< class T > CA_hood rule_random_copy< T >::operator () ( element_context
     return HOOD_MOORE; 
 }
 
-template< class T > void rule_random_copy< T >::operator () ( CA< T >& ca ) {
+template< class T > void rule_random_copy< T >::operator () ( CA_tile< T >& ca ) {
     auto& neighbors = ca.neighbors;
     auto& result = ca.result;
-    int r = rand_9( gen );
+    int r = rand_9( ca.gen );
     result[0] = neighbors[ r ]; // copy any neighbor, including possibly itself
 }
 
@@ -436,15 +687,15 @@ template< class T > CA_hood rule_random_mix< T >::operator () ( element_context
     return HOOD_MOORE; 
 }
 
-template< class T > void rule_random_mix< T >::operator () ( CA< T >& ca ) {
+template< class T > void rule_random_mix< T >::operator () ( CA_tile< T >& ca ) {
     auto& neighbors = ca.neighbors;
     auto& result = ca.result;
     result[ 0 ] = 0;
-    int r = rand_9( gen );
+    int r = rand_9( ca.gen );
     result[0] |= neighbors[ r ] & 0x00ff0000; // copy any neighbor, including possibly itself
-    r = rand_9( gen );
+    r = rand_9( ca.gen );
     result[0] |= neighbors[ r ] & 0x0000ff00; // copy any neighbor, including possibly itself
-    r = rand_9( gen );
+    r = rand_9( ca.gen );
     result[0] |= neighbors[ r ] & 0x000000ff; // copy any neighbor, including possibly itself
 }
 
@@ -475,7 +726,7 @@ template< class T > CA_hood rule_box_blur< T >::operator () ( element_context &c
     return HOOD_MOORE; 
 }
 
-template< class T > void rule_box_blur< T >::operator () ( CA< T >& ca ) {
+template< class T > void rule_box_blur< T >::operator () ( CA_tile< T >& ca ) {
     auto& neighbors = ca.neighbors;
     auto& result = ca.result;
     
@@ -487,11 +738,11 @@ template< class T > void rule_box_blur< T >::operator () ( CA< T >& ca ) {
             unsigned int mmr = manhattan( MM, MR );
 
             if( mum + mdm < mml + mmr ) {
-                if( ( mum < *max_diff ) && ( mdm < *max_diff ) )result[ 0 ] = blend( UM, DM );
+                if( ( mum < *max_diff ) && ( mdm < *max_diff ) )result[ 0 ] = blend_round( UM, DM, fair_coin( ca.gen ) );
                 else if( !*bug_mode ) result[ 0 ] = MM;
             }
             else {
-                if( ( mml < *max_diff ) && ( mmr < *max_diff ) )result[ 0 ] = blend( ML, MR );
+                if( ( mml < *max_diff ) && ( mmr < *max_diff ) )result[ 0 ] = blend_round( ML, MR, fair_coin( ca.gen ) );
                 else if( !*bug_mode ) result[ 0 ] = MM;
             } 
         }
@@ -503,11 +754,11 @@ template< class T > void rule_box_blur< T >::operator () ( CA< T >& ca ) {
             unsigned int mdr = manhattan( MM, DR );
 
             if( mul + mdr < mur + mdl ) {
-                if( ( mul < *max_diff ) && ( mdr < *max_diff ) )result[ 0 ] = blend( UL, DR );
+                if( ( mul < *max_diff ) && ( mdr < *max_diff ) )result[ 0 ] = blend_round( UL, DR, fair_coin( ca.gen ) );
                 else if( !*bug_mode ) result[ 0 ] = MM;
             }
             else {
-                if( ( mur < *max_diff ) && ( mdl < *max_diff ) )result[ 0 ] = blend( UR, DL );
+                if( ( mur < *max_diff ) && ( mdl < *max_diff ) )result[ 0 ] = blend_round( UR, DL, fair_coin( ca.gen ) );
                 else if( !*bug_mode ) result[ 0 ] = MM;
             }
         }
@@ -532,22 +783,22 @@ template< class T > void rule_box_blur< T >::operator () ( CA< T >& ca ) {
 
             switch( min_pair ) {
                 case 1: {
-                    if( ( mum < *max_diff ) && ( mdm < *max_diff ) )result[ 0 ] = blend( UM, DM );
+                    if( ( mum < *max_diff ) && ( mdm < *max_diff ) )result[ 0 ] = blend_round( UM, DM, fair_coin( ca.gen ) );
                     else if( !*bug_mode ) result[ 0 ] = MM;
                 }
                 break;
                 case 2: {
-                    if( ( mml < *max_diff ) && ( mmr < *max_diff ) )result[ 0 ] = blend( ML, MR );
+                    if( ( mml < *max_diff ) && ( mmr < *max_diff ) )result[ 0 ] = blend_round( ML, MR, fair_coin( ca.gen ) );
                     else if( !*bug_mode ) result[ 0 ] = MM;
                 }
                 break;
                 case 3: {
-                    if( ( mul < *max_diff ) && ( mdr < *max_diff ) )result[ 0 ] = blend( UL, DR );
+                    if( ( mul < *max_diff ) && ( mdr < *max_diff ) )result[ 0 ] = blend_round( UL, DR, fair_coin( ca.gen ) );
                     else if( !*bug_mode ) result[ 0 ] = MM;
                 }
                 break;
                 case 4: {
-                    if( ( mur < *max_diff ) && ( mdl < *max_diff ) )result[ 0 ] = blend( UR, DL );
+                    if( ( mur < *max_diff ) && ( mdl < *max_diff ) )result[ 0 ] = blend_round( UR, DL, fair_coin( ca.gen ) );
                     else if( !*bug_mode ) result[ 0 ] = MM;
                 }
                 break;
@@ -555,6 +806,7 @@ template< class T > void rule_box_blur< T >::operator () ( CA< T >& ca ) {
         }
         break;
         case BB_CUSTOM: {
+            std::array< unsigned int, 8 > diffs; // Manhattan distance to each neighbor
             diffs[ 0 ] = manhattan( MM, UM );
             diffs[ 1 ] = manhattan( MM, UR );
             diffs[ 2 ] = manhattan( MM, MR );
@@ -604,7 +856,7 @@ template< class T > void rule_box_blur< T >::operator () ( CA< T >& ca ) {
                         size ++;
                     }
                 }
-                unsigned int res = rand_uint( gen ) % size;
+                unsigned int res = rand_uint( ca.gen ) % size;
                 unsigned int count = 0;
                 result[ 0 ] = MM;
                 for( int i = 0; i < 8; i++ ) {
@@ -628,7 +880,7 @@ template< class T > void rule_box_blur< T >::operator () ( CA< T >& ca ) {
                     }
                 }
                 if( size > 0 ) {
-                    unsigned int random_add = rand_uint( gen ) % size;
+                    unsigned int random_add = rand_uint( ca.gen ) % size;
                     r += random_add; r /= size;
                     g += random_add; g /= size;
                     b += random_add; b /= size;
@@ -646,10 +898,10 @@ template< class T > void rule_box_blur< T >::operator () ( CA< T >& ca ) {
 template< class T > CA_hood rule_diffuse< T >::operator () ( element_context &context ) 
 { return HOOD_MARGOLUS; }
 
-template< class T > void rule_diffuse< T >::operator () ( CA< T >& ca ) {
+template< class T > void rule_diffuse< T >::operator () ( CA_tile< T >& ca ) {
     auto& neighbors = ca.neighbors;
     auto& result = ca.result;
-    int r = rand_4( gen );
+    int r = rand_4( ca.gen );
     
     result[0] = neighbors[ r ];
     result[1] = neighbors[ (r + 1) % 4 ];
@@ -662,7 +914,7 @@ template< class T > CA_hood rule_gravitate< T >::operator () ( element_context &
     direction( context );
     return HOOD_MARGOLUS; } 
 
-template< class T > void rule_gravitate< T >::operator () ( CA< T >& ca ) {
+template< class T > void rule_gravitate< T >::operator () ( CA_tile< T >& ca ) {
     int r;
     auto& neighbors = ca.neighbors;
     auto& result = ca.result;
@@ -707,7 +959,7 @@ template< class T > CA_hood rule_snow< T >::operator () ( element_context &conte
 }
 
 // Bug preserved in amber. A version of gravitate with a bug that causes it to rotate in the opposite direction.
-template< class T > void rule_snow< T >::operator () ( CA< T >& ca ) {
+template< class T > void rule_snow< T >::operator () ( CA_tile< T >& ca ) {
     int r;
     auto& neighbors = ca.neighbors;
     auto& result = ca.result;
@@ -755,7 +1007,7 @@ template< class T > CA_hood rule_pixel_sort< T >::operator () ( element_context
     else                        return HOOD_MARGOLUS;
 }
 
-template< class T > void rule_pixel_sort< T >::operator () ( CA< T >& ca ) {
+template< class T > void rule_pixel_sort< T >::operator () ( CA_tile< T >& ca ) {
     auto& neighbors = ca.neighbors;
     auto& result = ca.result;
 
@@ -806,7 +1058,7 @@ template< class T > CA_hood rule_funky_sort< T >::operator () ( element_context
     //else                        return HOOD_MARGOLUS;
 } 
 
-template< class T > void rule_funky_sort< T >::operator () ( CA< T >& ca ) { 
+template< class T > void rule_funky_sort< T >::operator () ( CA_tile< T >& ca ) { 
     auto& neighbors = ca.neighbors;
     auto& result = ca.result;
 
@@ -880,7 +1132,7 @@ template< class T > CA_hood rule_diagonal_funky_sort< T >::operator () ( element
     //else                        return HOOD_MARGOLUS;
 } 
 
-template< class T > void rule_diagonal_funky_sort< T >::operator () ( CA< T >& ca ) { 
+template< class T > void rule_diagonal_funky_sort< T >::operator () ( CA_tile< T >& ca ) { 
     auto& neighbors = ca.neighbors;
     auto& result = ca.result;
 
@@ -952,7 +1204,7 @@ template< class T > void rule_diagonal_funky_sort< T >::operator () ( CA< T >& c
             ( (unsigned int)( manhattan( MUR, MLL ) < *max_diff ) << (B5) );
 
 // Pixel sorting with dafunk
-template< class T > void rule_funky_sort< T >::operator () ( CA< T >& ca ) {
+template< class T > void rule_funky_sort< T >::operator () ( CA_tile< T >& ca ) {
     auto& neighbors = ca.neighbors;
     auto& result = ca.result;
 
@@ -1059,7 +1311,7 @@ template< class T > void rule_funky_sort< T >::operator () ( CA< T >& ca ) {
 
 /*
 
-template< class T > void rule_funky_sort< T >::operator () ( CA< T >& ca ) {
+template< class T > void rule_funky_sort< T >::operator () ( CA_tile< T >& ca ) {
     auto& neighbors = ca.neighbors;
     auto& result = ca.result;
     if( luminance( MUL ) < 10 || luminance( MUR ) < 10 || luminance( MLL ) < 10 || luminance( MLR ) < 10) {
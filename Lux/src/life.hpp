@@ -8,6 +8,8 @@
 #include "any_rule.hpp"
 #include "any_image.hpp"
 #include "life_hacks.hpp"
+#include "life_bits.hpp"
+#include "life_hash.hpp"
 #include "next_element.hpp"
 #include <array>
  
@@ -18,9 +20,17 @@
 #define FUNK_TEST_L 0xffffffffcccccccc
 #define FUNK_TEST_R 0xffaaffaaffaaffaa
 
+// Working state of one tile - neighborhood of the current cell, its position and a random stream.
+// Tiles run concurrently so rules read and write only through the tile.
+template< class T > struct CA_tile {
+   std::array< T, 9 > neighbors;    // Moore uses all nine, Margolus family the first four
+   std::array< T, 4 > result, targ; // Moore uses the first result only
+   int x, y;    // position of cell in image
+   std::mt19937 gen; // seeded from CA seed, frame and tile index
+};
+
 // future - move alpha block to CA
 template< class T > struct CA {
-   std::vector< T > neighbors, result, targ; // vector of neighbors - size depends on neighborhood
    // Future - use for image targeting
    harness< bool > targeted; // if true, rule will run if it gets closer to target image
    harness< bool > invert_target; // if true, invert the target color
@@ -41,9 +51,33 @@ template< class T > struct CA {
 
    // relevant information
    int ca_frame;  // ca_frame counter
-   int x, y;    // position of cell in image
    vec2i dim;   // dimensions of image
 
+   // Parallel execution
+   static constexpr int tile_rows = 32;  // rows per tile (even, so Margolus blocks don't straddle tiles)
+   int seed; // results are reproducible for a given seed
+   bool simd; // use vector and bit-packed kernels where available
+   std::vector< CA_tile< T > > tiles;
+   life_bits bits; // packed cells for rule_life
+   life_hash hash; // memoized fast forward for rule_life
+   int skip;       // generations requested by advance() - frame may run several if rule can fast forward
+
+   // Activity tracking - regions of tile_rows x region_cols cells whose neighborhood has settled are skipped
+   static constexpr int region_cols = 32;
+   bool track;                          // skip settled regions when the rule is deterministic
+   vec2i regions;                       // region grid of last frame
+   std::vector< unsigned char > quiet;  // frames since each region last changed (saturating)
+   std::vector< unsigned char > idle;   // regions skipped this frame
+   std::vector< unsigned char > changed;
+   unsigned long long track_key;        // rule and condition parameters of last frame
+   const T *track_front, *track_back;   // buffers as left by last frame
+
+   // Target with inversion and hue rotation applied, rebuilt only when the target or the transform changes
+   std::vector< T > target_plane;
+   std::weak_ptr< buffer_pair< T > > target_pair;  // buffer the plane was built from - none for Self
+   unsigned int target_version;         // its version then
+   unsigned int target_form;            // inversion, rotation and color space of plane
+
    // Built in conditions
    harness< float > p;  // probability of cell running
    harness< bool > edge_block; // if true, cells on the edge of the image will not run
@@ -53,8 +87,12 @@ template< class T > struct CA {
    // future: image block
 
    //void set_rule( any_rule rule );
-   void run_rule();
+   void init_tiles( int ntiles );
+   template< class R > void run_rule( CA_tile< T >& t, R& r );
+   const T* transform_target( const std::shared_ptr< buffer_pair< T > >& source, const T* tar, const vec2i& tar_dim, bool inverted, unsigned int rotation, bool hsv );
+   void plan_regions( const vec2i& grid, int period, bool tracking, unsigned long long key, const T* in, const T* out );
    void operator () ( any_buffer_pair_ptr& buf, element_context& context );
+   void advance( any_buffer_pair_ptr& buf, element_context& context, int n ); // same as n frames
 
    CA() :  // default constructor for rule returns identity rule pointer
       rule(),
@@ -67,7 +105,17 @@ template< class T > struct CA {
       alpha_block( false ),
       bright_block( false ),
       bright_range( { 0, 768 } ),
-      ca_frame(0) {}
+      ca_frame(0),
+      seed( rd() ),
+      simd( true ),
+      skip( 0 ),
+      track( true ),
+      regions( 0, 0 ),
+      track_key( 0 ),
+      track_front( nullptr ),
+      track_back( nullptr ),
+      target_version( 0 ),
+      target_form( 0 ) {}
 };
 
 //typedef CA< frgb > CA_frgb;
@@ -78,7 +126,7 @@ typedef CA< ucolor > CA_ucolor;
 
 template< class T > struct rule_identity {
    CA_hood operator () ( element_context& context );   
-   void operator () ( CA< T >& ca );
+   void operator () ( CA_tile< T >& ca );
    
    rule_identity() {}
 };
@@ -96,7 +144,7 @@ template< class T > struct rule_life {
    harness< int > threshold; // threshold value
 
    CA_hood operator () ( element_context& context );
-   void operator () ( CA< T >& ca );
+   void operator () ( CA_tile< T >& ca );
             
    rule_life( const T& on_init = white< T >, const T& off_init = black< T >, const bool& use_threshold_init = false, const int& threshold_init = 384 ) : on( on_init ), off( off_init ), use_threshold( use_threshold_init ), threshold( threshold_init ) {}
 };
@@ -112,7 +160,7 @@ template< class T > struct rule_random_copy {
    std::uniform_int_distribution< int > rand_9;
 
    CA_hood operator () ( element_context& context );
-   void operator () ( CA< T >& ca );
+   void operator () ( CA_tile< T >& ca );
 
    rule_random_copy() : rand_9( std::uniform_int_distribution< int >( 0, 8 ) ) {}
 };
@@ -128,7 +176,7 @@ template< class T > struct rule_random_mix {
    std::uniform_int_distribution< int > rand_9;
 
    CA_hood operator () ( element_context& context );
-   void operator () ( CA< T >& ca );
+   void operator () ( CA_tile< T >& ca );
 
    rule_random_mix() : rand_9( std::uniform_int_distribution< int >( 0, 8 ) ) {}
 };
@@ -144,7 +192,6 @@ template< class T > struct rule_box_blur {
    harness< box_blur_type > blur_method; // Type of box blur
    harness< bool > bug_mode; // if true, return default color if no neighbors are within max_diff
    harness< bool > random_copy; // if true, randomly copy color from a neighbor instead of blurring
-   std::array< unsigned int, 8 > diffs; // Manhattan distance to each neighbor
 
    //harness< int > dirs_size; // number of directions
    //std::vector< harness < int > > dirs;  // array of directions for blur
@@ -154,7 +201,7 @@ template< class T > struct rule_box_blur {
    std::vector< int > compares; // array of directions for comparison with max_diff
 
    CA_hood operator () ( element_context& context );
-   void operator () ( CA< T >& ca );
+   void operator () ( CA_tile< T >& ca );
 
    rule_box_blur( int max_diff_init = 230, 
                   box_blur_type blur_method_init = BB_ORTHOGONAL, 
@@ -178,7 +225,7 @@ template< class T > struct rule_color_drift {
    harness< int > drift_r, drift_g, drift_b; // integer 0 to 9
 
    CA_hood operator () ( element_context& context );
-   void operator () ( CA< T >& ca );
+   void operator () ( CA_tile< T >& ca );
 
    rule_random_mix( int drift_r_init, int drift_g_init, int drift_b_init ) : 
       rand_9( std::uniform_int_distribution< int >( 0, 8 ) ),
@@ -201,7 +248,7 @@ template< class T > struct rule_diffuse {
    std::uniform_int_distribution< int > rand_4;
 
    CA_hood operator () ( element_context& context );
-   void operator () ( CA< T >& ca );
+   void operator () ( CA_tile< T >& ca );
             
 
    rule_diffuse() :
@@ -220,7 +267,7 @@ template< class T > struct rule_gravitate {
    harness< direction4 > direction;
 
    CA_hood operator () ( element_context& context );
-   void operator () ( CA< T >& ca );
+   void operator () ( CA_tile< T >& ca );
             
    rule_gravitate( direction4 direction_init = direction4::D4_DOWN, bool alpha_block_init = false ) :
       direction( direction_init ),
@@ -239,7 +286,7 @@ template< class T > struct rule_snow {
    harness< direction4 > direction;
 
    CA_hood operator () ( element_context& context );
-   void operator () ( CA< T >& ca );
+   void operator () ( CA_tile< T >& ca );
             
 
    rule_snow( direction4 direction_init = direction4::D4_DOWN, bool alpha_block_init = false ) :
@@ -258,7 +305,7 @@ template< class T > struct rule_pixel_sort {
    harness< int > max_diff; // Maximum difference between pixels to be sorted (Manhattan distance)
 
    CA_hood operator () ( element_context& context );
-   void operator () ( CA< T >& ca );
+   void operator () ( CA_tile< T >& ca );
             
    rule_pixel_sort( direction8 direction_init = direction8::D8_DOWN, bool alpha_block_init = false, int max_diff_init = 300 ) :
       direction( direction_init ),
@@ -283,7 +330,7 @@ template< class T > struct rule_funky_sort {
    harness< funk_factor > dafunk_r;  // Funky lookup table for second pair, rotated by direction
 
    CA_hood operator () ( element_context& context );
-   void operator () ( CA< T >& ca );
+   void operator () ( CA_tile< T >& ca );
             
    rule_funky_sort(  funk_factor dafunk_l_init = FUNK_WEB_L, 
                      funk_factor dafunk_r_init = FUNK_WEB_R, 
@@ -313,7 +360,7 @@ template< class T > struct rule_diagonal_funky_sort {
    harness< funk_factor > dafunk_d;  // Funky lookup table for diagonal pair, rotated by direction
 
    CA_hood operator () ( element_context& context );
-   void operator () ( CA< T >& ca );
+   void operator () ( CA_tile< T >& ca );
             
    rule_diagonal_funky_sort( funk_factor dafunk_d_init = FUNK_BORG, 
                            int max_diff_init = 300,
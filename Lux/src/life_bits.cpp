@@ -0,0 +1,123 @@
+#include <algorithm>
+#include "life_bits.hpp"
+#include "joy_thread.hpp"
+
+// rows per parallel task
+static const int band_rows = 64;
+
+static inline void full_add( uint64_t a, uint64_t b, uint64_t c, uint64_t& sum, uint64_t& carry ) {
+    uint64_t u = a ^ b;
+    sum = u ^ c;
+    carry = ( a & b ) | ( u & c );
+}
+
+void life_bits::resize( const vec2i& dim_init ) {
+    dim = dim_init;
+    row_words = ( dim.x + 63 ) / 64;
+    last_mask = ( dim.x & 63 ) ? ( 1ull << ( dim.x & 63 ) ) - 1 : ~0ull;
+    cells.resize( row_words * dim.y );
+    self.resize( row_words * dim.y );
+    next.resize( row_words * dim.y );
+}
+
+void life_bits::pack( const ucolor* img, const vec2i& dim_init, const ucolor& on_init, const ucolor& off_init, bool use_threshold, int threshold ) {
+    resize( dim_init );
+    on = on_init; off = off_init;
+    auto live = [ & ]( const ucolor& c ) {
+        unsigned int bright = ( ( c >> 16 ) & 0xff ) + ( ( c >> 8 ) & 0xff ) + ( c & 0xff );
+        return use_threshold ? bright > (unsigned int)threshold : c == on;
+    };
+    on_live  = live( on )  ? ~0ull : 0;
+    off_live = live( off ) ? ~0ull : 0;
+    split = use_threshold;
+    parallel_for( ( dim.y + band_rows - 1 ) / band_rows, [ & ]( int band ) {
+        int yend = std::min( ( band + 1 ) * band_rows, dim.y );
+        for( int y = band * band_rows; y < yend; y++ ) {
+            const ucolor* row = img + y * dim.x;
+            for( int k = 0; k < row_words; k++ ) {
+                int xend = std::min( 64, dim.x - k * 64 );
+                uint64_t c = 0, s = 0;
+                for( int b = 0; b < xend; b++ ) {
+                    const ucolor& px = row[ k * 64 + b ];
+                    c |= (uint64_t)live( px ) << b;
+                    s |= (uint64_t)( px == on ) << b;
+                }
+                cells[ y * row_words + k ] = c;
+                self[ y * row_words + k ] = s;
+            }
+        }
+    } );
+}
+
+void life_bits::unpack( ucolor* img ) const {
+    const std::vector< uint64_t >& live = split ? self : cells;
+    parallel_for( ( dim.y + band_rows - 1 ) / band_rows, [ & ]( int band ) {
+        int yend = std::min( ( band + 1 ) * band_rows, dim.y );
+        for( int y = band * band_rows; y < yend; y++ ) {
+            ucolor* row = img + y * dim.x;
+            for( int k = 0; k < row_words; k++ ) {
+                uint64_t w = live[ y * row_words + k ];
+                int xend = std::min( 64, dim.x - k * 64 );
+                for( int b = 0; b < xend; b++ ) row[ k * 64 + b ] = ( ( w >> b ) & 1 ) ? on : off;
+            }
+        }
+    } );
+}
+
+// One generation of rows [y0, y1) from cells (and self) into next
+// Eight neighbor planes are summed with full adders: ones, twos and fours-or-more bits
+void life_bits::step_rows( int y0, int y1 ) {
+    const int top = ( dim.x - 1 ) & 63;   // bit of rightmost cell in last word
+    const uint64_t* centers = split ? self.data() : cells.data();
+    for( int y = y0; y < y1; y++ ) {
+        const uint64_t* up  = cells.data() + ( ( y + dim.y - 1 ) % dim.y ) * row_words;
+        const uint64_t* mid = cells.data() + y * row_words;
+        const uint64_t* dn  = cells.data() + ( ( y + 1 ) % dim.y ) * row_words;
+        const uint64_t* c   = centers + y * row_words;
+        uint64_t* out = next.data() + y * row_words;
+        for( int k = 0; k < row_words; k++ ) {
+            // neighbor words to the west and east wrap around the row
+            int kw = k ? k - 1 : row_words - 1;
+            int wbit = k ? 63 : top;
+            int ke = ( k < row_words - 1 ) ? k + 1 : 0;
+            int ebit = ( k < row_words - 1 ) ? 63 : top;
+            auto west = [ & ]( const uint64_t* r ) { return ( r[ k ] << 1 ) | ( ( r[ kw ] >> wbit ) & 1 ); };
+            auto east = [ & ]( const uint64_t* r ) { return ( r[ k ] >> 1 ) | ( ( r[ ke ] & 1 ) << ebit ); };
+
+            uint64_t s0, c0, s1, c1, s2, c2, ones, c3, t, c4;
+            full_add( west( up ), up[ k ], east( up ), s0, c0 );
+            full_add( west( dn ), dn[ k ], east( dn ), s1, c1 );
+            s2 = west( mid ) ^ east( mid );
+            c2 = west( mid ) & east( mid );
+            full_add( s0, s1, s2, ones, c3 );     // weight 1
+            full_add( c0, c1, c2, t, c4 );        // weight 2 ( c3 also weight 2 )
+            uint64_t twos  = t ^ c3;
+            uint64_t fours = c4 | ( t & c3 );     // count of four or more
+            // born with three, survives with two or three
+            uint64_t w = twos & ~fours & ( ones | c[ k ] );
+            if( k == row_words - 1 ) w &= last_mask;
+            out[ k ] = w;
+        }
+    }
+}
+
+void life_bits::step( unsigned long long generations ) {
+    int bands = ( dim.y + band_rows - 1 ) / band_rows;
+    for( unsigned long long g = 0; g < generations; g++ ) {
+        parallel_for( bands, [ & ]( int band ) { step_rows( band * band_rows, std::min( ( band + 1 ) * band_rows, dim.y ) ); } );
+        // cells are now all on or off - set which of them count as neighbors
+        split = !( on_live == ~0ull && off_live == 0 );
+        if( split ) {
+            self.swap( next );
+            for( int y = 0; y < dim.y; y++ ) {
+                for( int k = 0; k < row_words; k++ ) {
+                    uint64_t s = self[ y * row_words + k ];
+                    uint64_t c = ( s & on_live ) | ( ~s & off_live );
+                    if( k == row_words - 1 ) c &= last_mask;
+                    cells[ y * row_words + k ] = c;
+                }
+            }
+        }
+        else cells.swap( next );
+    }
+}
@@ -0,0 +1,46 @@
+// Bit-packed Game of Life - 64 cells per word, toroidal boundary
+// Used by CA for rule_life when no per-cell conditions apply. The image is packed at the
+// start of a frame, stepped with bitwise adders, and unpacked into the back buffer.
+
+#ifndef __LIFE_BITS_HPP
+#define __LIFE_BITS_HPP
+
+#include <vector>
+#include <cstdint>
+#include "ucolor.hpp"
+#include "vect2.hpp"
+
+class life_bits {
+    vec2i dim;
+    int row_words;                    // words per row - last word may be partly padding
+    uint64_t last_mask;               // valid bits of last word in row
+    std::vector< uint64_t > cells;    // cells counted as live neighbors
+    std::vector< uint64_t > self;     // cells that are live themselves, if different from cells
+    std::vector< uint64_t > next;
+    ucolor on, off;
+    uint64_t on_live, off_live;       // all ones if on / off cells count as live neighbors
+    bool split;                       // self differs from cells
+
+    void resize( const vec2i& dim_init );
+    void step_rows( int y0, int y1 );
+
+public:
+    // Cells equal to on are live. If use_threshold, neighbors brighter than threshold
+    // are counted instead - matches rule_life
+    void pack( const ucolor* img, const vec2i& dim_init, const ucolor& on_init, const ucolor& off_init, bool use_threshold = false, int threshold = 384 );
+    void unpack( ucolor* img ) const;   // live cells to on, others to off
+    void step( unsigned long long generations = 1 );
+
+    bool get( const vec2i& p ) const { return ( ( split ? self : cells )[ p.y * row_words + ( p.x >> 6 ) ] >> ( p.x & 63 ) ) & 1; }
+    // plain Life - live cells and live neighbors are the same plane
+    bool plain() const { return !split && on_live == ~0ull && off_live == 0; }
+    void set( const vec2i& p, bool live ) {   // plain only
+        uint64_t& w = cells[ p.y * row_words + ( p.x >> 6 ) ];
+        w = ( w & ~( 1ull << ( p.x & 63 ) ) ) | ( (uint64_t)live << ( p.x & 63 ) );
+    }
+    const vec2i& get_dim() const { return dim; }
+
+    life_bits() : dim( 0, 0 ), row_words( 0 ), last_mask( 0 ), on( 0 ), off( 0 ), on_live( ~0ull ), off_live( 0 ), split( false ) {}
+};
+
+#endif // __LIFE_BITS_HPP
@@ -0,0 +1,199 @@
+#include <bit>
+#include <algorithm>
+#include "life_hash.hpp"
+
+life_hash::life_hash( size_t max_nodes_init ) : max_nodes( max_nodes_init ), overflow( false ) {
+    clear();
+}
+
+void life_hash::clear() {
+    nodes.clear();
+    table.assign( 1 << 16, empty );
+    overflow = false;
+    leaf( 0 );  // node 0 - returned on overflow so callers always see a valid node
+}
+
+static inline size_t quad_hash( uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se ) {
+    uint64_t h = ( (uint64_t)nw * 0x9e3779b97f4a7c15ull ) ^ ( (uint64_t)ne * 0xc2b2ae3d27d4eb4full )
+               ^ ( (uint64_t)sw * 0x165667b19e3779f9ull ) ^ ( (uint64_t)se * 0x27d4eb2f165667c5ull );
+    return h ^ ( h >> 29 );
+}
+
+void life_hash::rehash( size_t slots ) {
+    table.assign( slots, empty );
+    size_t mask = slots - 1;
+    for( uint32_t i = 0; i < nodes.size(); i++ ) {
+        const node& c = nodes[ i ];
+        size_t h = quad_hash( c.nw, c.ne, c.sw, c.se ) & mask;
+        while( table[ h ] != empty ) h = ( h + 1 ) & mask;
+        table[ h ] = i;
+    }
+}
+
+uint32_t life_hash::find( uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se, int level ) {
+    if( overflow ) return 0;
+    size_t mask = table.size() - 1;
+    size_t h = quad_hash( nw, ne, sw, se ) & mask;
+    for( ; table[ h ] != empty; h = ( h + 1 ) & mask ) {
+        const node& c = nodes[ table[ h ] ];
+        if( c.nw == nw && c.ne == ne && c.sw == sw && c.se == se ) return table[ h ];
+    }
+    if( nodes.size() >= max_nodes ) {
+        overflow = true;
+        return 0;
+    }
+    uint32_t n = nodes.size();
+    nodes.push_back( { nw, ne, sw, se, 0, (int8_t)level, -1 } );
+    table[ h ] = n;
+    if( nodes.size() * 2 > table.size() ) rehash( table.size() * 2 );
+    return n;
+}
+
+void life_hash::rows16( uint32_t n, uint32_t* r ) const {
+    const node& c = nodes[ n ];
+    uint64_t nw = cells( c.nw ), ne = cells( c.ne ), sw = cells( c.sw ), se = cells( c.se );
+    for( int y = 0; y < 8; y++ ) {
+        r[ y ]     = ( ( nw >> ( 8 * y ) ) & 0xff ) | ( ( ( ne >> ( 8 * y ) ) & 0xff ) << 8 );
+        r[ y + 8 ] = ( ( sw >> ( 8 * y ) ) & 0xff ) | ( ( ( se >> ( 8 * y ) ) & 0xff ) << 8 );
+    }
+}
+
+uint32_t life_hash::center_leaf( const uint32_t* r ) {
+    uint64_t c = 0;
+    for( int y = 0; y < 8; y++ ) c |= (uint64_t)( ( r[ y + 4 ] >> 4 ) & 0xff ) << ( 8 * y );
+    return leaf( c );
+}
+
+uint32_t life_hash::center( uint32_t n ) {
+    if( overflow ) return 0;
+    node c = nodes[ n ];
+    if( c.level == 4 ) {
+        uint32_t r[ 16 ];
+        rows16( n, r );
+        return center_leaf( r );
+    }
+    return join( nodes[ c.nw ].se, nodes[ c.ne ].sw, nodes[ c.sw ].ne, nodes[ c.se ].nw );
+}
+
+uint32_t life_hash::center_h( uint32_t w, uint32_t e ) {
+    if( overflow ) return 0;
+    node a = nodes[ w ], b = nodes[ e ];
+    return join( a.ne, b.nw, a.se, b.sw );
+}
+
+uint32_t life_hash::center_v( uint32_t n, uint32_t s ) {
+    if( overflow ) return 0;
+    node a = nodes[ n ], b = nodes[ s ];
+    return join( a.sw, a.se, b.nw, b.ne );
+}
+
+// Level L node to its level L - 1 center after 2^j generations, j <= L - 2
+// Nine overlapping subnodes are advanced (or just centered, if j is less than the full
+// step for this level), regrouped into four, and advanced again.
+// For a given top level j every node of a level uses the same j, so one memo slot suffices
+uint32_t life_hash::step( uint32_t n, int j ) {
+    if( overflow ) return 0;
+    node c = nodes[ n ];
+    if( c.result_j == j ) return c.result;
+    uint32_t result;
+    if( c.level == 4 ) {
+        // 16x16 cells stepped with bitwise adders - valid area shrinks by one cell per generation
+        uint32_t r[ 16 ], next[ 16 ];
+        rows16( n, r );
+        for( int g = 0; g < ( 1 << j ); g++ ) {
+            for( int y = 1; y < 15; y++ ) {
+                uint32_t u = r[ y - 1 ], m = r[ y ], d = r[ y + 1 ];
+                uint32_t a[ 8 ] = { u << 1, u, u >> 1, m << 1, m >> 1, d << 1, d, d >> 1 };
+                uint32_t ones = 0, twos = 0, fours = 0;
+                for( uint32_t b : a ) {
+                    uint32_t c1 = ones & b;
+                    ones ^= b;
+                    uint32_t c2 = twos & c1;
+                    twos ^= c1;
+                    fours |= c2;
+                }
+                next[ y ] = twos & ~fours & ( ones | m );
+            }
+            std::copy( next + 1, next + 15, r + 1 );
+        }
+        result = center_leaf( r );
+    }
+    else {
+        uint32_t s[ 9 ] = {
+            c.nw,                   center_h( c.nw, c.ne ), c.ne,
+            center_v( c.nw, c.sw ), center( n ),            center_v( c.ne, c.se ),
+            c.sw,                   center_h( c.sw, c.se ), c.se };
+        bool full = ( j == c.level - 2 );
+        for( auto& q : s ) q = full ? step( q, j - 1 ) : center( q );
+        int j2 = full ? j - 1 : j;
+        result = join(
+            step( join( s[ 0 ], s[ 1 ], s[ 3 ], s[ 4 ] ), j2 ), step( join( s[ 1 ], s[ 2 ], s[ 4 ], s[ 5 ] ), j2 ),
+            step( join( s[ 3 ], s[ 4 ], s[ 6 ], s[ 7 ] ), j2 ), step( join( s[ 4 ], s[ 5 ], s[ 7 ], s[ 8 ] ), j2 ) );
+    }
+    if( overflow ) return 0;
+    nodes[ n ].result = result;
+    nodes[ n ].result_j = j;
+    return result;
+}
+
+// torus repeats to fill the square
+uint32_t life_hash::build( const life_bits& bits, int x, int y, int level ) {
+    const vec2i& dim = bits.get_dim();
+    if( level == 3 ) {
+        uint64_t c = 0;
+        for( int i = 0; i < 64; i++ ) c |= (uint64_t)bits.get( vec2i( ( x + ( i & 7 ) ) % dim.x, ( y + ( i >> 3 ) ) % dim.y ) ) << i;
+        return leaf( c );
+    }
+    int h = 1 << ( level - 1 );
+    return join( build( bits, x, y, level - 1 ), build( bits, x + h, y, level - 1 ),
+                 build( bits, x, y + h, level - 1 ), build( bits, x + h, y + h, level - 1 ) );
+}
+
+void life_hash::write( life_bits& bits, uint32_t n, int x, int y ) {
+    const vec2i& dim = bits.get_dim();
+    if( x >= dim.x || y >= dim.y ) return;
+    node c = nodes[ n ];
+    if( c.level == 3 ) {
+        uint64_t b = cells( n );
+        for( int i = 0; i < 64; i++ ) {
+            vec2i p( x + ( i & 7 ), y + ( i >> 3 ) );
+            if( p.x < dim.x && p.y < dim.y ) bits.set( p, ( b >> i ) & 1 );
+        }
+        return;
+    }
+    int h = 1 << ( c.level - 1 );
+    write( bits, c.nw, x, y );     write( bits, c.ne, x + h, y );
+    write( bits, c.sw, x, y + h ); write( bits, c.se, x + h, y + h );
+}
+
+void life_hash::advance( life_bits& bits, unsigned long long n ) {
+    const vec2i& dim = bits.get_dim();
+    int side = std::max( dim.x, dim.y );
+    int k = std::countr_zero( (unsigned int)side );
+    bool pow2 = std::has_single_bit( (unsigned int)dim.x ) && std::has_single_bit( (unsigned int)dim.y );
+    // quadtree needs plain Life, 8x8 leaves and a jump of at least half a side
+    if( !bits.plain() || !pow2 || k < 3 || n < (unsigned long long)side / 2 ) {
+        bits.step( n );
+        return;
+    }
+    if( nodes.size() > max_nodes / 2 ) clear();  // keep memo between jumps while there is room
+    uint32_t root = build( bits, 0, 0, k );
+    while( n ) {
+        int j = std::min( k - 1, 63 - std::countl_zero( n ) );
+        uint32_t r = step( join( root, root, root, root ), j );
+        if( overflow ) {
+            // table full - finish this stretch on packed cells and start a fresh table
+            write( bits, root, 0, 0 );
+            clear();
+            bits.step( 1ull << j );
+            root = build( bits, 0, 0, k );
+        }
+        else {
+            // result is centered, so the torus comes back shifted by half a side
+            node c = nodes[ r ];
+            root = join( c.se, c.sw, c.ne, c.nw );
+        }
+        n -= 1ull << j;
+    }
+    write( bits, root, 0, 0 );
+}
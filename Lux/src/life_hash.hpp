@@ -0,0 +1,55 @@
+// Hashlife - memoized quadtree Game of Life (Gosper 1984)
+// Identical quadrants share one node and each node remembers its future, so patterns with
+// repeated structure advance many generations in time far below linear.
+// A torus with power of two sides tiles the plane with period of the quadtree, so the
+// centered result of four copies of the torus is the torus itself, shifted by half a side.
+
+#ifndef __LIFE_HASH_HPP
+#define __LIFE_HASH_HPP
+
+#include <vector>
+#include <cstdint>
+#include "life_bits.hpp"
+
+class life_hash {
+    // Leaves are 8x8 blocks (level 3) with cells in bits y * 8 + x of nw | ne << 32
+    struct node {
+        uint32_t nw, ne, sw, se;  // quadrants, or cells of a leaf
+        uint32_t result;          // memoized step
+        int8_t level;             // side is 2^level
+        int8_t result_j;          // log2 of generations in result, -1 if none
+    };
+    static constexpr uint32_t leaf_mark = 0xffffffff;   // sw and se of leaves
+    static constexpr uint32_t empty = 0xffffffff;       // unused table slot
+
+    std::vector< node > nodes;
+    std::vector< uint32_t > table;        // open addressed - node indices by quadrants
+    size_t max_nodes;                     // table is cleared when it grows past this
+    bool overflow;                        // set if table filled up during a step
+
+    uint32_t find( uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se, int level );
+    void rehash( size_t slots );
+    uint32_t leaf( uint64_t cells ) { return find( (uint32_t)cells, (uint32_t)( cells >> 32 ), leaf_mark, leaf_mark, 3 ); }
+    uint64_t cells( uint32_t n ) const { return nodes[ n ].nw | ( (uint64_t)nodes[ n ].ne << 32 ); }
+    uint32_t join( uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se ) { return find( nw, ne, sw, se, nodes[ nw ].level + 1 ); }
+    void rows16( uint32_t n, uint32_t* r ) const;         // level 4 node as sixteen rows
+    uint32_t center_leaf( const uint32_t* r );            // middle 8x8 of sixteen rows
+    uint32_t center( uint32_t n );                        // center quadrant, one level down
+    uint32_t center_h( uint32_t w, uint32_t e );          // between two nodes side by side
+    uint32_t center_v( uint32_t n, uint32_t s );          // between two nodes stacked
+    uint32_t step( uint32_t n, int j );                   // center after 2^j generations
+    uint32_t build( const life_bits& bits, int x, int y, int level );
+    void write( life_bits& bits, uint32_t n, int x, int y );
+    void clear();
+
+public:
+    // Runs n generations of bits. Uses the quadtree for power of two tori when the jump
+    // is long enough to pay for building it, packed stepping otherwise
+    void advance( life_bits& bits, unsigned long long n );
+
+    size_t size() const { return nodes.size(); }
+
+    life_hash( size_t max_nodes_init = 1 << 21 );
+};
+
+#endif // __LIFE_HASH_HPP
@@ -0,0 +1,154 @@
+// Vector kernels for Margolus family CA rules - four 2x2 blocks per step
+// SSE2 (table lookup with SSSE3 when available) or wasm simd128. Without either,
+// the kernels process no blocks and the caller runs the scalar rule.
+
+#ifndef __LIFE_SIMD_HPP
+#define __LIFE_SIMD_HPP
+
+#include "ucolor.hpp"
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#define LIFE_SIMD
+#include <emmintrin.h>
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+typedef __m128i vec4u;
+
+static inline vec4u v_load( const ucolor* p )       { return _mm_loadu_si128( (const __m128i*)p ); }
+static inline void  v_store( ucolor* p, vec4u v )   { _mm_storeu_si128( (__m128i*)p, v ); }
+static inline vec4u v_set1( unsigned int a )        { return _mm_set1_epi32( (int)a ); }
+static inline vec4u v_and( vec4u a, vec4u b )       { return _mm_and_si128( a, b ); }
+static inline vec4u v_or(  vec4u a, vec4u b )       { return _mm_or_si128( a, b ); }
+static inline vec4u v_add( vec4u a, vec4u b )       { return _mm_add_epi32( a, b ); }
+static inline vec4u v_srl( vec4u a, int n )         { return _mm_srli_epi32( a, n ); }
+static inline vec4u v_gt(  vec4u a, vec4u b )       { return _mm_cmpgt_epi32( a, b ); }
+static inline vec4u v_lt(  vec4u a, vec4u b )       { return _mm_cmplt_epi32( a, b ); }
+static inline vec4u v_select( vec4u m, vec4u a, vec4u b ) { return _mm_or_si128( _mm_and_si128( m, a ), _mm_andnot_si128( m, b ) ); }
+static inline vec4u v_absdiff8( vec4u a, vec4u b )  { return _mm_or_si128( _mm_subs_epu8( a, b ), _mm_subs_epu8( b, a ) ); }
+// even and odd lanes of a:b
+static inline vec4u v_even( vec4u a, vec4u b ) { return _mm_castps_si128( _mm_shuffle_ps( _mm_castsi128_ps( a ), _mm_castsi128_ps( b ), _MM_SHUFFLE( 2, 0, 2, 0 ) ) ); }
+static inline vec4u v_odd(  vec4u a, vec4u b ) { return _mm_castps_si128( _mm_shuffle_ps( _mm_castsi128_ps( a ), _mm_castsi128_ps( b ), _MM_SHUFFLE( 3, 1, 3, 1 ) ) ); }
+// interleave low and high halves of a and b
+static inline vec4u v_zip_lo( vec4u a, vec4u b ) { return _mm_unpacklo_epi32( a, b ); }
+static inline vec4u v_zip_hi( vec4u a, vec4u b ) { return _mm_unpackhi_epi32( a, b ); }
+
+// all ones in lanes where bit idx (0-63) of table is set
+static inline vec4u v_lookup64( const unsigned long long& table, vec4u idx ) {
+#ifdef __SSSE3__
+    // byte idx / 8 of table, tested against bit idx % 8. High bit in index bytes gives zero
+    const vec4u high = v_set1( 0x80808000 );
+    vec4u bytes = _mm_shuffle_epi8( _mm_set_epi64x( 0, (long long)table ), v_or( v_srl( idx, 3 ), high ) );
+    vec4u bits  = _mm_shuffle_epi8( _mm_set_epi64x( 0, 0x8040201008040201ll ), v_or( v_and( idx, v_set1( 7 ) ), high ) );
+    return v_gt( v_and( bytes, bits ), _mm_setzero_si128() );
+#else
+    alignas( 16 ) unsigned int f[ 4 ];
+    _mm_store_si128( (__m128i*)f, idx );
+    for( int i = 0; i < 4; i++ ) f[ i ] = ( ( table >> f[ i ] ) & 1 ) ? 0xffffffff : 0;
+    return _mm_load_si128( (const __m128i*)f );
+#endif
+}
+
+#elif defined( __wasm_simd128__ )
+#define LIFE_SIMD
+#include <wasm_simd128.h>
+typedef v128_t vec4u;
+
+static inline vec4u v_load( const ucolor* p )       { return wasm_v128_load( p ); }
+static inline void  v_store( ucolor* p, vec4u v )   { wasm_v128_store( p, v ); }
+static inline vec4u v_set1( unsigned int a )        { return wasm_i32x4_splat( (int)a ); }
+static inline vec4u v_and( vec4u a, vec4u b )       { return wasm_v128_and( a, b ); }
+static inline vec4u v_or(  vec4u a, vec4u b )       { return wasm_v128_or( a, b ); }
+static inline vec4u v_add( vec4u a, vec4u b )       { return wasm_i32x4_add( a, b ); }
+static inline vec4u v_srl( vec4u a, int n )         { return wasm_u32x4_shr( a, n ); }
+static inline vec4u v_gt(  vec4u a, vec4u b )       { return wasm_i32x4_gt( a, b ); }
+static inline vec4u v_lt(  vec4u a, vec4u b )       { return wasm_i32x4_lt( a, b ); }
+static inline vec4u v_select( vec4u m, vec4u a, vec4u b ) { return wasm_v128_bitselect( a, b, m ); }
+static inline vec4u v_absdiff8( vec4u a, vec4u b )  { return wasm_v128_or( wasm_u8x16_sub_sat( a, b ), wasm_u8x16_sub_sat( b, a ) ); }
+static inline vec4u v_even( vec4u a, vec4u b )      { return wasm_i32x4_shuffle( a, b, 0, 2, 4, 6 ); }
+static inline vec4u v_odd(  vec4u a, vec4u b )      { return wasm_i32x4_shuffle( a, b, 1, 3, 5, 7 ); }
+static inline vec4u v_zip_lo( vec4u a, vec4u b )    { return wasm_i32x4_shuffle( a, b, 0, 4, 1, 5 ); }
+static inline vec4u v_zip_hi( vec4u a, vec4u b )    { return wasm_i32x4_shuffle( a, b, 2, 6, 3, 7 ); }
+
+static inline vec4u v_lookup64( const unsigned long long& table, vec4u idx ) {
+    // swizzle gives zero for indices of 16 and above
+    const vec4u high = v_set1( 0x80808000 );
+    vec4u bytes = wasm_i8x16_swizzle( wasm_i64x2_make( (long long)table, 0 ), v_or( v_srl( idx, 3 ), high ) );
+    vec4u bits  = wasm_i8x16_swizzle( wasm_i64x2_make( 0x8040201008040201ll, 0 ), v_or( v_and( idx, v_set1( 7 ) ), high ) );
+    return v_gt( v_and( bytes, bits ), wasm_i32x4_splat( 0 ) );
+}
+#endif
+
+// Parameters of funky sort for one frame
+struct funky_kernel {
+    int rot;                // direction - number of quarter turns from block into rule's frame
+    int max_diff;           // maximum manhattan distance for a pair to count as similar
+    unsigned long long funk_l, funk_r;  // truth tables (diagonal sort uses funk_l only)
+};
+
+#ifdef LIFE_SIMD
+
+// r + g + b in each lane
+static inline vec4u v_rgb_sum( vec4u v ) {
+    const vec4u m = v_set1( 0x00ff00ff );
+    v = v_and( v, v_set1( 0x00ffffff ) );
+    vec4u s = v_add( v_and( v, m ), v_and( v_srl( v, 8 ), m ) );
+    return v_and( v_add( s, v_srl( s, 16 ) ), v_set1( 0xffff ) );
+}
+
+// lanes where manhattan distance is below threshold, as bit b
+static inline vec4u v_funk_bit( vec4u a, vec4u b, vec4u thresh, unsigned int bit ) {
+    return v_and( v_lt( v_rgb_sum( v_absdiff8( a, b ) ), thresh ), v_set1( bit ) );
+}
+
+// Funky sort on nblocks consecutive 2x2 blocks - upper pixels start at up, lower at lo.
+// Same result as rule_funky_sort / rule_diagonal_funky_sort on each block.
+// Returns number of blocks processed (a multiple of four); caller runs the rest.
+template< bool diagonal > int funky_sort_blocks( const funky_kernel& k, const ucolor* up, const ucolor* lo, ucolor* out_up, ucolor* out_lo, int nblocks ) {
+    // manhattan distance is at most 765 - compare as unsigned like the scalar rule
+    const vec4u thresh = v_set1( ( k.max_diff < 0 || k.max_diff > 766 ) ? 766 : k.max_diff );
+    int n = nblocks & ~3;
+    for( int b = 0; b < n; b += 4 ) {
+        vec4u u0 = v_load( up + 2 * b ), u1 = v_load( up + 2 * b + 4 );
+        vec4u l0 = v_load( lo + 2 * b ), l1 = v_load( lo + 2 * b + 4 );
+        // block pixels clockwise from upper left, one block per lane
+        vec4u m[ 4 ] = { v_even( u0, u1 ), v_odd( u0, u1 ), v_odd( l0, l1 ), v_even( l0, l1 ) };
+        // rotate into rule's frame by renaming
+        vec4u ul = m[ k.rot & 3 ], ur = m[ ( k.rot + 1 ) & 3 ], lr = m[ ( k.rot + 2 ) & 3 ], ll = m[ ( k.rot + 3 ) & 3 ];
+
+        vec4u funk = v_or( v_or( v_or( v_funk_bit( ur, lr, thresh, 1 ),  v_funk_bit( lr, ll, thresh, 2 ) ),
+                                 v_or( v_funk_bit( ll, ul, thresh, 4 ),  v_funk_bit( ul, ur, thresh, 8 ) ) ),
+                                 v_or( v_funk_bit( ul, lr, thresh, 16 ), v_funk_bit( ur, ll, thresh, 32 ) ) );
+        vec4u wul = v_rgb_sum( ul ), wur = v_rgb_sum( ur ), wll = v_rgb_sum( ll );
+        vec4u rul, rur, rlr, rll;
+        if( diagonal ) {
+            vec4u swap = v_and( v_lookup64( k.funk_l, funk ), v_gt( wll, wur ) );
+            rul = ul; rlr = lr;
+            rll = v_select( swap, ur, ll );
+            rur = v_select( swap, ll, ur );
+        }
+        else {
+            vec4u wlr = v_rgb_sum( lr );
+            vec4u swap_l = v_and( v_lookup64( k.funk_l, funk ), v_gt( wll, wul ) );
+            vec4u swap_r = v_and( v_lookup64( k.funk_r, funk ), v_gt( wlr, wur ) );
+            rul = v_select( swap_l, ll, ul ); rll = v_select( swap_l, ul, ll );
+            rur = v_select( swap_r, lr, ur ); rlr = v_select( swap_r, ur, lr );
+        }
+        // rotate back and interleave blocks into rows
+        vec4u r[ 4 ];
+        r[ k.rot & 3 ] = rul; r[ ( k.rot + 1 ) & 3 ] = rur; r[ ( k.rot + 2 ) & 3 ] = rlr; r[ ( k.rot + 3 ) & 3 ] = rll;
+        v_store( out_up + 2 * b,     v_zip_lo( r[ 0 ], r[ 1 ] ) );
+        v_store( out_up + 2 * b + 4, v_zip_hi( r[ 0 ], r[ 1 ] ) );
+        v_store( out_lo + 2 * b,     v_zip_lo( r[ 3 ], r[ 2 ] ) );
+        v_store( out_lo + 2 * b + 4, v_zip_hi( r[ 3 ], r[ 2 ] ) );
+    }
+    return n;
+}
+
+#else
+
+template< bool diagonal > int funky_sort_blocks( const funky_kernel& k, const ucolor* up, const ucolor* lo, ucolor* out_up, ucolor* out_lo, int nblocks ) { return 0; }
+
+#endif // LIFE_SIMD
+
+#endif // __LIFE_SIMD_HPP
@@ -15,35 +15,46 @@
 #include <string>
 #include <iomanip>
 
-void render( std::string scene_filename, std::string file_out, vec2i dim = { 512, 512 } ) {
+void render( std::string scene_filename, std::string file_out, int skip = 0, vec2i dim = { 512, 512 } ) {
     scene s( scene_filename );
     //std::cout << "Scene object created" << std::endl;
-    s.render_and_save( file_out, dim );
+    s.render_and_save( file_out, dim, PIXEL_UCOLOR, FILE_JPG, 100, skip );
     //std::cout << "Render complete " << file_out << std::endl;
 }
 
-void animate( std::string scene_filename, std::string basename, int nframes ) {
+void animate( std::string scene_filename, std::string basename, int nframes, int skip = 0 ) {
     //std::cout << "scene::animate" << std::endl;
     scene s( scene_filename );
     //std::cout << "Scene object created" << std::endl;
-    s.animate( basename, nframes );
+    s.animate( basename, nframes, { 512, 512 }, PIXEL_UCOLOR, FILE_JPG, 100, skip );
     //std::cout << "Render complete " << basename << std::endl;
 }
 
 int main( int argc, char** argv ) {
-    if( argc < 3 ) {
-        std::cout << "Usage: ./lux file_in file_out [nframes]\n";
+    // --skip-frames n advances the scene n frames before the first saved frame
+    std::vector< std::string > args;
+    int skip = 0;
+    for( int i = 1; i < argc; i++ ) {
+        std::string arg( argv[ i ] );
+        if( arg == "--skip-frames" && i + 1 < argc ) {
+            std::stringstream ss( argv[ ++i ] );
+            ss >> skip;
+        }
+        else args.push_back( arg );
+    }
+    if( args.size() < 2 ) {
+        std::cout << "Usage: ./lux file_in file_out [nframes] [--skip-frames n]\n";
         return 0;
     }
-    std::string scene_filename(  argv[ 1 ] );
-    std::string output_name( argv[ 2 ] );
+    std::string scene_filename(  args[ 0 ] );
+    std::string output_name( args[ 1 ] );
     
-    if( argc == 3 ) render( scene_filename, output_name /*, { 3648, 3648 } */);
+    if( args.size() == 2 ) render( scene_filename, output_name, skip /*, { 3648, 3648 } */);
     else {
         int nframes;
-        std::stringstream ss( argv[ 3 ] );
+        std::stringstream ss( args[ 2 ] );
         ss >> nframes; 
-        animate( scene_filename, output_name, nframes );
+        animate( scene_filename, output_name, nframes, skip );
     }
     
     //std::cout << "Done!" << std::endl;
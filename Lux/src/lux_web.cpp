@@ -12,6 +12,7 @@
 #include <emscripten/bind.h>
 #include <emscripten/val.h>
 #include "emscripten_utils.hpp"
+#include "joy_log.hpp"
 #include "video_recorder.hpp"
 #include <chrono>
 
@@ -48,8 +49,8 @@ val get_buf1() {
     if (!global_context || !global_context->buf) {
         return val::null();
     }
-    uimage& img = (uimage &)(global_context->buf->get_image());
-    unsigned char* buffer = (unsigned char* )img.get_base_ptr();
+    const uimage& img = (uimage &)(global_context->buf->get_image());
+    unsigned char* buffer = (unsigned char* )img.get_base_ptr();    // read only - leaves shared pixels shared
     size_t buffer_length = img.get_dim().x * img.get_dim().y * 4; // Assuming 4 bytes per pixel (RGBA)
 
     //std::cout << "get_img_data() buffer length: " << buffer_length << std::endl;
@@ -68,7 +69,7 @@ val get_buf2() {
     if (!global_context || !global_context->buf) {
         return val::null();
     }
-    uimage& img = (uimage &)(global_context->buf->get_buffer());
+    const uimage& img = (uimage &)(global_context->buf->get_buffer());
     unsigned char* buffer = (unsigned char* )img.get_base_ptr();
     size_t buffer_length = img.get_dim().x * img.get_dim().y * 4; // Assuming 4 bytes per pixel (RGBA)
 
@@ -207,7 +208,7 @@ void render_and_display( void *arg )
         // Check for buffer resize (e.g. after source image change)
         vec2i dim = global_context->buf->get_image().get_dim();
         if( dim != global_context->buf_dim ) {
-            std::cout << "resize buffer: " << dim.x << " " << dim.y << std::endl;
+            JOY_LOG( JOY_DEBUG, LOG_UI, "resize buffer: " << dim.x << " " << dim.y );
             global_context->buf_dim = dim;
             global_context->s->ui.canvas_bounds = bb2i( dim );
             if( global_context->resize_callback_ready ) global_context->resize_callback();
@@ -219,8 +220,8 @@ void render_and_display( void *arg )
 
             // add frame to recording
             if (!global_context->video_recorder->add_frame(img)) {
-                std::cerr << "Failed to add frame to recording: " <<
-                     global_context->video_recorder->get_error() << std::endl;
+                JOY_LOG( JOY_ERROR, LOG_VIDEO, "Failed to add frame to recording: " <<
+                     global_context->video_recorder->get_error() );
                 global_context->is_recording = false;
             }
         }
@@ -451,7 +452,7 @@ void set_slider_value( std::string name, float value ) {
 }
 
 void set_slider_callback( std::string name, val callback ) {
-    std::cout << "set_slider_callback: " << name << std::endl;
+    JOY_LOG( JOY_DEBUG, LOG_UI, "set_slider_callback: " << name );
     if( global_context->s->functions.contains( name ) ) {
         any_function& fn = global_context->s->functions[ name ];
         if( std::holds_alternative< any_fn< float > >( fn ) ) {
@@ -570,7 +571,7 @@ void pick_multi_direction8( std::string name, int value, int id ) {
 
 void print_vector_of_pairs( std::vector< std::pair< int, int > > pickers ) {
     for( auto& p : pickers ) {
-        std::cout << p.first << " " << p.second << std::endl;
+        JOY_LOG( JOY_DEBUG, LOG_UI, p.first << " " << p.second );
     }
 }
 
@@ -621,17 +622,14 @@ std::string get_panel_JSON() {
     nlohmann::json j;
     
     if (!global_context || !global_context->s) {
-        std::cout << "get_panel_JSON: global_context or scene not initialized!" << std::endl;
+        JOY_LOG( JOY_ERROR, LOG_UI, "get_panel_JSON: global_context or scene not initialized" );
         return "[]";
     }
 
     j = global_context->s->ui.widget_groups;
-    std::cout << "get_panel_JSON: widget_groups count: " << global_context->s->ui.widget_groups.size() << std::endl;
-    for( auto wg : global_context->s->ui.widget_groups ) {
-        std::cout << "get_panel_JSON: " << wg.name << std::endl;
-    }
-    std::cout << "get_panel_JSON: " << j.dump() << std::endl;
-    return j.dump();
+    std::string panel = j.dump();
+    JOY_LOG( JOY_DEBUG, LOG_UI, "get_panel_JSON: " << global_context->s->ui.widget_groups.size() << " widget groups " << panel );
+    return panel;
 }
 
 std::string get_widget_JSON( std::string name ) {
@@ -737,117 +735,77 @@ void add_to_menu(std::string menu_name, std::string item) {
 
 
 bool worker_add_frame(val image_data, int width, int height) {
-    std::cout << "[C++] === WORKER_ADD_FRAME START ===" << std::endl;
-    std::cout << "[C++] Function called with dimensions: " << width << "x" << height << std::endl;
+    JOY_LOG( JOY_DEBUG, LOG_VIDEO, "worker_add_frame: " << width << "x" << height );
     
     if (!global_context || !global_context->video_recorder) {
-        std::cerr << "[C++] ERROR: Cannot add frame - video recorder not initialized" << std::endl;
-        std::cerr << "[C++] - global_context: " << (global_context ? "valid" : "null") << std::endl;
-        std::cerr << "[C++] - video_recorder: " << (global_context && global_context->video_recorder ? "valid" : "null") << std::endl;
+        JOY_LOG( JOY_ERROR, LOG_VIDEO, "Cannot add frame - video recorder not initialized" );
         return false;
     }
 
     if (!global_context->is_recording) {
-        std::cerr << "[C++] ERROR: Cannot add frame - not currently recording" << std::endl;
-        std::cerr << "[C++] - is_recording flag: " << global_context->is_recording << std::endl;
+        JOY_LOG( JOY_ERROR, LOG_VIDEO, "Cannot add frame - not currently recording" );
         return false;
     }
 
     try {
-        // CRITICAL: Add detailed logging for debugging
-        std::cout << "[C++] Starting frame processing..." << std::endl;
-        std::cout << "[C++] Input validation:" << std::endl;
-        std::cout << "[C++] - Width: " << width << std::endl;
-        std::cout << "[C++] - Height: " << height << std::endl;
-        
         // Validate dimensions
         if (width <= 0 || height <= 0) {
-            std::cerr << "[C++] ERROR: Invalid dimensions: " << width << "x" << height << std::endl;
+            JOY_LOG( JOY_ERROR, LOG_VIDEO, "worker_add_frame: invalid dimensions: " << width << "x" << height );
             return false;
         }
         
         // Check if image_data is valid
         if (image_data.isNull() || image_data.isUndefined()) {
-            std::cerr << "[C++] ERROR: Image data is null or undefined" << std::endl;
+            JOY_LOG( JOY_ERROR, LOG_VIDEO, "worker_add_frame: image data is null or undefined" );
             return false;
         }
         
         // CRITICAL FIX: Use proper Emscripten typed memory view
         const int total_pixels = width * height;
         const int expected_length = total_pixels * 4; // RGBA
-        std::cout << "[C++] Data validation:" << std::endl;
-        std::cout << "[C++] - Total pixels: " << total_pixels << std::endl;
-        std::cout << "[C++] - Expected length: " << expected_length << std::endl;
         
         // Get the length property to validate
         int actual_length = image_data["length"].as<int>();
-        std::cout << "[C++] - Actual length: " << actual_length << std::endl;
         
         if (actual_length != expected_length) {
-            std::cerr << "[C++] ERROR: Image data length mismatch: got " << actual_length << ", expected " << expected_length << std::endl;
+            JOY_LOG( JOY_ERROR, LOG_VIDEO, "worker_add_frame: image data length mismatch: got " << actual_length << ", expected " << expected_length );
             return false;
         }
         
-        std::cout << "[C++] Converting JavaScript array to memory view..." << std::endl;
         // CRITICAL FIX: Convert the JavaScript typed array to a proper memory view
         // This creates a typed_memory_view from the JavaScript Uint8ClampedArray
         auto memory_view = emscripten::convertJSArrayToNumberVector<uint8_t>(image_data);
         
         if (memory_view.size() != expected_length) {
-            std::cerr << "[C++] ERROR: Memory view size mismatch: got " << memory_view.size() << ", expected " << expected_length << std::endl;
+            JOY_LOG( JOY_ERROR, LOG_VIDEO, "worker_add_frame: memory view size mismatch: got " << memory_view.size() << ", expected " << expected_length );
             return false;
         }
-        std::cout << "[C++] Memory view conversion successful, size: " << memory_view.size() << std::endl;
 
         // Debug: Check recording dimensions vs frame dimensions
-        if (global_context->video_recorder) {
+        if( JOY_LOG_ON( JOY_DEBUG, LOG_VIDEO ) ) {
             auto opts = global_context->video_recorder->get_options();
-            std::cout << "[C++] Recording settings:" << std::endl;
-            std::cout << "[C++] - Recording dimensions: " << opts.width << "x" << opts.height << std::endl;
-            std::cout << "[C++] - Recording FPS: " << opts.fps << std::endl;
-            std::cout << "[C++] - Recording bitrate: " << opts.bitrate << std::endl;
-            std::cout << "[C++] - Recording codec: " << opts.codec << std::endl;
-            std::cout << "[C++] Frame dimensions: " << width << "x" << height << std::endl;
-            if (opts.width != width || opts.height != height) {
-                std::cout << "[C++] WARNING: Dimensions differ - will scale frame to match recording settings" << std::endl;
-            } else {
-                std::cout << "[C++] Dimensions match - no scaling needed" << std::endl;
-            }
+            JOY_LOG( JOY_DEBUG, LOG_VIDEO, "recording " << opts.width << "x" << opts.height << " fps " << opts.fps << " bitrate " << opts.bitrate
+                << " codec " << opts.codec << " state " << static_cast<int>(global_context->video_recorder->get_state())
+                << ( ( opts.width != width || opts.height != height ) ? " - frame will be scaled" : "" ) );
         }
 
-        // Check recorder state before processing
-        auto recorder_state = global_context->video_recorder->get_state();
-        std::cout << "[C++] Video recorder state: " << static_cast<int>(recorder_state) << std::endl;
-        
         // OPTIMIZED: Use RGBA data directly - no conversion to ucolor needed
-        std::cout << "[C++] Using RGBA data directly, converting to YUV420P" << std::endl;
-
-        // Add frame to recording using efficient RGBA method
-        std::cout << "[C++] Calling add_frame_rgba..." << std::endl;
         bool success = global_context->video_recorder->add_frame_rgba(memory_view.data(), width, height);
-        std::cout << "[C++] add_frame_rgba returned: " << (success ? "SUCCESS" : "FAILURE") << std::endl;
         
         if (!success) {
-            std::cerr << "[C++] ERROR: Failed to add RGBA frame to recording" << std::endl;
-            std::string error_msg = global_context->video_recorder->get_error();
-            std::cerr << "[C++] - Error message: " << error_msg << std::endl;
-            auto final_state = global_context->video_recorder->get_state();
-            std::cerr << "[C++] - Final recording state: " << static_cast<int>(final_state) << std::endl;
-            int frame_count = global_context->video_recorder->get_frame_count();
-            std::cerr << "[C++] - Current frame count: " << frame_count << std::endl;
+            JOY_LOG( JOY_ERROR, LOG_VIDEO, "Failed to add RGBA frame to recording: " << global_context->video_recorder->get_error()
+                << " - state " << static_cast<int>(global_context->video_recorder->get_state())
+                << " frame count " << global_context->video_recorder->get_frame_count() );
         } else {
-            int frame_count = global_context->video_recorder->get_frame_count();
-            std::cout << "[C++] SUCCESS: RGBA frame converted to YUV420P and added successfully" << std::endl;
-            std::cout << "[C++] - Current frame count: " << frame_count << std::endl;
+            JOY_LOG( JOY_DEBUG, LOG_VIDEO, "worker_add_frame: frame count " << global_context->video_recorder->get_frame_count() );
         }
         
-        std::cout << "[C++] === WORKER_ADD_FRAME END ===" << std::endl;
         return success;
     } catch (const std::exception& e) {
-        std::cerr << "[C++] EXCEPTION in worker_add_frame: " << e.what() << std::endl;
+        JOY_LOG( JOY_ERROR, LOG_VIDEO, "Exception in worker_add_frame: " << e.what() );
         return false;
     } catch (...) {
-        std::cerr << "[C++] UNKNOWN EXCEPTION in worker_add_frame" << std::endl;
+        JOY_LOG( JOY_ERROR, LOG_VIDEO, "Unknown exception in worker_add_frame" );
         return false;
     }
 }
@@ -1157,71 +1115,65 @@ void init_ultra_camera() {
 
 // ULTRA-FAST camera frame update with zero-copy RGBA→ARGB conversion
 bool ultra_update_camera_frame(val image_data, int width, int height) {
-    std::cout << "=== ULTRA_UPDATE_CAMERA_FRAME START ===" << std::endl;
-    std::cout << "Input: " << width << "x" << height << std::endl;
+    JOY_LOG( JOY_DEBUG, LOG_CAMERA, "ultra_update_camera_frame: " << width << "x" << height );
     
     init_ultra_camera();
     
     if (!ultra_camera || !ultra_camera->buffers_initialized) {
-        std::cerr << "ERROR: Ultra camera not initialized" << std::endl;
+        JOY_LOG( JOY_ERROR, LOG_CAMERA, "Ultra camera not initialized" );
         return false;
     }
     
     // Validate input dimensions
     if (width != ultra_camera->fixed_dimensions.x || height != ultra_camera->fixed_dimensions.y) {
-        std::cerr << "ERROR: Invalid dimensions: expected " << ultra_camera->fixed_dimensions.x 
+        JOY_LOG( JOY_ERROR, LOG_CAMERA, "Invalid dimensions: expected " << ultra_camera->fixed_dimensions.x 
                   << "x" << ultra_camera->fixed_dimensions.y 
-                  << ", got " << width << "x" << height << std::endl;
+                  << ", got " << width << "x" << height );
         return false;
     }
     
     try {
         // Get the raw data from JavaScript Uint8Array
         auto length = image_data["length"].as<unsigned>();
-        std::cout << "JS array length: " << length << std::endl;
         
         // Expected size for RGBA data
         size_t expected_size = width * height * 4;
         if (length != expected_size) {
-            std::cerr << "ERROR: Size mismatch: expected " << expected_size << " bytes, got " << length << std::endl;
+            JOY_LOG( JOY_ERROR, LOG_CAMERA, "Size mismatch: expected " << expected_size << " bytes, got " << length );
             return false;
         }
         
-        // CRITICAL DEBUG: Check first few bytes from JavaScript
-        std::cout << "First 12 JS bytes: ";
-        for (int i = 0; i < 12 && i < length; i++) {
-            uint8_t val = image_data[i].as<uint8_t>();
-            std::cout << (int)val << " ";
+        // Check first few bytes from JavaScript
+        if( JOY_LOG_ON( JOY_TRACE, LOG_CAMERA ) ) {
+            std::ostringstream bytes;
+            for (int i = 0; i < 12 && i < length; i++) bytes << (int)image_data[i].as<uint8_t>() << " ";
+            JOY_LOG( JOY_TRACE, LOG_CAMERA, "First 12 JS bytes: " << bytes.str() );
         }
-        std::cout << std::endl;
         
         // Check if JS data has any non-zero values
         int js_non_zero = 0;
         for (size_t i = 0; i < std::min((size_t)1000, (size_t)length); i++) {
             if (image_data[i].as<uint8_t>() > 0) js_non_zero++;
         }
-        std::cout << "JS non-zero count (first 1000): " << js_non_zero << std::endl;
         
         if (js_non_zero == 0) {
-            std::cerr << "ERROR: JavaScript data is all zeros!" << std::endl;
+            JOY_LOG( JOY_ERROR, LOG_CAMERA, "JavaScript camera data is all zeros" );
             return false;
         }
         
         // Get camera buffer for writing
         auto camera_buffer = &(ultra_camera->camera_buffer->get_image());
         if (!camera_buffer) {
-            std::cerr << "ERROR: Camera buffer not available" << std::endl;
+            JOY_LOG( JOY_ERROR, LOG_CAMERA, "Camera buffer not available" );
             return false;
         }
         
         ucolor* camera_pixels = camera_buffer->get_base_ptr();
         if (!camera_pixels) {
-            std::cerr << "ERROR: Camera pixels not available" << std::endl;
+            JOY_LOG( JOY_ERROR, LOG_CAMERA, "Camera pixels not available" );
             return false;
         }
         
-        std::cout << "Processing pre-converted ARGB data from frontend..." << std::endl;
-        
         // OPTIMIZED: Frontend now sends ARGB data (matching still image capture pattern)
         // No conversion needed - directly copy bytes to ucolor buffer
         size_t pixel_count = width * height;
@@ -1230,7 +1182,7 @@ bool ultra_update_camera_frame(val image_data, int width, int height) {
             
             // Bounds check
             if (argb_idx + 3 >= length) {
-                std::cerr << "ERROR: Bounds error at pixel " << i << std::endl;
+                JOY_LOG( JOY_ERROR, LOG_CAMERA, "Bounds error at pixel " << i );
                 break;
             }
             
@@ -1244,65 +1196,45 @@ bool ultra_update_camera_frame(val image_data, int width, int height) {
         }
         
         // VERIFY: Check camera buffer after conversion
-        int camera_non_zero = 0;
-        for (int i = 0; i < std::min(100, (int)pixel_count); i++) {
-            uint32_t pixel = camera_pixels[i];
-            uint8_t r = (pixel >> 16) & 0xFF;
-            uint8_t g = (pixel >> 8) & 0xFF;
-            uint8_t b = pixel & 0xFF;
-            if (r > 0 || g > 0 || b > 0) camera_non_zero++;
-        }
-        std::cout << "Camera buffer non-zero after conversion: " << camera_non_zero << "/100" << std::endl;
-        
-        if (camera_non_zero > 0) {
-            std::cout << "First 3 camera pixels: ";
-            for (int i = 0; i < 3; i++) {
-                uint32_t pixel = camera_pixels[i];
-                uint8_t r = (pixel >> 16) & 0xFF;
-                uint8_t g = (pixel >> 8) & 0xFF;
-                uint8_t b = pixel & 0xFF;
-                std::cout << "(" << (int)r << "," << (int)g << "," << (int)b << ") ";
+        if( JOY_LOG_ON( JOY_TRACE, LOG_CAMERA ) ) {
+            int camera_non_zero = 0;
+            for (int i = 0; i < std::min(100, (int)pixel_count); i++) {
+                if (camera_pixels[i] & 0x00FFFFFF) camera_non_zero++;
             }
-            std::cout << std::endl;
+            JOY_LOG( JOY_TRACE, LOG_CAMERA, "Camera buffer non-zero after conversion: " << camera_non_zero << "/100" );
         }
         
         ultra_camera->frame_count++;
-        std::cout << "SUCCESS: Frame " << ultra_camera->frame_count << " updated" << std::endl;
-        std::cout << "=== ULTRA_UPDATE_CAMERA_FRAME END ===" << std::endl;
+        JOY_LOG( JOY_DEBUG, LOG_CAMERA, "Frame " << ultra_camera->frame_count << " updated" );
         return true;
         
     } catch (const std::exception& e) {
-        std::cerr << "ERROR: Exception in ultra_update_camera_frame: " << e.what() << std::endl;
-        std::cout << "=== ULTRA_UPDATE_CAMERA_FRAME END (ERROR) ===" << std::endl;
+        JOY_LOG( JOY_ERROR, LOG_CAMERA, "Exception in ultra_update_camera_frame: " << e.what() );
         return false;
     }
 }
 
 bool ultra_process_camera_with_kaleidoscope() {
-    std::cout << "=== SCENE_INTEGRATED_CAMERA_PROCESSING START ===" << std::endl;
+    JOY_LOG( JOY_DEBUG, LOG_CAMERA, "ultra_process_camera_with_kaleidoscope" );
     
     if (!ultra_camera || !ultra_camera->is_active || !global_context || !global_context->s) {
-        std::cerr << "ERROR: Ultra camera not active or context not available" << std::endl;
+        JOY_LOG( JOY_ERROR, LOG_CAMERA, "Ultra camera not active or context not available" );
         return false;
     }
     
     try {
         // STEP 1: Verify ultra_camera buffer exists in scene
         if (!global_context->s->buffers.count("ultra_camera")) {
-            std::cerr << "ERROR: ultra_camera buffer not found in scene buffers" << std::endl;
+            JOY_LOG( JOY_ERROR, LOG_CAMERA, "ultra_camera buffer not found in scene buffers" );
             return false;
         }
         
         auto camera_buffer = std::get<ubuf_ptr>(global_context->s->buffers["ultra_camera"]);
         if (!camera_buffer || !camera_buffer->has_image()) {
-            std::cerr << "ERROR: Camera buffer invalid or has no image" << std::endl;
+            JOY_LOG( JOY_ERROR, LOG_CAMERA, "Camera buffer invalid or has no image" );
             return false;
         }
         
-        std::cout << "✓ Camera buffer verified with image data" << std::endl;
-        
-        std::cout << "Triggering scene render with current frontend settings..." << std::endl;
-        
         global_context->s->ui.displayed = false;
         
         // Execute scene render - this will:
@@ -1311,15 +1243,11 @@ bool ultra_process_camera_with_kaleidoscope() {
         // 3. Render the result to the main output buffer
         global_context->s->render();
         
-        std::cout << "✓ Scene render completed with frontend-controlled effects" << std::endl;
-        
         // STEP 3: Verify scene processing worked
         if (global_context->buf && global_context->buf->has_image()) {
-            auto& main_image = global_context->buf->get_image();
+            const auto& main_image = global_context->buf->get_image();
             vec2i main_dims = main_image.get_dim();
             
-            std::cout << "Main buffer after scene processing: " << main_dims.x << "x" << main_dims.y << std::endl;
-            
             // Quick verification of output
             auto main_pixels = main_image.get_base_ptr();
             int processed_pixels = 0;
@@ -1330,22 +1258,21 @@ bool ultra_process_camera_with_kaleidoscope() {
                 }
             }
             
-            std::cout << "Scene output verification: " << processed_pixels << "/100 processed pixels" << std::endl;
+            JOY_LOG( JOY_DEBUG, LOG_CAMERA, "Scene output " << main_dims.x << "x" << main_dims.y << " verification: " << processed_pixels << "/100 processed pixels" );
             
             if (processed_pixels > 10) {
-                std::cout << "✓ Scene successfully processed camera with frontend effects" << std::endl;
                 return true;
             } else {
-                std::cout << "WARNING: Scene output appears minimal" << std::endl;
+                JOY_LOG( JOY_DEBUG, LOG_CAMERA, "Scene output appears minimal" );
                 return false;
             }
         } else {
-            std::cerr << "ERROR: No main buffer after scene processing" << std::endl;
+            JOY_LOG( JOY_ERROR, LOG_CAMERA, "No main buffer after scene processing" );
             return false;
         }
         
     } catch (const std::exception& e) {
-        std::cerr << "ERROR in scene-based camera processing: " << e.what() << std::endl;
+        JOY_LOG( JOY_ERROR, LOG_CAMERA, "Exception in scene-based camera processing: " << e.what() );
         return false;
     }
 }
@@ -1473,10 +1400,19 @@ std::string ultra_get_camera_stats() {
     return stats.dump();
 }
 
+// Turns debug messages on or off for a category by name ( "mip", "splat", "camera" ... ) or "all"
+void set_log_category( std::string name, bool on ) {
+    if( name == "all" ) { log_enable( LOG_ALL, on ); return; }
+    for( unsigned int c = 1; c; c <<= 1 ) {
+        if( name == log_category_name( c ) ) { log_enable( c, on ); return; }
+    }
+    JOY_LOG( JOY_WARN, LOG_UI, "set_log_category: unknown category " << name );
+}
+
 // Audio context management functions
 void update_audio_context(float volume, float bass, float mid, float high, bool beat, float time) {
     if (!global_context || !global_context->s) {
-        std::cout << "🎵 ❌ Audio context update failed: global_context or scene is null" << std::endl;
+        JOY_LOG( JOY_DEBUG, LOG_AUDIO, "Audio context update failed: global_context or scene is null" );
         return;
     }
     
@@ -1545,7 +1481,7 @@ void update_audio_context(float volume, float bass, float mid, float high, bool
                     for (int i = 0; i < 5; i++) { 
                         global_context->s->ui.displayed = false;
                     }
-                    std::cout << "🥁 BEAT PUNCH! Extra redraws triggered" << std::endl;
+                    JOY_LOG( JOY_TRACE, LOG_AUDIO, "Beat - extra redraws triggered" );
                 }
                 last_beat = beat;
                 
@@ -1562,9 +1498,9 @@ void update_audio_context(float volume, float bass, float mid, float high, bool
         }
         
     } catch (const std::exception& e) {
-        std::cout << "🎵 ❌ update_audio_context error: " << e.what() << std::endl;
+        JOY_LOG( JOY_ERROR, LOG_AUDIO, "update_audio_context: " << e.what() );
     } catch (...) {
-        std::cout << "🎵 ❌ update_audio_context unknown error" << std::endl;
+        JOY_LOG( JOY_ERROR, LOG_AUDIO, "update_audio_context: unknown error" );
     }
 }
 
@@ -1575,14 +1511,14 @@ void enable_audio_input(bool enabled) {
     // When disabling audio, clear all audio values to prevent residual effects
     if (!enabled) {
         global_context->s->ui.audio.reset();
-        std::cout << "🎵 🧹 Audio values cleared on disable" << std::endl;
+        JOY_LOG( JOY_DEBUG, LOG_AUDIO, "Audio values cleared on disable" );
     }
 }
 
 void set_audio_sensitivity(float sensitivity) {
     if (!global_context || !global_context->s) return;
     // Audio sensitivity is now handled by individual audio functions in the scene
-    std::cout << "🎵 🎛️ Audio sensitivity is now configured per-function in scene files" << std::endl;
+    JOY_LOG( JOY_DEBUG, LOG_AUDIO, "Audio sensitivity is now configured per-function in scene files" );
 }
 
 
@@ -1854,6 +1790,9 @@ EMSCRIPTEN_BINDINGS(my_module) {
     
     // slider value retrieval functions
     function("get_slider_value", &get_slider_value);
+
+    // debug logging by category
+    function("set_log_category", &set_log_category);
     
     // animation state functions
     function("get_animation_running", &get_animation_running);
@@ -0,0 +1,223 @@
+// Storage for an image and its mip-map levels in a single allocation
+// Level 0 is the base image. Each level above halves the one below (rounding up) down to 1x1.
+// Levels sit back to back in one aligned arena at precomputed offsets. Copies of a pyramid share
+// the arena until one of them asks for pixels to write - non-const access - which copies it then.
+// So copying an image only to read it costs nothing, and a pointer taken for writing is only good
+// until the pyramid is next copied. Code writing bands on several threads takes its pointer first,
+// on the calling thread. Moving is a pointer swap. Adding or dropping levels keeps the base in place.
+
+#ifndef __MIP_PYRAMID_HPP
+#define __MIP_PYRAMID_HPP
+
+#include <vector>
+#include <array>
+#include <new>
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+#include "vect2.hpp"
+#include "pixel_pool.hpp"
+
+// Pixel block shared by reference count, copied by the first owner to write while others hold it.
+// Blocks come from the pixel pool with a cache line of header in front, keeping pixels aligned.
+// Owners may live on different threads, but one arena is not detached from several threads at once.
+template< class T > class mip_arena {
+    static_assert( std::is_trivially_copyable_v< T >, "pixels are copied as raw memory" );
+
+    struct header {
+        std::atomic< int > refs;
+        size_t bytes;       // as allocated from the pool
+        size_t capacity;    // pixels
+    };
+    static constexpr size_t header_bytes = 64;
+    static_assert( sizeof( header ) <= header_bytes );
+
+    header* h;      // null until something is allocated
+    size_t n;       // pixels in use
+
+    static T* pixels( header* b ) { return b ? reinterpret_cast< T* >( reinterpret_cast< char* >( b ) + header_bytes ) : nullptr; }
+
+    // Unshared block for at least count pixels - the rest of the pool's size class is capacity
+    static header* allocate( size_t count ) {
+        size_t bytes = pixel_pool::class_bytes( pixel_pool::size_class( header_bytes + count * sizeof( T ) ) );
+        header* b = new( pixel_pool::get().allocate( bytes ) ) header;
+        b->refs.store( 1, std::memory_order_relaxed );
+        b->bytes = bytes;
+        b->capacity = ( bytes - header_bytes ) / sizeof( T );
+        return b;
+    }
+
+    static void release( header* b ) {
+        if( b && b->refs.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) {
+            size_t bytes = b->bytes;
+            b->~header();
+            pixel_pool::get().deallocate( b, bytes );
+        }
+    }
+
+    bool unique() const { return !h || h->refs.load( std::memory_order_acquire ) == 1; }
+
+public:
+    mip_arena() : h( nullptr ), n( 0 ) {}
+    mip_arena( const mip_arena& a ) : h( a.h ), n( a.n ) { if( h ) h->refs.fetch_add( 1, std::memory_order_relaxed ); }
+    mip_arena( mip_arena&& a ) noexcept : h( a.h ), n( a.n ) { a.h = nullptr; a.n = 0; }
+    ~mip_arena() { release( h ); }
+
+    mip_arena& operator = ( const mip_arena& a ) {
+        if( this != &a ) {
+            if( a.h ) a.h->refs.fetch_add( 1, std::memory_order_relaxed );
+            release( h );
+            h = a.h;
+            n = a.n;
+        }
+        return *this;
+    }
+
+    void swap( mip_arena& a ) noexcept { std::swap( h, a.h ); std::swap( n, a.n ); }
+
+    size_t size() const { return n; }
+    const T* data() const { return pixels( h ); }
+    bool shared() const { return !unique(); }
+
+    // Pixels below count are kept and new ones are zero, as with a vector. Shrinking never copies
+    void resize( size_t count ) {
+        if( count > n ) {
+            if( h && unique() && count <= h->capacity ) std::fill( pixels( h ) + n, pixels( h ) + count, T() );
+            else {
+                header* b = allocate( count );
+                std::copy( pixels( h ), pixels( h ) + n, pixels( b ) );
+                std::fill( pixels( b ) + n, pixels( b ) + count, T() );
+                release( h );
+                h = b;
+            }
+        }
+        n = count;
+    }
+
+    // Makes the block unshared before a write. Returns true if the pixels moved
+    bool detach() {
+        if( unique() ) return false;
+        header* b = allocate( n );
+        std::copy( pixels( h ), pixels( h ) + n, pixels( b ) );
+        release( h );
+        h = b;
+        return true;
+    }
+};
+
+template< class T > class mip_pyramid {
+public:
+    static constexpr int max_levels = 32;
+
+    // One level - indexed and iterated like the vector it replaced. Const access through a const pyramid
+    class level {
+        T* p;
+        size_t n;
+        friend class mip_pyramid;
+    public:
+        level() : p( nullptr ), n( 0 ) {}
+        T&       operator [] ( size_t i )       { return p[ i ]; }
+        const T& operator [] ( size_t i ) const { return p[ i ]; }
+        T*       begin()       noexcept { return p; }
+        const T* begin() const noexcept { return p; }
+        T*       end()         noexcept { return p + n; }
+        const T* end()   const noexcept { return p + n; }
+        T*       data()        noexcept { return p; }
+        const T* data()  const noexcept { return p; }
+        size_t size()    const noexcept { return n; }
+    };
+
+private:
+    mip_arena< T >                       arena;
+    std::array< vec2i,  max_levels >     dims;
+    std::array< size_t, max_levels + 1 > offsets;  // start of each level in arena
+    std::array< level,  max_levels >     views;    // point into arena - refreshed whenever it moves
+    int levels;
+
+    void refresh( T* base ) {
+        for( int l = 0; l < levels; l++ ) {
+            views[ l ].p = base + offsets[ l ];
+            views[ l ].n = offsets[ l + 1 ] - offsets[ l ];
+        }
+    }
+    // views stay writable only while the arena is unshared - see writable()
+    void refresh() { refresh( const_cast< T* >( arena.data() ) ); }
+    void writable() { if( arena.detach() ) refresh(); }
+
+public:
+    // Base level only. Pixels already in the base are kept if the size matches
+    void resize( const vec2i& base_dim ) {
+        levels = 1;
+        dims[ 0 ] = base_dim;
+        offsets[ 0 ] = 0;
+        offsets[ 1 ] = (size_t)base_dim.x * base_dim.y;
+        arena.resize( offsets[ 1 ] );
+        refresh();
+    }
+
+    // Allocates levels down to 1x1 above the base
+    void add_levels() {
+        levels = 1;
+        while( levels < max_levels && ( dims[ levels - 1 ].x > 1 || dims[ levels - 1 ].y > 1 ) ) {
+            dims[ levels ] = vec2i( ( dims[ levels - 1 ].x + 1 ) / 2, ( dims[ levels - 1 ].y + 1 ) / 2 );
+            offsets[ levels + 1 ] = offsets[ levels ] + (size_t)dims[ levels ].x * dims[ levels ].y;
+            levels++;
+        }
+        arena.resize( offsets[ levels ] );
+        refresh();
+    }
+
+    void drop_levels() { resize( dims[ 0 ] ); }
+
+    // Reads pixels of one level by coordinates
+    struct texel_view {
+        const T* p;
+        int w;
+        const T& operator () ( int x, int y ) const { return p[ (size_t)y * w + x ]; }
+        // x, y and its neighbours to the right, below and diagonally
+        void quad( int x, int y, T& q00, T& q10, T& q01, T& q11 ) const {
+            const T* q = p + (size_t)y * w + x;
+            q00 = q[ 0 ]; q10 = q[ 1 ]; q01 = q[ w ]; q11 = q[ w + 1 ];
+        }
+    };
+    texel_view texels( int l ) const { return { views[ l ].p, dims[ l ].x }; }
+
+    int size() const { return levels; }     // number of levels
+    const vec2i& dim( int l ) const { return dims[ l ]; }
+    bool shared() const { return arena.shared(); }   // pixels still shared with a copy
+    // non-const access is for writing - shared pixels are copied first
+    level&       operator [] ( int l )       { writable(); return views[ l ]; }
+    const level& operator [] ( int l ) const { return views[ l ]; }
+    // iterate over levels
+    level*       begin()       { writable(); return views.data(); }
+    const level* begin() const { return views.data(); }
+    level*       end()         { writable(); return views.data() + levels; }
+    const level* end()   const { return views.data() + levels; }
+
+    mip_pyramid() : levels( 1 ) { resize( vec2i( 0, 0 ) ); }
+    mip_pyramid( const mip_pyramid& m ) : arena( m.arena ), dims( m.dims ), offsets( m.offsets ), levels( m.levels ) { refresh(); }
+    mip_pyramid( mip_pyramid&& m ) noexcept : arena( std::move( m.arena ) ), dims( m.dims ), offsets( m.offsets ), levels( m.levels ) {
+        refresh();
+        m.resize( vec2i( 0, 0 ) );
+    }
+    mip_pyramid& operator = ( const mip_pyramid& m ) {
+        if( this != &m ) {
+            arena = m.arena;    // shared until one side writes
+            dims = m.dims; offsets = m.offsets; levels = m.levels;
+            refresh();
+        }
+        return *this;
+    }
+    mip_pyramid& operator = ( mip_pyramid&& m ) noexcept {
+        if( this != &m ) {
+            arena.swap( m.arena );
+            dims = m.dims; offsets = m.offsets; levels = m.levels;
+            refresh();
+            m.resize( vec2i( 0, 0 ) );
+        }
+        return *this;
+    }
+};
+
+#endif // __MIP_PYRAMID_HPP
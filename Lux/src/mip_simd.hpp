@@ -0,0 +1,174 @@
+// Vector kernels for mip-map downsampling - interior pixels of one output row
+// ucolor widens channels to 16 bits and filters four output pixels per step. frgb works on
+// the interleaved floats, one output pixel per step with its three channels in four lanes.
+// SSE2 or wasm simd128. Without either, the kernels process no pixels and the caller runs the
+// scalar blend functions. Results match the scalar ucolor kernels bit for bit.
+
+#ifndef __MIP_SIMD_HPP
+#define __MIP_SIMD_HPP
+
+#include "ucolor.hpp"
+#include "frgb.hpp"
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#define MIP_SIMD
+#include <emmintrin.h>
+typedef __m128i vec8s;   // eight 16 bit lanes - or four packed ucolors before widening
+typedef __m128  vec4f;
+
+static inline vec8s mv_load( const ucolor* p )          { return _mm_loadu_si128( (const __m128i*)p ); }
+static inline vec8s mv_load1( const ucolor* p )         { return _mm_cvtsi32_si128( (int)*p ); }
+static inline void  mv_store( ucolor* p, vec8s v )      { _mm_storeu_si128( (__m128i*)p, v ); }
+static inline vec8s mv_widen_lo( vec8s v )              { return _mm_unpacklo_epi8( v, _mm_setzero_si128() ); }
+static inline vec8s mv_widen_hi( vec8s v )              { return _mm_unpackhi_epi8( v, _mm_setzero_si128() ); }
+static inline vec8s mv_narrow( vec8s a, vec8s b )       { return _mm_packus_epi16( a, b ); }
+static inline vec8s mv_set1( unsigned short a )         { return _mm_set1_epi16( (short)a ); }
+static inline vec8s mv_alpha()                          { return _mm_set1_epi32( (int)0xff000000 ); }
+static inline vec8s mv_add( vec8s a, vec8s b )          { return _mm_add_epi16( a, b ); }
+static inline vec8s mv_sll( vec8s a, int n )            { return _mm_slli_epi16( a, n ); }
+static inline vec8s mv_srl( vec8s a, int n )            { return _mm_srli_epi16( a, n ); }
+static inline vec8s mv_or( vec8s a, vec8s b )           { return _mm_or_si128( a, b ); }
+// low and high pixels of a:b after widening
+static inline vec8s mv_lo64( vec8s a, vec8s b )         { return _mm_unpacklo_epi64( a, b ); }
+static inline vec8s mv_hi64( vec8s a, vec8s b )         { return _mm_unpackhi_epi64( a, b ); }
+
+static inline vec4f mf_load( const float* p )           { return _mm_loadu_ps( p ); }
+static inline void  mf_store( float* p, vec4f v )       { _mm_storeu_ps( p, v ); }
+static inline vec4f mf_set1( float a )                  { return _mm_set1_ps( a ); }
+static inline vec4f mf_add( vec4f a, vec4f b )          { return _mm_add_ps( a, b ); }
+static inline vec4f mf_mul( vec4f a, vec4f b )          { return _mm_mul_ps( a, b ); }
+static inline vec4f mf_sub( vec4f a, vec4f b )          { return _mm_sub_ps( a, b ); }
+static inline vec4f mf_div( vec4f a, vec4f b )          { return _mm_div_ps( a, b ); }
+static inline vec4f mf_min( vec4f a, vec4f b )          { return _mm_min_ps( a, b ); }
+static inline vec4f mf_max( vec4f a, vec4f b )          { return _mm_max_ps( a, b ); }
+static inline vec4f mf_gt( vec4f a, vec4f b )           { return _mm_cmpgt_ps( a, b ); }
+// lanes of a where mask is set, otherwise b
+static inline vec4f mf_select( vec4f mask, vec4f a, vec4f b ) { return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) ); }
+// lanes i0, i1 of a and i2, i3 of b
+template< int i0, int i1, int i2, int i3 > static inline vec4f mf_shuffle( vec4f a, vec4f b ) { return _mm_shuffle_ps( a, b, _MM_SHUFFLE( i3, i2, i1, i0 ) ); }
+
+#elif defined( __wasm_simd128__ )
+#define MIP_SIMD
+#include <wasm_simd128.h>
+typedef v128_t vec8s;
+typedef v128_t vec4f;
+
+static inline vec8s mv_load( const ucolor* p )          { return wasm_v128_load( p ); }
+static inline vec8s mv_load1( const ucolor* p )         { return wasm_v128_load32_zero( p ); }
+static inline void  mv_store( ucolor* p, vec8s v )      { wasm_v128_store( p, v ); }
+static inline vec8s mv_widen_lo( vec8s v )              { return wasm_u16x8_extend_low_u8x16( v ); }
+static inline vec8s mv_widen_hi( vec8s v )              { return wasm_u16x8_extend_high_u8x16( v ); }
+static inline vec8s mv_narrow( vec8s a, vec8s b )       { return wasm_u8x16_narrow_i16x8( a, b ); }
+static inline vec8s mv_set1( unsigned short a )         { return wasm_i16x8_splat( (short)a ); }
+static inline vec8s mv_alpha()                          { return wasm_i32x4_splat( (int)0xff000000 ); }
+static inline vec8s mv_add( vec8s a, vec8s b )          { return wasm_i16x8_add( a, b ); }
+static inline vec8s mv_sll( vec8s a, int n )            { return wasm_i16x8_shl( a, n ); }
+static inline vec8s mv_srl( vec8s a, int n )            { return wasm_u16x8_shr( a, n ); }
+static inline vec8s mv_or( vec8s a, vec8s b )           { return wasm_v128_or( a, b ); }
+static inline vec8s mv_lo64( vec8s a, vec8s b )         { return wasm_i64x2_shuffle( a, b, 0, 2 ); }
+static inline vec8s mv_hi64( vec8s a, vec8s b )         { return wasm_i64x2_shuffle( a, b, 1, 3 ); }
+
+static inline vec4f mf_load( const float* p )           { return wasm_v128_load( p ); }
+static inline void  mf_store( float* p, vec4f v )       { wasm_v128_store( p, v ); }
+static inline vec4f mf_set1( float a )                  { return wasm_f32x4_splat( a ); }
+static inline vec4f mf_add( vec4f a, vec4f b )          { return wasm_f32x4_add( a, b ); }
+static inline vec4f mf_mul( vec4f a, vec4f b )          { return wasm_f32x4_mul( a, b ); }
+static inline vec4f mf_sub( vec4f a, vec4f b )          { return wasm_f32x4_sub( a, b ); }
+static inline vec4f mf_div( vec4f a, vec4f b )          { return wasm_f32x4_div( a, b ); }
+static inline vec4f mf_min( vec4f a, vec4f b )          { return wasm_f32x4_pmin( b, a ); }   // as SSE - b if either is NaN
+static inline vec4f mf_max( vec4f a, vec4f b )          { return wasm_f32x4_pmax( b, a ); }
+static inline vec4f mf_gt( vec4f a, vec4f b )           { return wasm_f32x4_gt( a, b ); }
+static inline vec4f mf_select( vec4f mask, vec4f a, vec4f b ) { return wasm_v128_bitselect( a, b, mask ); }
+template< int i0, int i1, int i2, int i3 > static inline vec4f mf_shuffle( vec4f a, vec4f b ) { return wasm_i32x4_shuffle( a, b, i0, i1, i2 + 4, i3 + 4 ); }
+#endif
+
+// Interior of a tent filtered row - out[ x ] for x in [ x0, x1 ) from rows r0, r1, r2 below
+// (rows 2y - 1, 2y, 2y + 1). Every x in range must have columns 2x - 1 to 2x + 1 inside the rows.
+// Returns the first x not processed; caller finishes the row.
+template< class T > int mip_tent_row( T* out, const T* r0, const T* r1, const T* r2, int x0, int x1 ) { return x0; }
+
+// Interior of a box filtered row - out[ x ] for x in [ x0, x1 ) from rows r0, r1 below (rows 2y, 2y + 1)
+template< class T > int mip_box_row( T* out, const T* r0, const T* r1, int x0, int x1 ) { return x0; }
+
+#ifdef MIP_SIMD
+
+// Pixels p, p + 1 of three rows, vertically weighted 1 2 1
+static inline vec8s mv_tent_v( vec8s a, vec8s b, vec8s c ) { return mv_add( mv_add( a, c ), mv_sll( b, 1 ) ); }
+
+template<> inline int mip_tent_row( ucolor* out, const ucolor* r0, const ucolor* r1, const ucolor* r2, int x0, int x1 ) {
+    const vec8s round = mv_set1( 8 );
+    int x = x0;
+    for( ; x + 4 <= x1; x += 4 ) {
+        // nine columns 2x - 1 to 2x + 7 below, two to a register
+        int c = x * 2 - 1;
+        vec8s a0 = mv_load( r0 + c ), a1 = mv_load( r0 + c + 4 ), a2 = mv_load1( r0 + c + 8 );
+        vec8s b0 = mv_load( r1 + c ), b1 = mv_load( r1 + c + 4 ), b2 = mv_load1( r1 + c + 8 );
+        vec8s c0 = mv_load( r2 + c ), c1 = mv_load( r2 + c + 4 ), c2 = mv_load1( r2 + c + 8 );
+        vec8s v0 = mv_tent_v( mv_widen_lo( a0 ), mv_widen_lo( b0 ), mv_widen_lo( c0 ) );  // columns 0, 1
+        vec8s v1 = mv_tent_v( mv_widen_hi( a0 ), mv_widen_hi( b0 ), mv_widen_hi( c0 ) );  // 2, 3
+        vec8s v2 = mv_tent_v( mv_widen_lo( a1 ), mv_widen_lo( b1 ), mv_widen_lo( c1 ) );  // 4, 5
+        vec8s v3 = mv_tent_v( mv_widen_hi( a1 ), mv_widen_hi( b1 ), mv_widen_hi( c1 ) );  // 6, 7
+        vec8s v4 = mv_tent_v( mv_widen_lo( a2 ), mv_widen_lo( b2 ), mv_widen_lo( c2 ) );  // 8
+        // horizontally weighted 1 2 1 around odd columns
+        vec8s s01 = mv_add( mv_add( mv_lo64( v0, v1 ), mv_lo64( v1, v2 ) ), mv_sll( mv_hi64( v0, v1 ), 1 ) );
+        vec8s s23 = mv_add( mv_add( mv_lo64( v2, v3 ), mv_lo64( v3, v4 ) ), mv_sll( mv_hi64( v2, v3 ), 1 ) );
+        s01 = mv_srl( mv_add( s01, round ), 4 );
+        s23 = mv_srl( mv_add( s23, round ), 4 );
+        mv_store( out + x, mv_or( mv_narrow( s01, s23 ), mv_alpha() ) );
+    }
+    return x;
+}
+
+template<> inline int mip_box_row( ucolor* out, const ucolor* r0, const ucolor* r1, int x0, int x1 ) {
+    const vec8s round = mv_set1( 1 );
+    int x = x0;
+    for( ; x + 4 <= x1; x += 4 ) {
+        int c = x * 2;
+        vec8s a0 = mv_load( r0 + c ), a1 = mv_load( r0 + c + 4 );
+        vec8s b0 = mv_load( r1 + c ), b1 = mv_load( r1 + c + 4 );
+        vec8s v0 = mv_add( mv_widen_lo( a0 ), mv_widen_lo( b0 ) );
+        vec8s v1 = mv_add( mv_widen_hi( a0 ), mv_widen_hi( b0 ) );
+        vec8s v2 = mv_add( mv_widen_lo( a1 ), mv_widen_lo( b1 ) );
+        vec8s v3 = mv_add( mv_widen_hi( a1 ), mv_widen_hi( b1 ) );
+        vec8s s01 = mv_srl( mv_add( mv_add( mv_lo64( v0, v1 ), mv_hi64( v0, v1 ) ), round ), 2 );
+        vec8s s23 = mv_srl( mv_add( mv_add( mv_lo64( v2, v3 ), mv_hi64( v2, v3 ) ), round ), 2 );
+        mv_store( out + x, mv_or( mv_narrow( s01, s23 ), mv_alpha() ) );
+    }
+    return x;
+}
+
+// frgb rows as floats. Each step reads one float past pixel 2x + 1 and writes one past out[ x ],
+// so the last pixel of the range is left to the caller.
+template<> inline int mip_tent_row( frgb* out, const frgb* r0, const frgb* r1, const frgb* r2, int x0, int x1 ) {
+    const float* f0 = &r0[ 0 ].x;
+    const float* f1 = &r1[ 0 ].x;
+    const float* f2 = &r2[ 0 ].x;
+    float* o = &out[ 0 ].x;
+    const vec4f two = mf_set1( 2.0f ), sixteenth = mf_set1( 1.0f / 16.0f );
+    auto col = [ & ]( int c ) { return mf_add( mf_add( mf_load( f0 + c ), mf_load( f2 + c ) ), mf_mul( mf_load( f1 + c ), two ) ); };
+    int x = x0;
+    for( ; x < x1 - 1; x++ ) {
+        int c = x * 6;
+        vec4f s = mf_add( mf_add( col( c - 3 ), col( c + 3 ) ), mf_mul( col( c ), two ) );
+        mf_store( o + x * 3, mf_mul( s, sixteenth ) );
+    }
+    return x;
+}
+
+template<> inline int mip_box_row( frgb* out, const frgb* r0, const frgb* r1, int x0, int x1 ) {
+    const float* f0 = &r0[ 0 ].x;
+    const float* f1 = &r1[ 0 ].x;
+    float* o = &out[ 0 ].x;
+    const vec4f quarter = mf_set1( 0.25f );
+    int x = x0;
+    for( ; x < x1 - 1; x++ ) {
+        int c = x * 6;
+        vec4f s = mf_add( mf_add( mf_load( f0 + c ), mf_load( f0 + c + 3 ) ), mf_add( mf_load( f1 + c ), mf_load( f1 + c + 3 ) ) );
+        mf_store( o + x * 3, mf_mul( s, quarter ) );
+    }
+    return x;
+}
+
+#endif // MIP_SIMD
+
+#endif // __MIP_SIMD_HPP
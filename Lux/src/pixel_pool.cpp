@@ -0,0 +1,98 @@
+#include "pixel_pool.hpp"
+#include <bit>
+
+pixel_pool::pixel_pool() : cache_limit( (size_t)256 << 20 ), counts{ 0, 0, 0, 0 } {
+    free_lists.fill( nullptr );
+}
+
+pixel_pool& pixel_pool::get() {
+    static pixel_pool* pool = new pixel_pool;
+    return *pool;
+}
+
+// 64 bytes and under share class 0. Above that 2^k < bytes <= 2^(k+1) falls in one of
+// 2^k + q * 2^(k-2) for q = 1..4
+int pixel_pool::size_class( size_t bytes ) {
+    if( bytes <= 64 ) return 0;
+    int k = (int)std::bit_width( bytes - 1 ) - 1;
+    size_t step = (size_t)1 << ( k - 2 );
+    size_t q = ( bytes - ( (size_t)1 << k ) + step - 1 ) / step;
+    return ( k - 6 ) * 4 + (int)q;
+}
+
+size_t pixel_pool::class_bytes( int c ) {
+    int k = c / 4 + 6;
+    return ( (size_t)1 << k ) + (size_t)( c % 4 ) * ( (size_t)1 << ( k - 2 ) );
+}
+
+void* pixel_pool::allocate( size_t bytes ) {
+    int c = size_class( bytes );
+    size_t size = class_bytes( c );
+    {
+        std::lock_guard< std::mutex > lock( m );
+        counts.bytes_live += size;
+        if( free_block* b = free_lists[ c ] ) {
+            free_lists[ c ] = b->next;
+            counts.bytes_cached -= size;
+            counts.hits++;
+            return b;
+        }
+        counts.misses++;
+    }
+    try { return ::operator new( size, alignment ); }
+    catch( ... ) {
+        std::lock_guard< std::mutex > lock( m );
+        counts.bytes_live -= size;
+        throw;
+    }
+}
+
+void pixel_pool::deallocate( void* p, size_t bytes ) noexcept {
+    if( !p ) return;
+    int c = size_class( bytes );
+    size_t size = class_bytes( c );
+    {
+        std::lock_guard< std::mutex > lock( m );
+        counts.bytes_live -= size;
+        if( counts.bytes_cached + size <= cache_limit ) {
+            free_block* b = static_cast< free_block* >( p );
+            b->next = free_lists[ c ];
+            free_lists[ c ] = b;
+            counts.bytes_cached += size;
+            return;
+        }
+    }
+    ::operator delete( p, alignment );
+}
+
+pixel_pool_stats pixel_pool::stats() {
+    std::lock_guard< std::mutex > lock( m );
+    return counts;
+}
+
+void pixel_pool::reset_stats() {
+    std::lock_guard< std::mutex > lock( m );
+    counts.hits = 0;
+    counts.misses = 0;
+}
+
+void pixel_pool::set_cache_limit( size_t bytes ) {
+    {
+        std::lock_guard< std::mutex > lock( m );
+        cache_limit = bytes;
+    }
+    trim( bytes );
+}
+
+// Largest blocks go first
+void pixel_pool::trim( size_t keep ) {
+    std::lock_guard< std::mutex > lock( m );
+    for( int c = classes - 1; c >= 0 && counts.bytes_cached > keep; c-- ) {
+        while( free_lists[ c ] && counts.bytes_cached > keep ) {
+            free_block* b = free_lists[ c ];
+            free_lists[ c ] = b->next;
+            counts.bytes_cached -= class_bytes( c );
+            ::operator delete( b, alignment );
+        }
+    }
+}
@@ -0,0 +1,53 @@
+// Recycled blocks of pixel memory for image storage
+// Effects make and drop full-frame images every frame - temporaries, back buffers, copies of sources.
+// A freed block goes on the free list for its size class and the next request of that class takes
+// it back without touching the heap. Classes run four to each power of two, so a block is at most
+// a quarter larger than asked for. Free blocks link through their own first bytes - recycling
+// needs no bookkeeping memory. Blocks are 64-byte aligned. Past the cache limit freed blocks go
+// straight back to the heap.
+
+#ifndef __PIXEL_POOL_HPP
+#define __PIXEL_POOL_HPP
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+struct pixel_pool_stats {
+    size_t hits;          // requests served from a free list
+    size_t misses;        // requests that went to the heap
+    size_t bytes_live;    // handed out and not yet returned
+    size_t bytes_cached;  // waiting on free lists
+};
+
+class pixel_pool {
+    static constexpr int classes = 4 * 64;
+
+    struct free_block { free_block* next; };
+
+    std::mutex m;
+    std::array< free_block*, classes > free_lists;
+    size_t cache_limit;
+    pixel_pool_stats counts;
+
+    pixel_pool();
+
+public:
+    static constexpr std::align_val_t alignment{ 64 };
+
+    static pixel_pool& get();     // shared pool, never destroyed so images in statics can outlive callers
+
+    static int    size_class( size_t bytes );   // smallest class holding bytes
+    static size_t class_bytes( int c );         // size of blocks in class c
+
+    void* allocate( size_t bytes );
+    void deallocate( void* p, size_t bytes ) noexcept;   // bytes as passed to allocate()
+
+    pixel_pool_stats stats();
+    void reset_stats();                         // zero hits and misses
+    void set_cache_limit( size_t bytes );       // default 256 MB - trims down to it
+    void trim( size_t keep = 0 );               // returns cached blocks to the heap until keep bytes remain
+};
+
+#endif // __PIXEL_POOL_HPP
@@ -144,8 +144,9 @@ struct PosterizeLUT {
 struct WeightedColor { ucolor c; uint32_t w; };
 
 // 32×32×32 RGB histogram → weighted samples (deterministic)
+template <class Pixels>  // any range of ucolor
 inline std::vector<WeightedColor>
-rgb32_histogram(const std::vector<ucolor>& img){
+rgb32_histogram(const Pixels& img){
     constexpr int B = 32, SH = 8 - 5; // 5 bits/chan
     std::vector<uint32_t> bins(B*B*B, 0);
     for (auto p : img) {
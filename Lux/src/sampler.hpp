@@ -0,0 +1,86 @@
+// Image samplers with the edge mode and filter fixed at compile time
+// sampler< T, extend, bilinear > reads the base level of an image as image::index() and image::sample()
+// do, without re-evaluating the extend mode for every tap. Bilinear fetches whose 2x2 footprint
+// lies inside the image read four pixels directly with no edge handling.
+// with_sampler() and with_extend() pick the specialization once per call site and pass it to a generic lambda.
+
+#ifndef __SAMPLER_HPP
+#define __SAMPLER_HPP
+
+#include "image.hpp"
+#include <cmath>
+#include <type_traits>
+
+// Position within an axis of n pixels for coordinate i, repeated or reflected in blocks of n
+template< image_extend E > static inline int extend_coord( int i, int n ) {
+    int block = ( i >= 0 ) ? i / n : ( i + 1 ) / n - 1;   // rounds toward negative infinity
+    int j = i - block * n;
+    if constexpr( E == SAMP_REFLECT ) if( block & 1 ) j = n - 1 - j;
+    return j;
+}
+
+template< class T, image_extend E, bool bilinear > struct sampler {
+    const T* base;
+    int w, h;
+
+    sampler( const image< T >& img ) : base( img.get_base_ptr() ), w( img.get_dim().x ), h( img.get_dim().y ) {}
+
+    // pixel at integer coordinates - zero outside the image for SAMP_SINGLE
+    T at( int x, int y ) const {
+        if constexpr( E == SAMP_SINGLE ) {
+            if( (unsigned)x < (unsigned)w && (unsigned)y < (unsigned)h ) return base[ y * w + x ];
+            return T{};
+        }
+        else return base[ extend_coord< E >( y, h ) * w + extend_coord< E >( x, w ) ];
+    }
+
+    // x, y and its neighbours to the right, below and diagonally
+    void quad( int x, int y, T& p00, T& p10, T& p01, T& p11 ) const {
+        if( (unsigned)x < (unsigned)( w - 1 ) && (unsigned)y < (unsigned)( h - 1 ) ) {
+            const T* p = base + y * w + x;
+            p00 = p[ 0 ]; p10 = p[ 1 ]; p01 = p[ w ]; p11 = p[ w + 1 ];
+        }
+        else {
+            p00 = at( x, y );     p10 = at( x + 1, y );
+            p01 = at( x, y + 1 ); p11 = at( x + 1, y + 1 );
+        }
+    }
+
+    // sample at floating point pixel coordinates
+    T operator () ( const vec2f& v ) const {
+        if constexpr( bilinear && std::is_same_v< T, ucolor > ) {
+            int xs = static_cast<int>(std::floor(v.x * 256.0f + 0.5f));
+            int ys = static_cast<int>(std::floor(v.y * 256.0f + 0.5f));
+            T p00, p10, p01, p11;
+            quad( xs >> 8, ys >> 8, p00, p10, p01, p11 );
+            return bilerp8( p00, p10, p01, p11, xs & 0xff, ys & 0xff );
+        }
+        else if constexpr( bilinear ) {
+            int x = static_cast<int>(std::floor(v.x));
+            int y = static_cast<int>(std::floor(v.y));
+            float x_frac = v.x - x;
+            float y_frac = v.y - y;
+            T p00, p10, p01, p11;
+            quad( x, y, p00, p10, p01, p11 );
+            return blendf( blendf( p00, p10, x_frac ), blendf( p01, p11, x_frac ), y_frac );
+        }
+        else return at( static_cast<int>(std::round(v.x)), static_cast<int>(std::round(v.y)) );
+    }
+};
+
+// Calls f( s ) with the sampler for this extend mode
+template< bool bilinear, class T, class F > inline decltype( auto ) with_extend( const image< T >& img, image_extend extend, F&& f ) {
+    switch( extend ) {
+        case SAMP_REPEAT:  return f( sampler< T, SAMP_REPEAT,  bilinear >( img ) );
+        case SAMP_REFLECT: return f( sampler< T, SAMP_REFLECT, bilinear >( img ) );
+        default:           return f( sampler< T, SAMP_SINGLE,  bilinear >( img ) );
+    }
+}
+
+// Calls f( s ) with the sampler for this extend mode and filter
+template< class T, class F > inline decltype( auto ) with_sampler( const image< T >& img, image_extend extend, bool bilinear, F&& f ) {
+    if( bilinear ) return with_extend< true  >( img, extend, f );
+    else           return with_extend< false >( img, extend, f );
+}
+
+#endif // __SAMPLER_HPP
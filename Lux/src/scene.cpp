@@ -6,6 +6,8 @@
 #include "warp_field.hpp"
 #include "offset_field.hpp"
 #include "scene_io.hpp"
+#include "life.hpp"
+#include "joy_log.hpp"
 #include <optional>
 #include <sstream>
 
@@ -41,11 +43,11 @@ template< class T > void splat_element( std::shared_ptr< buffer_pair< T > > targ
                     target_buf->get_image().splat( img_buf->get_image(), el.smooth, el.position, el.scale, th, mask, tint, el.mmode ); 
                 }
             }
-            else std::cout << "splat_element() - no image in buffer" << std::endl;
+            else JOY_LOG( JOY_DEBUG, LOG_SCENE, "splat_element() - no image in buffer" );
         }
-        else std::cout << "splat_element() - null image buffer" << std::endl;
+        else JOY_LOG( JOY_DEBUG, LOG_SCENE, "splat_element() - null image buffer" );
     }
-    else std::cout << "splat_element() - unmatched image buffer" << std::endl;
+    else JOY_LOG( JOY_DEBUG, LOG_SCENE, "splat_element() - unmatched image buffer" );
 }
 element_context::element_context( scene& s_init, any_buffer_pair_ptr& buf_init ) : el(default_element), cl(default_cluster), s(s_init), buf(buf_init) {}
 
@@ -99,7 +101,7 @@ void cluster::set_root( element& el ) {
 void effect_list::resize( vec2i new_dim ) {
     //if( new_dim == *dim ) return;
     // need to resize buffer (retaining data) instead?
-    std::cout << "effect_list " << name << " resize() " << new_dim.x << " " << new_dim.y << std::endl;
+    JOY_LOG( JOY_DEBUG, LOG_SCENE, "effect_list " << name << " resize() " << new_dim.x << " " << new_dim.y );
     std::visit( [&]( auto& b ) { b->reset( new_dim ); }, buf );
     dim = new_dim;       
 }
@@ -143,13 +145,13 @@ void effect_list::update( scene& s ) {
                     if( name == "Self" ) s.self_dim = source_dim;
                 }
 
-                // Copying here may be an unnecessary extra step - can we render directly from source buffer?
+                // Shares the source's pixels - copied only if an effect writes to the image
                 std::visit([&, source_buf](auto& b) {
                     //std :: cout << "effect_list " << name << " update() - copying source buffer " << *source_name << std::endl;
                     copy_buffer(b, source_buf);
                 }, buf);
             } else {
-                std::cout << "effect_list::update() - what happens here?" << std::endl;
+                JOY_LOG( JOY_DEBUG, LOG_SCENE, "effect_list::update() - what happens here?" );
             }
         }
     }
@@ -257,6 +259,35 @@ void scene::render() {
     time += time_interval;
 }
 
+// Same state as rendering nframes frames. If every animated buffer is iterative with a single
+// CA effect, each CA jumps ahead with CA::advance(), otherwise all frames are rendered
+void scene::skip_frames( int nframes ) {
+    if( nframes <= 0 ) return;
+    bool jump = true;
+    for( auto& eff_list : queue ) {
+        if( eff_list.rmode == MODE_STATIC ) continue;
+        if( eff_list.rmode != MODE_ITERATIVE || eff_list.effects.size() != 1 || !effects.contains( eff_list.effects[ 0 ] ) ||
+            !std::holds_alternative< std::shared_ptr< CA< ucolor > > >( effects[ eff_list.effects[ 0 ] ].fn_ptr ) ) jump = false;
+    }
+    if( !jump ) {
+        for( int frame = 0; frame < nframes; frame++ ) render();
+        return;
+    }
+    for( auto& eff_list : queue ) {
+        if( eff_list.rmode == MODE_STATIC ) eff_list.render( *this );
+        else {
+            eff_list.update( *this );
+            element default_element;
+            next_element default_next_element;
+            cluster default_cluster( default_element, default_next_element );
+            element_context context( default_element, default_cluster, *this, eff_list.buf );
+            std::get< std::shared_ptr< CA< ucolor > > >( effects[ eff_list.effects[ 0 ] ].fn_ptr )->advance( eff_list.buf, context, nframes );
+            eff_list.rendered = true;
+        }
+    }
+    time += time_interval * nframes;
+}
+
 void scene::save_result( 
     const std::string& filename, 
     const vec2i& dim,
@@ -283,7 +314,8 @@ void scene::render_and_save(
     const vec2i& dim,
     pixel_type ptype, 
     file_type ftype, 
-    int quality )
+    int quality,
+    int skip )
 { 
     //std::cout << "scene::render_and_save() dim = " << dim.x << " " << dim.y << std::endl;
     any_buffer_pair_ptr any_out;
@@ -296,6 +328,7 @@ void scene::render_and_save(
         case( PIXEL_VEC2I  ): any_out = std::make_shared< buffer_pair< vec2i >  >( dim ); break;
     }
     set_output_buffer( any_out ); // set output buffer
+    skip_frames( skip );
     render(); // render into image
     save_result( filename, dim, ptype, ftype, quality ); // save image
 } 
@@ -306,7 +339,8 @@ void scene::animate(
     vec2i dim,
     pixel_type ptype, 
     file_type ftype, 
-    int quality )
+    int quality,
+    int skip )
 {
     //std::cout << "scene::animate() dim = " << dim.x << " " << dim.y << std::endl;
 
@@ -321,13 +355,14 @@ void scene::animate(
     set_output_buffer( any_out ); // set output buffer
 
     time = 0.0f;
-    for( int frame = 0; frame < nframes; frame++ ) {
+    skip_frames( skip );
+    for( int frame = skip; frame < skip + nframes; frame++ ) {
         std::ostringstream s;
         s << basename << std::setfill('0') << std::setw(4) << frame << ".jpg";
         std::string filename = s.str();
         render();
         save_result( filename, dim, ptype, ftype, quality );
-        std::cout << "frame " << frame << " time " << time << std::endl;
+        JOY_LOG( JOY_INFO, LOG_SCENE, "frame " << frame << " time " << time );
     }
 
     // future: make the video file here 
@@ -340,7 +375,7 @@ void scene::set_output_buffer( any_buffer_pair_ptr& buf ) {
     output_list.ptype = ( pixel_type )buf.index();
     vec2i dim_out;
     std::visit( [&]( auto& b ) { dim_out = b->get_image().get_dim(); }, buf );
-    std::cout << "scene::set_output_buffer() dim_out " << dim_out.x << " " << dim_out.y << std::endl << std::endl;
+    JOY_LOG( JOY_DEBUG, LOG_SCENE, "scene::set_output_buffer() dim_out " << dim_out.x << " " << dim_out.y );
     self_dim = dim_out;
 
     for( int i = 0; i < queue.size() - 1; i++ ) {
@@ -290,6 +290,7 @@ struct scene {
     effect_list& get_effect_list( const std::string& name ); // get effect list by name
 
     void render();  // Render scene on any image type
+    void skip_frames( int nframes );  // Advance scene without rendering output
 
     void save_result(    
         const std::string& filename, 
@@ -305,7 +306,8 @@ struct scene {
         const vec2i& dim = { 512, 512 },
         pixel_type ptype = PIXEL_UCOLOR, 
         file_type ftype = FILE_JPG, 
-        int quality = 100 
+        int quality = 100,
+        int skip = 0        // frames to skip before rendering
     );          
 
     void animate( 
@@ -314,7 +316,8 @@ struct scene {
         vec2i dim = { 512, 512 },
         pixel_type ptype = PIXEL_UCOLOR, 
         file_type ftype = FILE_JPG, 
-        int quality = 100   
+        int quality = 100,
+        int skip = 0        // frames to skip before first saved frame
     );
 
 };
@@ -691,6 +691,7 @@ void scene_reader::read_effect( const json& j ) {
         HARNESSE( invert_target ) HARNESSE( target_color_angle );
         HARNESSE( p ) HARNESSE( edge_block ) HARNESSE( alpha_block ) 
         HARNESSE( bright_block ) HARNESSE( bright_range )
+        READE( seed )
     END_EFF()
 
     // special case for effects running effects
@@ -55,6 +55,17 @@ ucolor blend( const ucolor& a, const ucolor& b );
 ucolor blend( const ucolor& a, const ucolor& b, const ucolor& c, const ucolor& d );
 ucolor blend( const std::vector< ucolor >& colors );
 
+// Average of two colors, rounding up if random_bit is set
+// Caller supplies the bit, so threads can draw from their own random stream
+static inline ucolor blend_round( const ucolor& a, const ucolor& b, const unsigned int& random_bit )
+{
+    return
+    ( ( ( ( a & 0x00ff0000 ) + ( b & 0x00ff0000 ) + 0x00010000 * random_bit ) >> 1 ) & 0x00ff0000 ) + 
+    ( ( ( ( a & 0x0000ff00 ) + ( b & 0x0000ff00 ) + 0x00000100 * random_bit ) >> 1 ) & 0x0000ff00 ) +
+    ( ( ( ( a & 0x000000ff ) + ( b & 0x000000ff ) + 0x00000001 * random_bit ) >> 1 ) & 0x000000ff ) +
+    0xff000000;
+}
+
 // proportion 0-256 -> 0-100%
 static inline ucolor blend( const ucolor& a, const ucolor& b, const unsigned int& prop )
 {
@@ -73,6 +84,21 @@ static inline ucolor blend( const ucolor& a, const ucolor& b, const unsigned int
 static inline ucolor blendf(  const ucolor& a, const ucolor& b, const float& prop ) 
 { return blend( a, b, (unsigned int)( prop * 256.0f ) ); }
 
+// t 0-256 of the way from a to b, rounded - all four channels including alpha.
+// Channels are blended in pairs, red with blue and green with alpha, each pair in one 32 bit multiply
+static inline ucolor lerp8( const ucolor& a, const ucolor& b, const unsigned int& t )
+{
+    unsigned int it = 256 - t;
+    unsigned int rb = ( ( a & 0x00ff00ff ) * it + ( b & 0x00ff00ff ) * t + 0x00800080 ) >> 8;
+    unsigned int ga = ( ( a >> 8 ) & 0x00ff00ff ) * it + ( ( b >> 8 ) & 0x00ff00ff ) * t + 0x00800080;
+    return ( rb & 0x00ff00ff ) | ( ga & 0xff00ff00 );
+}
+
+// Bilinear blend of pixels x, y (p00), to the right (p10), below (p01) and diagonally (p11)
+// with 8 bit fractions tx, ty
+static inline ucolor bilerp8( const ucolor& p00, const ucolor& p10, const ucolor& p01, const ucolor& p11, const unsigned int& tx, const unsigned int& ty )
+{ return lerp8( lerp8( p00, p10, tx ), lerp8( p01, p11, tx ), ty ); }
+
 
 inline unsigned long luminance( const ucolor& in ) {
     return( ( (   shift_right_2( in ) + shift_right_4( in ) ) +            // r * 5/16
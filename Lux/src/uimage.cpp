@@ -1,6 +1,7 @@
 #include "uimage.hpp"
 #include <memory>
 #include "image_loader.hpp"
+#include "hsv_lut.hpp"
 
 
 // pixel modification functions
@@ -23,14 +24,12 @@ template<> void uimage::rotate_components( const int& r ) {
 }
 
 template<> void uimage::rgb_to_hsv() {
-    for( auto& level : mip ) {
-        for( auto& c : level ) { c = ::rgb_to_hsv( c ); }
-    }
+    for( auto& level : mip ) rgb_to_hsv_span( level.data(), level.data(), level.size() );
 }
 
 template<> void uimage::hsv_to_rgb() {
     auto& base = mip[ 0 ];
-    for( auto& c : base ) { c = ::hsv_to_rgb( c ); }
+    hsv_to_rgb_span( base.data(), base.data(), base.size() );
     mip_utd = false;
 }
 
@@ -57,8 +56,9 @@ template<> void uimage::load( const std::string& filename ) {
     refresh_bounds();
     //std::cout << "uimage::load: " << filename << " " << loader.xsiz << " " << loader.ysiz << " " << loader.channels << std::endl;
     ucolor f = 0xff000000;
+    mip.resize( dim );
     auto& base = mip[0];
-    base.reserve( dim.x * dim.y );
+    size_t i = 0;
 
 //    int size = loader.xsiz * loader.ysiz;
 //    auto it = std::begin( loader.img );
@@ -97,7 +97,7 @@ template<> void uimage::load( const std::string& filename ) {
         }
 
         // skip alpha channel - rgba ... if argb need to move line up
-        base.push_back( f );
+        base[ i++ ] = f;
     }
     // default mip mapping for testing - future: set use_mip from scene file
     //use_mip(true);
@@ -107,44 +107,40 @@ template<> void uimage::load( const std::string& filename ) {
 template<> void uimage::write_jpg( const std::string& filename, int quality, int level ) {
     std::vector< unsigned char > carray;
     carray.reserve( dim.x * dim.y * 3 );
-    auto& pixels = mip[ level ];
+    const auto& pixels = std::as_const( mip )[ level ];
     for( auto& f : pixels ) {
         carray.push_back( bc( f ) );
         carray.push_back( gc( f ) );
         carray.push_back( rc( f ) ); 
     }
-	wrapped_write_jpg( filename.c_str(), mip_dim[level].x, mip_dim[level].y, 3, carray.data(), quality );
+	wrapped_write_jpg( filename.c_str(), mip.dim( level ).x, mip.dim( level ).y, 3, carray.data(), quality );
 }
 
 template<> void uimage::write_png( const std::string& filename, int level ) {
-    auto& pixels = mip[ level ];
-	wrapped_write_png( filename.c_str(), mip_dim[level].x, mip_dim[level].y, 4, (unsigned char *)pixels.data() );
+    const auto& pixels = std::as_const( mip )[ level ];
+	wrapped_write_png( filename.c_str(), mip.dim( level ).x, mip.dim( level ).y, 4, (unsigned char *)pixels.data() );
 }
 
-// Fixed point version of sample
+// Fixed point version of sample - 8 bit fractions, channels blended in pairs
+// lo and hi read pixels of levels mip_level and mip_level + 1 by coordinates
+// mip_blend is the weight of the lower level
+template< class V > static inline ucolor sample_levels( const V& lo, const V& hi, const unsigned int& mip_level, const unsigned int& mip_blend, const vec2i& vi ) {
+    int xl = vi.x >> ( 16 + mip_level     ), yl = vi.y >> ( 16 + mip_level     );
+    int xu = vi.x >> ( 16 + mip_level + 1 ), yu = vi.y >> ( 16 + mip_level + 1 );
+    ucolor l00, l10, l01, l11, u00, u10, u01, u11;
+    lo.quad( xl, yl, l00, l10, l01, l11 );
+    hi.quad( xu, yu, u00, u10, u01, u11 );
+    ucolor l = bilerp8( l00, l10, l01, l11, ( vi.x >> ( 8 + mip_level     ) ) & 0xff, ( vi.y >> ( 8 + mip_level     ) ) & 0xff );
+    ucolor u = bilerp8( u00, u10, u01, u11, ( vi.x >> ( 8 + mip_level + 1 ) ) & 0xff, ( vi.y >> ( 8 + mip_level + 1 ) ) & 0xff );
+    return lerp8( u, l, mip_blend >> 8 );
+}
 
 template<> const ucolor image< ucolor >::sample ( const unsigned int& mip_level, const unsigned int& mip_blend, const vec2i& vi ) const  {
     //std::cout << "sample ucolor" << std::endl;
-    //std::cout << "mip_dim.size = " << mip_dim.size() << std::endl;
-    int l_index = ( vi.x >> ( 16 + mip_level     ) ) + ( vi.y >> ( 16 + mip_level     ) ) * mip_dim[ mip_level     ].x;
-    int u_index = ( vi.x >> ( 16 + mip_level + 1 ) ) + ( vi.y >> ( 16 + mip_level + 1 ) ) * mip_dim[ mip_level + 1 ].x;
-    //std::cout << "uimage sample - l_index: " << l_index << " u_index: " << u_index << std::endl;
-    return  blend(
-                blend(
-                    blend( mip[ mip_level ][ l_index + mip_dim[ mip_level ].x + 1 ], mip[ mip_level ][ l_index + mip_dim[ mip_level ].x ], ( vi.x >> ( 8 + mip_level ) ) & 0xff ),
-                    blend( mip[ mip_level ][ l_index                          + 1 ], mip[ mip_level ][ l_index                          ], ( vi.x >> ( 8 + mip_level ) ) & 0xff ),
-                    ( vi.y >> ( 8 + mip_level ) ) & 0xff 
-                ),
-                blend(
-                    blend( mip[ mip_level + 1 ][ u_index + mip_dim[ mip_level + 1 ].x + 1 ], mip[ mip_level + 1 ][ u_index + mip_dim[ mip_level + 1 ].x ], ( vi.x >> ( 8 + mip_level + 1 ) ) & 0xff ),
-                    blend( mip[ mip_level + 1 ][ u_index                              + 1 ], mip[ mip_level + 1 ][ u_index ],                              ( vi.x >> ( 8 + mip_level + 1 ) ) & 0xff ),
-                    0xff - ( vi.y >> ( 8 + mip_level + 1 ) ) & 0xff 
-                ),
-                mip_blend >> 8
-            );
+    return sample_levels( mip.texels( mip_level ), mip.texels( mip_level + 1 ), mip_level, mip_blend, vi );
 }
 
 template<> void uimage::dump() {
-    auto& base = mip[ 0 ];
+    const auto& base = std::as_const( mip )[ 0 ];
     for( auto& v : base ) { std::cout << std::hex << v; }
 }
@@ -1,6 +1,7 @@
 #include "linalg.h"
 #include "vect2.hpp"
 #include "vector_field.hpp"
+#include "image_expr.hpp"
 #include <cmath>
 
 vec2f vortex::operator () ( const vec2f& v, const float& t ) {
@@ -183,23 +184,27 @@ void vf_tools::complex_power( const float& p, const vec2f& c, float scale ) {
     img.mip_utd = false;
 }
 
-void vf_tools::vortex( const ::vortex& vort, const float& t ) {
+void vf_tools::vortex_shape( const ::vortex& vort, const float& t ) {
     vec2f center= vort.center_orig;
     if( vort.revolving ) center = vort.center_of_revolution + linalg::rot( vort.velocity * t * TAU, vort.center_orig - vort.center_of_revolution );
     rotation( center );
     inverse( vort.diameter, vort.soften );
-    img *= vort.intensity;
     img.mip_utd = false;
 }
 
+void vf_tools::vortex( const ::vortex& vort, const float& t ) {
+    vortex_shape( vort, t );
+    img *= vort.intensity;
+}
+
 void vf_tools::turbulent( vortex_field& ca, const float& t ) {
     //if( !(ca.generated) ) ca.generate();
     img.fill( { 0.0f, 0.0f } );
     vector_field buffer( img );
     vf_tools buffer_tools( buffer );
 
-    // cavort cavort cavort
-    for( auto& vort : ca.vorts ) { buffer_tools.vortex( vort ); img += buffer; }
+    // cavort cavort cavort - scaled and accumulated in one pass
+    for( auto& vort : ca.vorts ) { buffer_tools.vortex_shape( vort ); img = img + buffer * vort.intensity; }
     img.mip_utd = false;
 }
 
@@ -109,6 +109,7 @@ public:
     void fermat_spiral(const float& c);
     void complex_power( const float& p, const vec2f& c = { 0.0f, 0.0f }, float scale = 1.0f );
 
+    void vortex_shape( const ::vortex& vort, const float& t = 0.0f );   // vortex at unit intensity
     void vortex( const ::vortex& vort, const float& t = 0.0f );
     void turbulent( vortex_field& f,  const float& t = 0.0f );
 
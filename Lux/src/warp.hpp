@@ -3,6 +3,7 @@
 
 #include "effect.hpp"
 #include "vector_field.hpp"
+#include "sampler.hpp"
 
 // Melts by iteratively running effect function
 // Remembers its current state- owning buffer pair
@@ -35,16 +36,13 @@ template< class T > struct vector_melt {
          // run function for each point in vector field and integrate
         // std::cout << "vector_melt dim.x  " << vf.get_dim().x << "\n";
         auto vfit = vf.begin(); 
-        vec2f coord;
-        bb2f vf_bounds;
-        bb2i vf_ip_bounds;
+        std::vector< float > cx, cy;
+        vf.coord_tables( cx, cy );
+        sampler< vec2f, SAMP_REPEAT, true > drive( driver );
         for( int y = 0; y < vf.get_dim().y; y++ ) {
             for( int x = 0; x < vf.get_dim().x; x++ ) {
-                vf_bounds = vf.get_bounds();
-                vf_ip_bounds = vf.get_ipbounds();
-                auto vxy = vec2f{x, y};
-                coord = vf_bounds.bb_map( vxy, vf_ip_bounds );
-                *vfit += step * driver.sample( coord + *vfit, true, SAMP_REPEAT );
+                vec2f coord( cx[ x ], cy[ y ] );
+                *vfit += step * drive( coord + *vfit );
                 vfit++;
             }
         } 